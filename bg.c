@@ -2,6 +2,7 @@
 #include <sega_scl.h>
 #include <string.h>
 
+#include "bg.h"
 #include "cd.h"
 #include "hwram.h"
 #include "print.h"
@@ -16,11 +17,21 @@ static int bgLengths[BG_COUNT];
 static SclRgb black;
 static SclRgb normal;
 
+// background on screen
+static int shownBG;
+// background in HWRAM_Buffer (or being buffered)
 static int currBG;
+// background we want to end up on
+static int targetBG;
+// the bgs from here on use the 128x128px repeating tilemap
+#define TILEMAP128_BG (5)
 
 static Uint8 *chrVram = (Uint8 *)SCL_VDP2_VRAM_B0;
 static Uint16 *mapVram = (Uint16 *)SCL_VDP2_VRAM_B1;
 
+// one tile per 16x16px screen cell
+static Uint16 tileMapScreen[32 * 32];
+// 128x128px repeating tilemap
 static Uint16 tileMap128[32 * 32];
 
 typedef enum {
@@ -42,12 +53,25 @@ static int copyOffset;
 static int frames;
 
 
-void BG_Init() {
-    // reset position
+static void BG_ResetPosition() {
     SCL_Open(SCL_RBG_TB_A);
     SCL_MoveTo(0, 0, 0);
     SCL_RotateTo(0, 0, 0, SCL_X_AXIS);
     SCL_Close();
+}
+
+// copies the tilemap the given bg uses to VRAM
+static void BG_LoadMap(int bg) {
+    if (bg >= TILEMAP128_BG) {
+        DMA_ScuMemCopy(mapVram, tileMap128, sizeof(tileMap128));
+    }
+    else {
+        DMA_ScuMemCopy(mapVram, tileMapScreen, sizeof(tileMapScreen));
+    }
+}
+
+void BG_Init() {
+    BG_ResetPosition();
 
     black.red = -255; black.green = -255; black.blue = -255;
     normal.red = 0; normal.green = 0; normal.blue = 0;
@@ -71,22 +95,22 @@ void BG_Init() {
     // copy the first background to the screen
     Scroll_LoadTile(bgAddrs[0], chrVram, SCL_RBG0, 0);
 
-    // set up the tilemap
+    // set up the tilemaps
     int counter = 0;
     
     for (int y = 0; y < (224 / 16); y++) {
         for (int x = 0; x < (320 / 16); x++) {
-            mapVram[(y * 32) + x] = counter * 2;
+            tileMapScreen[(y * 32) + x] = counter * 2;
             counter++;
         }
     }
 
-    // 128x128px repeating tilemap
     for (int y = 0; y < 32; y++) {
         for (int x = 0; x < 32; x++) {
             tileMap128[x + (32 * y)] = ((x % 8) + ((y % 8) * 8)) * 2;
         }
     }
+    BG_LoadMap(0);
 
     
     // fade in bg
@@ -95,10 +119,28 @@ void BG_Init() {
     // initialize the state
     bgState = STATE_BUFFER;
     copyCursor = 0;
+    shownBG = 0;
     currBG = 1;
+    targetBG = 0;
+}
+
+// starts the fade to the buffered bg if it's the one we want
+static void BG_StartFade() {
+    if ((targetBG > shownBG) && (currBG == targetBG)) {
+        frames = 0;
+        SCL_SetAutoColOffset(SCL_OFFSET_B, 1, FADE_FRAMES, &normal, &black);
+        bgState = STATE_FADEOUT;
+    }
 }
 
 void BG_Run() {
+    // if we skipped past the bg that's being buffered, buffer the one we want instead
+    if (((bgState == STATE_BUFFER) || (bgState == STATE_NONE)) && (currBG < targetBG)) {
+        currBG = targetBG;
+        copyCursor = 0;
+        bgState = STATE_BUFFER;
+    }
+
     switch (bgState) {
         case STATE_BUFFER:
             //Print_String("BUFF", 0, 0);
@@ -107,6 +149,7 @@ void BG_Run() {
             if (copyCursor >= bgLengths[currBG]) {
                 copyCursor = 0;
                 bgState = STATE_NONE;
+                BG_StartFade();
             }
             break;
 
@@ -120,8 +163,8 @@ void BG_Run() {
                 bgState = STATE_COPY;
 
                 // copy new tilemap if necessary
-                if (currBG == 5) {
-                    DMA_ScuMemCopy(mapVram, tileMap128, sizeof(tileMap128));
+                if ((currBG >= TILEMAP128_BG) && (shownBG < TILEMAP128_BG)) {
+                    BG_LoadMap(currBG);
                 }
             }
             break;
@@ -135,6 +178,7 @@ void BG_Run() {
                 Scroll_LoadTile(HWRAM_Buffer, NULL, SCL_RBG0, 0);
                 // fade in bg
                 SCL_SetAutoColOffset(SCL_OFFSET_B, 1, FADE_FRAMES, &black, &normal);
+                shownBG = currBG;
                 currBG++;
                 copyCursor = 0;
                 if (currBG < BG_COUNT) {
@@ -148,16 +192,17 @@ void BG_Run() {
 
         case STATE_NONE:
             //Print_String("NONE", 0, 0);
+            BG_StartFade();
             break;
     }
     
-    if (currBG == 6) {
+    if (shownBG == 5) {
         SCL_Open(SCL_RBG_TB_A);
         SCL_Move(MTH_FIXED(0.5), MTH_FIXED(0.5), 0);
         SCL_Close();
     }
 
-    else if (currBG == 7) {
+    else if (shownBG == 6) {
         frames++;
         SCL_Open(SCL_RBG_TB_A);
         SCL_Move(MTH_FIXED(0.5), MTH_FIXED(0.5), 0);
@@ -171,9 +216,37 @@ void BG_Run() {
     }
 }
 
-void BG_Next() {
-    frames = 0;
-    SCL_SetAutoColOffset(SCL_OFFSET_B, 1, FADE_FRAMES, &normal, &black);
-    bgState = STATE_FADEOUT;
+void BG_Goto(int bg) {
+    if (bg >= BG_COUNT) {
+        bg = BG_COUNT - 1;
+    }
+    if (bg > targetBG) {
+        targetBG = bg;
+    }
 }
 
+void BG_Set(int bg) {
+    if (bg >= BG_COUNT) {
+        bg = BG_COUNT - 1;
+    }
+    if ((bg == shownBG) && (bg == targetBG)) {
+        return;
+    }
+
+    // all the bgs are still in LWRAM, so this can go straight to VRAM
+    int size;
+    Uint8 *tiles = (Uint8 *)Scroll_TilePtr(bgAddrs[bg], &size);
+    Scroll_LoadTile(bgAddrs[bg], NULL, SCL_RBG0, 0);
+    memcpy(chrVram, tiles, size);
+    BG_LoadMap(bg);
+    BG_ResetPosition();
+    // cancel any fade that was going on
+    SCL_SetAutoColOffset(SCL_OFFSET_B, 1, 1, &normal, &normal);
+
+    shownBG = bg;
+    targetBG = bg;
+    currBG = bg + 1;
+    copyCursor = 0;
+    frames = 0;
+    bgState = (currBG < BG_COUNT) ? STATE_BUFFER : STATE_NONE;
+}
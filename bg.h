@@ -7,8 +7,13 @@ void BG_Init();
 // should be run every gameplay frame
 void BG_Run();
 
-// run to advance to the next BG
-void BG_Next();
+// advances to the given BG, skipping any in between (does nothing if we're
+// already past it)
+void BG_Goto(int bg);
+
+// switches to the given BG right away (takes under a frame, used when
+// rewinding)
+void BG_Set(int bg);
 
 #endif
 
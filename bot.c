@@ -0,0 +1,479 @@
+// plays the game on its own. when a piece spawns, every position it can get
+// to is found with a breadth first search over x, y and rotation (using the
+// game's own collision and kicks), and each one it can lock in is scored by
+// the board it leaves, optionally after also placing the next piece. the bot
+// then presses the buttons for the moves on the way there, one per tick
+
+#include <string.h>
+
+#include "bot.h"
+#include "game.h"
+#include "piece.h"
+#include "rotate.h"
+#include "speed.h"
+#include "vblank.h"
+
+typedef enum {
+    BOT_WAIT = 0, // no piece to move
+    BOT_SCORE, // scoring where the piece can go
+    BOT_FOLLOW, // moving the piece to the target
+} BOT_PHASES;
+
+typedef enum {
+    MOVE_LEFT = 0,
+    MOVE_RIGHT,
+    MOVE_CW,
+    MOVE_CCW,
+    MOVE_DOWN,
+    MOVE_COUNT,
+} BOT_MOVES;
+
+static const Uint16 moveButtons[MOVE_COUNT] = {PAD_L, PAD_R, PAD_C, PAD_B, PAD_D};
+
+// tuned with host/montecarlo -b, most games get to the end
+const BOT_WEIGHTS botDefaultWeights = {
+    .lines = 40,
+    .holes = -250,
+    .height = -40,
+    .bumpiness = -30,
+    .wells = -40,
+    .maxHeight = 0,
+};
+
+#define BOT_WORST ((Sint32)0x80000000)
+// searches allowed for one piece before the bot gives up and drops it
+#define MAX_REPLANS (8)
+
+#define COL_MASK ((1 << GAME_COLS) - 1)
+// number of set bits in each row of columns. it's built at compile time, so
+// bots on different threads can share it
+#define BITS_2(n) (n), (n) + 1, (n) + 1, (n) + 2
+#define BITS_4(n) BITS_2(n), BITS_2((n) + 1), BITS_2((n) + 1), BITS_2((n) + 2)
+#define BITS_6(n) BITS_4(n), BITS_4((n) + 1), BITS_4((n) + 1), BITS_4((n) + 2)
+#define BITS_8(n) BITS_6(n), BITS_6((n) + 1), BITS_6((n) + 1), BITS_6((n) + 2)
+#define BITS_10(n) BITS_8(n), BITS_8((n) + 1), BITS_8((n) + 1), BITS_8((n) + 2)
+static const Uint8 bitCounts[1 << GAME_COLS] = {BITS_10(0)};
+_Static_assert(GAME_COLS == 10, "bitCounts is built for 10 columns");
+
+void Bot_Init(BOT *bot, const BOT_WEIGHTS *weights, int budget) {
+    bot->weights = *weights;
+    bot->budget = budget;
+    bot->lookahead = 1;
+    bot->pieces = 0;
+    bot->phase = BOT_WAIT;
+    bot->replans = 0;
+    bot->held = 0;
+}
+
+static inline int Bot_Index(PIECE *piece) {
+    return (((piece->rotation * BOT_YS) + (piece->y - BOT_MIN_Y)) * BOT_XS) + (piece->x - BOT_MIN_X);
+}
+
+static inline int Bot_InRange(PIECE *piece) {
+    return (piece->x >= BOT_MIN_X) && (piece->x < GAME_COLS) && (piece->y >= BOT_MIN_Y) && (piece->y < GAME_ROWS);
+}
+
+static void Bot_Position(int index, int num, PIECE *piece) {
+    piece->num = num;
+    piece->x = (index % BOT_XS) + BOT_MIN_X;
+    index /= BOT_XS;
+    piece->y = (index % BOT_YS) + BOT_MIN_Y;
+    piece->rotation = index / BOT_YS;
+}
+
+// returns 1 if the piece is on the ground or another piece
+static int Bot_Grounded(GAME_CTX *ctx, PIECE *piece) {
+    PIECE below = *piece;
+    below.y++;
+    return !Game_CheckPiece(ctx, &below);
+}
+
+// moves the piece down as far as it goes (ctx's colTops aren't kept up to
+// date for the scratch game, so this can't use Game_DropDistance)
+static void Bot_Drop(GAME_CTX *ctx, PIECE *piece) {
+    while (!Bot_Grounded(ctx, piece)) {
+        piece->y++;
+    }
+}
+
+// finds every position the piece can get to from start, and the ones it can
+// lock in
+static void Bot_Search(BOT *bot, GAME_CTX *ctx, PIECE *start) {
+    int head = 0;
+    int tail = 0;
+
+    memset(bot->parents, 0xFF, sizeof(bot->parents));
+    bot->placementCount = 0;
+
+    int first = Bot_Index(start);
+    bot->parents[first] = first;
+    bot->queue[tail++] = first;
+
+    while (head < tail) {
+        int index = bot->queue[head++];
+        PIECE piece;
+        Bot_Position(index, start->num, &piece);
+        int grounded = Bot_Grounded(ctx, &piece);
+        if (grounded && (bot->placementCount < BOT_MAX_PLACEMENTS)) {
+            bot->placements[bot->placementCount++] = index;
+        }
+
+        for (int move = 0; move < MOVE_COUNT; move++) {
+            PIECE next = piece;
+            switch (move) {
+                case MOVE_LEFT:
+                    next.x--;
+                    break;
+
+                case MOVE_RIGHT:
+                    next.x++;
+                    break;
+
+                case MOVE_CW:
+                    if (!Game_Rotate(ctx, &next, ROTATE_CLOCKWISE)) {
+                        continue;
+                    }
+                    break;
+
+                case MOVE_CCW:
+                    if (!Game_Rotate(ctx, &next, ROTATE_COUNTERCLOCKWISE)) {
+                        continue;
+                    }
+                    break;
+
+                case MOVE_DOWN:
+                    if (grounded || bot->sonic) {
+                        continue;
+                    }
+                    next.y++;
+                    break;
+            }
+            if (!Bot_InRange(&next) || !Game_CheckPiece(ctx, &next)) {
+                continue;
+            }
+            if (bot->sonic) {
+                Bot_Drop(ctx, &next);
+            }
+
+            int nextIndex = Bot_Index(&next);
+            if (bot->parents[nextIndex] < 0) {
+                bot->parents[nextIndex] = index;
+                bot->moves[nextIndex] = move;
+                bot->queue[tail++] = nextIndex;
+            }
+        }
+    }
+}
+
+// adds a piece to a copy of the board rows and removes the lines it filled.
+// returns the number of lines, or -1 if the piece sticks out the top
+static int Bot_Place(Uint16 *rows, PIECE *piece) {
+    const Uint8 *mask = pieceMasks[piece->num][piece->rotation];
+    int shift = piece->x + BOARD_WALL;
+    int lines = 0;
+
+    for (int y = 0; y < PIECE_SIZE; y++) {
+        if (mask[y] == 0) {
+            continue;
+        }
+        if (piece->y + y < 0) {
+            return -1;
+        }
+        rows[piece->y + y + BOARD_PAD] |= (mask[y] << shift);
+    }
+
+    // going top to bottom, the rows moved down have already been checked
+    for (int y = piece->y; (y < piece->y + PIECE_SIZE) && (y < GAME_ROWS); y++) {
+        if ((y >= 0) && (rows[y + BOARD_PAD] == ROW_FULL)) {
+            memmove(&rows[BOARD_PAD + 1], &rows[BOARD_PAD], y * sizeof(Uint16));
+            rows[BOARD_PAD] = ROW_EMPTY;
+            lines++;
+        }
+    }
+    return lines;
+}
+
+static Sint32 Bot_Evaluate(BOT *bot, Uint16 *rows, int lines) {
+    const BOT_WEIGHTS *weights = &bot->weights;
+    int heights[GAME_COLS] = {0};
+    int covered = 0;
+    int holes = 0;
+    int maxHeight = 0;
+
+    for (int y = 0; y < GAME_ROWS; y++) {
+        int row = (rows[y + BOARD_PAD] >> BOARD_WALL) & COL_MASK;
+        int found = row & ~covered;
+        if (found) {
+            if (!covered) {
+                maxHeight = GAME_ROWS - y;
+            }
+            for (int x = 0; x < GAME_COLS; x++) {
+                if (found & (1 << x)) {
+                    heights[x] = GAME_ROWS - y;
+                }
+            }
+            covered |= found;
+        }
+        holes += bitCounts[covered & ~row];
+    }
+
+    int height = 0;
+    int bumpiness = 0;
+    int wells = 0;
+    for (int x = 0; x < GAME_COLS; x++) {
+        height += heights[x];
+        if (x > 0) {
+            int diff = heights[x] - heights[x - 1];
+            bumpiness += (diff < 0) ? -diff : diff;
+        }
+        // the walls count as full columns
+        int left = (x > 0) ? heights[x - 1] : GAME_ROWS;
+        int right = (x < GAME_COLS - 1) ? heights[x + 1] : GAME_ROWS;
+        int depth = ((left < right) ? left : right) - heights[x];
+        if (depth > 0) {
+            wells += depth;
+        }
+    }
+
+    return (lines * weights->lines) + (holes * weights->holes) + (height * weights->height) +
+        (bumpiness * weights->bumpiness) + (wells * weights->wells) + (maxHeight * weights->maxHeight);
+}
+
+// places the next piece everywhere it can get to by rotating where it spawns
+// and then sliding sideways, returns the best score of what's left
+static Sint32 Bot_ScoreNext(BOT *bot, Uint16 *rows, int lines, int *evals) {
+    GAME_CTX *scratch = &bot->scratch;
+    Uint16 after[GAME_ROWS + (BOARD_PAD * 2)];
+    Sint32 best = BOT_WORST;
+    PIECE spawn = {SPAWN_X, SPAWN_Y, bot->nextNum, 0};
+
+    memcpy(scratch->boardRows, rows, sizeof(scratch->boardRows));
+    // the next piece wouldn't fit, so this tops out
+    if (!Game_CheckPiece(scratch, &spawn)) {
+        return BOT_WORST;
+    }
+
+    // no turn, clockwise, clockwise twice, and counterclockwise
+    for (int turn = 0; turn < PIECE_ROTATIONS; turn++) {
+        PIECE turned = spawn;
+        int turnedOk = 1;
+        if ((turn == 1) || (turn == 2)) {
+            turnedOk = Game_Rotate(scratch, &turned, ROTATE_CLOCKWISE);
+        }
+        if ((turn == 2) && turnedOk) {
+            turnedOk = Game_Rotate(scratch, &turned, ROTATE_CLOCKWISE);
+        }
+        if (turn == 3) {
+            turnedOk = Game_Rotate(scratch, &turned, ROTATE_COUNTERCLOCKWISE);
+        }
+        if (!turnedOk) {
+            continue;
+        }
+
+        // at 20G the piece slides along the stack instead of over it
+        if (bot->sonic) {
+            Bot_Drop(scratch, &turned);
+        }
+        for (int dir = -1; dir <= 1; dir += 2) {
+            PIECE slide = turned;
+            // the starting column is scored on the way left
+            if (dir > 0) {
+                slide.x++;
+            }
+            while (Game_CheckPiece(scratch, &slide)) {
+                if (bot->sonic) {
+                    Bot_Drop(scratch, &slide);
+                }
+                PIECE drop = slide;
+                Bot_Drop(scratch, &drop);
+                memcpy(after, rows, sizeof(after));
+                int moreLines = Bot_Place(after, &drop);
+                if (moreLines >= 0) {
+                    Sint32 score = Bot_Evaluate(bot, after, lines + moreLines);
+                    (*evals)++;
+                    if (score > best) {
+                        best = score;
+                    }
+                }
+                slide.x += dir;
+            }
+        }
+    }
+    return best;
+}
+
+// scores the board left by locking the piece at a position
+static Sint32 Bot_Score(BOT *bot, int index, int *evals) {
+    Uint16 rows[GAME_ROWS + (BOARD_PAD * 2)];
+    PIECE piece;
+
+    Bot_Position(index, bot->num, &piece);
+    memcpy(rows, bot->board, sizeof(rows));
+    int lines = Bot_Place(rows, &piece);
+    if (lines < 0) {
+        return BOT_WORST;
+    }
+    if (bot->lookahead) {
+        return Bot_ScoreNext(bot, rows, lines, evals);
+    }
+    (*evals)++;
+    return Bot_Evaluate(bot, rows, lines);
+}
+
+// scores positions until the budget runs out, returns 1 once they've all been
+// scored
+static int Bot_ScoreSome(BOT *bot) {
+    int evals = 0;
+
+    while (bot->candidate < bot->placementCount) {
+        if (bot->budget && (evals >= bot->budget)) {
+            return 0;
+        }
+        int index = bot->placements[bot->candidate];
+        Sint32 score = Bot_Score(bot, index, &evals);
+        if ((bot->target < 0) || (score > bot->bestScore)) {
+            bot->target = index;
+            bot->bestScore = score;
+        }
+        bot->candidate++;
+    }
+    return 1;
+}
+
+// starts working out where the current piece should go
+static void Bot_Plan(BOT *bot, GAME_CTX *ctx) {
+    int level = (ctx->level < SPEED_LEVELS) ? ctx->level : SPEED_LEVELS - 1;
+    PIECE start = ctx->currPiece;
+
+    bot->sonic = speedCurves[ctx->speedCurve][level].gravity >= 256;
+    if (bot->sonic) {
+        Bot_Drop(ctx, &start);
+    }
+    Bot_Search(bot, ctx, &start);
+
+    memcpy(bot->board, ctx->boardRows, sizeof(bot->board));
+    bot->num = ctx->currPiece.num;
+    bot->nextNum = ctx->nextPiece.num;
+    bot->scratch = *ctx;
+    bot->candidate = 0;
+    bot->target = -1;
+    bot->bestScore = BOT_WORST;
+    bot->phase = BOT_SCORE;
+}
+
+// walks the search back from the target, returns 0 if the search didn't get
+// there
+static int Bot_MakePath(BOT *bot) {
+    int target = bot->target;
+    int len = 0;
+
+    if ((target < 0) || (bot->parents[target] < 0)) {
+        return 0;
+    }
+    for (int i = target; bot->parents[i] != i; i = bot->parents[i]) {
+        len++;
+    }
+    if (len > BOT_MAX_PATH) {
+        return 0;
+    }
+
+    int index = target;
+    for (int i = len; i > 0; i--) {
+        bot->path[i] = index;
+        bot->pathMoves[i - 1] = bot->moves[index];
+        index = bot->parents[index];
+    }
+    bot->path[0] = index;
+    bot->pathLen = len;
+    bot->pathPos = 0;
+    return 1;
+}
+
+// returns the buttons for the next move on the path
+static Uint16 Bot_Follow(BOT *bot, GAME_CTX *ctx) {
+    PIECE piece = ctx->currPiece;
+    if (bot->sonic) {
+        Bot_Drop(ctx, &piece);
+    }
+    int index = Bot_Index(&piece);
+
+    // gravity can skip the piece ahead along the path
+    int pos = bot->pathPos;
+    while ((pos <= bot->pathLen) && (bot->path[pos] != index)) {
+        pos++;
+    }
+
+    // knocked off the path, find a new way to the target (or a new target)
+    if (pos > bot->pathLen) {
+        if (bot->replans >= MAX_REPLANS) {
+            return PAD_D;
+        }
+        bot->replans++;
+        Bot_Search(bot, ctx, &piece);
+        if (!Bot_MakePath(bot)) {
+            Bot_Plan(bot, ctx);
+            return 0;
+        }
+        pos = 0;
+    }
+    bot->pathPos = pos;
+
+    Uint16 button;
+    if (pos == bot->pathLen) {
+        // there, drop it the rest of the way if it's falling and then lock it
+        if (piece.y != ctx->currPiece.y) {
+            button = PAD_U;
+        }
+        else {
+            return PAD_D;
+        }
+    }
+    else {
+        button = moveButtons[bot->pathMoves[pos]];
+        // hard drop if it's straight down from here (holding down would lock
+        // the piece as soon as it lands, so it can't be used for tucks)
+        int end = pos;
+        while ((end < bot->pathLen) && (bot->pathMoves[end] == MOVE_DOWN)) {
+            end++;
+        }
+        if (end == bot->pathLen) {
+            button = PAD_U;
+        }
+    }
+
+    // let go for a tick so the next press counts
+    if (bot->held & button) {
+        return 0;
+    }
+    return button;
+}
+
+Uint16 Bot_Input(BOT *bot, GAME_CTX *ctx) {
+    Uint16 held = 0;
+
+    if (ctx->state != GAME_STATE_NORMAL) {
+        bot->phase = BOT_WAIT;
+        bot->replans = 0;
+    }
+    else {
+        if (bot->phase == BOT_WAIT) {
+            Bot_Plan(bot, ctx);
+            bot->pieces++;
+        }
+        if ((bot->phase == BOT_SCORE) && Bot_ScoreSome(bot)) {
+            bot->phase = BOT_FOLLOW;
+            // with no path, one gets searched for from wherever the piece is
+            if (!Bot_MakePath(bot)) {
+                bot->path[0] = -1;
+                bot->pathLen = 0;
+                bot->pathPos = 0;
+            }
+        }
+        if (bot->phase == BOT_FOLLOW) {
+            held = Bot_Follow(bot, ctx);
+        }
+    }
+
+    bot->held = held;
+    return held;
+}
@@ -0,0 +1,88 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <sega_mth.h>
+
+#include "game.h"
+#include "piece.h"
+
+// what each feature of the board left after a placement is worth. higher
+// scores are better, so the bad features get negative weights
+typedef struct {
+    Sint16 lines; // per line cleared
+    Sint16 holes; // per empty square with a block somewhere above it
+    Sint16 height; // per square of column height, summed over the columns
+    Sint16 bumpiness; // per square of height difference between neighbors
+    Sint16 wells; // per square a column is below both of its neighbors
+    Sint16 maxHeight; // per square of the tallest column
+} BOT_WEIGHTS;
+
+extern const BOT_WEIGHTS botDefaultWeights;
+
+// positions the search can visit, one for each x, y and rotation that keeps
+// the piece's mask inside the board rows
+#define BOT_MIN_X (-BOARD_WALL)
+#define BOT_XS (GAME_COLS - BOT_MIN_X)
+#define BOT_MIN_Y (-BOARD_PAD)
+#define BOT_YS (GAME_ROWS - BOT_MIN_Y)
+#define BOT_STATES (PIECE_ROTATIONS * BOT_YS * BOT_XS)
+#define BOT_MAX_PLACEMENTS (256)
+#define BOT_MAX_PATH (64)
+
+typedef struct {
+    BOT_WEIGHTS weights;
+    // most boards to score per Bot_Input call (0 scores everything at once).
+    // the best placement is picked once they've all been scored, and the
+    // piece waits where it is until then
+    int budget;
+    // also places the next piece on each board and scores what that leaves
+    int lookahead;
+    // pieces the bot has picked a placement for
+    Uint32 pieces;
+
+    int phase;
+    // the piece's search, parents[n] is the position n was reached from (-1
+    // if it wasn't reached) and moves[n] is the move that got it there
+    Sint16 parents[BOT_STATES];
+    Uint8 moves[BOT_STATES];
+    Sint16 queue[BOT_STATES];
+    // every position the piece can lock in, in the order they were found
+    Sint16 placements[BOT_MAX_PLACEMENTS];
+    int placementCount;
+    // pieces falling a row or more per tick are searched as if they dropped
+    // to the ground after every move
+    int sonic;
+
+    // scoring progress, target is the best position so far (-1 for none)
+    int candidate;
+    int target;
+    Sint32 bestScore;
+
+    // positions from the piece to the target (path[pathLen] is the target),
+    // and the move between each one and the next
+    Sint16 path[BOT_MAX_PATH + 1];
+    Uint8 pathMoves[BOT_MAX_PATH];
+    int pathLen;
+    int pathPos;
+    // searches made since the piece spawned, to give up on pieces that keep
+    // getting knocked off course
+    int replans;
+    // buttons returned last tick
+    Uint16 held;
+
+    // the board and pieces when the piece was planned, and a game to try the
+    // next piece's rotations in
+    Uint16 board[GAME_ROWS + (BOARD_PAD * 2)];
+    Uint8 num;
+    Uint8 nextNum;
+    GAME_CTX scratch;
+} BOT;
+
+// sets up a bot with the given weights and scoring budget
+void Bot_Init(BOT *bot, const BOT_WEIGHTS *weights, int budget);
+
+// picks the buttons to hold for the game's next tick (pass the result to
+// Game_Step)
+Uint16 Bot_Input(BOT *bot, GAME_CTX *ctx);
+
+#endif
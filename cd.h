@@ -16,4 +16,11 @@ void CD_ChangeDir(char *directory);
  * returns the loaded file's size
  */
 Sint32 CD_Load(char *filename, void *dataBuf);
+
+// reads a big endian (the Saturn's byte order) 32 bit number out of a loaded
+// file. ptr doesn't have to be aligned
+static inline Uint32 CD_Get32(const void *ptr) {
+    const Uint8 *bytes = ptr;
+    return ((Uint32)bytes[0] << 24) | ((Uint32)bytes[1] << 16) | ((Uint32)bytes[2] << 8) | bytes[3];
+}
 #endif
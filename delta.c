@@ -0,0 +1,42 @@
+#include "delta.h"
+
+int Delta_Encode(Uint8 *a, Uint8 *b, int size, Uint8 *out) {
+    int pos = 0;
+    int len = 0;
+
+    while (pos < size) {
+        int zeros = 0;
+        while ((pos < size) && (zeros < DELTA_RUN_MAX) && (a[pos] == b[pos])) {
+            zeros++;
+            pos++;
+        }
+
+        int literals = 0;
+        int literalPos = len + 2;
+        while ((pos < size) && (literals < DELTA_RUN_MAX) && (a[pos] != b[pos])) {
+            out[literalPos + literals] = a[pos] ^ b[pos];
+            literals++;
+            pos++;
+        }
+
+        out[len] = zeros;
+        out[len + 1] = literals;
+        len = literalPos + literals;
+    }
+
+    return len;
+}
+
+void Delta_Apply(Uint8 *delta, int len, Uint8 *dest) {
+    int in = 0;
+    int pos = 0;
+
+    while (in < len) {
+        pos += delta[in];
+        int literals = delta[in + 1];
+        in += 2;
+        for (int i = 0; i < literals; i++) {
+            dest[pos++] ^= delta[in++];
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <sega_mth.h>
+
+// deltas are a list of (number of zero bytes, number of literal bytes,
+// literal bytes) records, with each count going up to DELTA_RUN_MAX
+#define DELTA_RUN_MAX (255)
+
+// biggest a delta between two size byte buffers can get
+#define DELTA_MAX(size) ((size) + ((((size) / DELTA_RUN_MAX) + 1) * 2))
+
+// writes the XOR of a and b with the runs of zero bytes compressed to out,
+// returns the number of bytes written
+int Delta_Encode(Uint8 *a, Uint8 *b, int size, Uint8 *out);
+
+// XORs a delta into dest
+void Delta_Apply(Uint8 *delta, int len, Uint8 *dest);
+
+#endif
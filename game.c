@@ -1,815 +1,776 @@
-#include <sega_scl.h>
-
-#include "bg.h"
-#include "cd.h"
 #include "game.h"
 #include "gravity.h"
+#include "internal.h"
 #include "piece.h"
-#include "print.h"
-#include "rank.h"
 #include "release.h"
 #include "rng.h"
-#include "scroll.h"
-#include "sprite.h"
+#include "rotate.h"
 #include "sound.h"
+#include "speed.h"
 #include "vblank.h"
 
-typedef enum {
-    STATE_NORMAL,
-    STATE_LINE,
-    STATE_ARE,
-    STATE_GAMEOVER,
-    STATE_GAMEOVER_DONE,
-    STATE_PAUSED,
-} GAME_STATE;
-
-static int borderBase;
-#define BORDER_WIDTH (13)
-#define BORDER_HEIGHT (22)
-#define NEXT_TILE (borderBase + 286) 
-#define SCORE_TILE (borderBase + 290)
-#define LEVEL_TILE (borderBase + 294)
-#define RANKING_TILE (borderBase + 299)
-#define DIGITS_TILE (borderBase + 312)
-#define BLACK_TILE (borderBase + 322)
-
-static int gameState;
-static int prevState; // used to keep track of state when the game is paused
-static int gameTimer;
-
-#define ARE_FRAMES (30)
-#define LINE_FRAMES (41)
-
-static int blockStart;
-static SPRITE_INFO blockSpr;
-
-// ranking icon
-#define RANKING_X (22)
-#define RANKING_Y (4)
-static int ranking;
-static int iconStart;
-static SPRITE_INFO iconSpr;
-
-#define GAME_ROWS (20)
-#define GAME_COLS (10)
-static int gameBoard[GAME_ROWS][GAME_COLS];
-static int clearedLines[GAME_ROWS];
-
-#define ROW_OFFSET (64)
-#define TILE_SIZE (8)
-#define BOARD_X (10)
-#define BOARD_Y (5)
-volatile Uint16 *boardVram;
-
-#define SPAWN_X (3)
-#define SPAWN_Y (-1)
-static PIECE currPiece;
-
 #define PREVIEW_X (3)
 #define PREVIEW_Y (-4)
-static PIECE nextPiece;
-
-#define SCORE_X (22)
-#define SCORE_Y (14)
-static int score;
-// these two are used to calculate the score
-static int drop; 
-static int combo;
-
-#define LEVEL_X (SCORE_X)
-#define LEVEL_Y (SCORE_Y + 4)
-static int level;
-static int levelCursor;
-// the level where stuff starts moving fast
-#define FAST_LEVEL (800)
-
-#define MOVE_FRAMES (14)
-#define DAS_FRAMES (2)
-static int leftTimer;
-static int rightTimer;
-
-#define DOWN_FRAMES (3)
-#define LOCK_FRAMES (30)
-#define FAST_LOCK_FRAMES (22)
-static int downTimer;
-static int lockTimer;
 
-static int gravityTimer;
+// block tile the board is grayed out with on game over
+#define GAME_OVER_TILE (8)
+// garbage rows are gray too
+#define GARBAGE_TILE (GAME_OVER_TILE)
+// garbage rows sent for clearing 0-4 lines at once
+static const Uint8 garbageLines[] = {0, 0, 1, 2, 4};
 
-#define GAME_OVER_FRAMES (5)
-static int gameOverRow;
+// controller input for one tick
+typedef struct {
+    Uint16 held; // buttons held down
+    Uint16 pressed; // buttons that weren't held on the last tick
+} GAME_INPUT;
 
-#define ROTATE_CLOCKWISE (-1)
-#define ROTATE_COUNTERCLOCKWISE (1)
+#define Game_PlaySound(ctx, num) ((ctx)->sounds |= (1 << (num)))
 
-#define GAME_TRACK (3)
-#define MUSIC_VOLUME (6)
-int song;
+// timings for the current level
+static inline const SPEED *Game_Speed(GAME_CTX *ctx) {
+    int level = ctx->level;
+    if (level >= SPEED_LEVELS) {
+        level = SPEED_LEVELS - 1;
+    }
+    return &speedCurves[ctx->speedCurve][level];
+}
 
-// initializes a new piece
-static void Game_MakePiece(PIECE *gamePiece, PIECE *previewPiece) {
-    gamePiece->num = previewPiece->num;
-    gamePiece->rotation = 0;
-    gamePiece->x = SPAWN_X;
-    gamePiece->y = SPAWN_Y;
+// marks rows top through bottom as needing to be redrawn
+static inline void Game_MarkDirty(GAME_CTX *ctx, int top, int bottom) {
+    if (top < 0) {
+        top = 0;
+    }
+    if (bottom >= GAME_ROWS) {
+        bottom = GAME_ROWS - 1;
+    }
 
-    previewPiece->num = RNG_Get();
-    previewPiece->rotation = 0;
-    previewPiece->x = PREVIEW_X;
-    previewPiece->y = PREVIEW_Y;
-    
-    Sound_Play(previewPiece->num);
+    if (top < ctx->dirtyTop) {
+        ctx->dirtyTop = top;
+    }
+    if (bottom > ctx->dirtyBottom) {
+        ctx->dirtyBottom = bottom;
+    }
 }
 
-void Game_Init() {
-    // clear out previous scroll data
-    for (int i = 0; i < 0x40000; i++) {
-        ((volatile Uint8 *)SCL_VDP2_VRAM)[i] = 0;
-    }
-
-    // setup background
-    BG_Init();
-
-    // load assets
-    Uint8 *gameBuf = (Uint8 *)LWRAM;
-    CD_ChangeDir("GAME");
-    
-    blockStart = Sprite_Load("BLOCKS.SPR", NULL); // sprites for active blocks
-    iconStart = Sprite_Load("ICONS.SPR", NULL);
-    boardVram = (volatile Uint16 *)MAP_PTR(0) + (BOARD_Y * ROW_OFFSET) + BOARD_X;
-    
-    // load piece tiles
-    CD_Load("PLACED.TLE", gameBuf);
-    int blockBytes = Scroll_LoadTile(gameBuf, (volatile void *)SCL_VDP2_VRAM_A1, SCL_NBG0, 0);
-    borderBase = blockBytes / 64;
-
-    // load border tiles
-    CD_Load("BORDER.TLE", gameBuf);
-    Scroll_LoadTile(gameBuf, (volatile void *)(SCL_VDP2_VRAM_A1 + blockBytes), SCL_NBG1, 0);
-    int counter = borderBase;
-    for (int y = 0; y < BORDER_HEIGHT; y++) {
-        for (int x = 0; x < BORDER_WIDTH; x++) {
-            ((volatile Uint16 *)MAP_PTR(1))[(y + BOARD_Y - 1) * ROW_OFFSET + (x + BOARD_X - 2)] = (counter * 2);
-            counter++;
-        }
-    }
-    
-    // load playfield background
+// empties the playfield
+static void Game_ClearBoard(GAME_CTX *ctx) {
+    for (int i = 0; i < BOARD_PAD; i++) {
+        ctx->boardRows[i] = ROW_FULL;
+        BOARD_ROW(ctx, GAME_ROWS + i) = ROW_FULL;
+    }
+
     for (int y = 0; y < GAME_ROWS; y++) {
+        BOARD_ROW(ctx, y) = ROW_EMPTY;
         for (int x = 0; x < GAME_COLS; x++) {
-            ((volatile Uint16 *)MAP_PTR(2))[(y + BOARD_Y) * ROW_OFFSET + (x + BOARD_X)] = BLACK_TILE * 2;
+            ctx->boardColors[y][x] = 0;
         }
     }
-    // set transparent
-    SCL_SetColMixRate(SCL_NBG2, 20);
 
-    // load next text
-    for (int i = 0; i < 4; i++) { 
-        ((volatile Uint16 *)MAP_PTR(1))[(BOARD_Y + PREVIEW_Y + 2) * ROW_OFFSET 
-            + BOARD_X + PREVIEW_X - 4 + i] = (NEXT_TILE + i) * 2; 
+    for (int x = 0; x < GAME_COLS; x++) {
+        ctx->colTops[x] = GAME_ROWS;
     }
+    Game_MarkDirty(ctx, 0, GAME_ROWS - 1);
+}
 
-    // setup ranking
-    for (int i = 0; i < 5; i++) {
-        ((volatile Uint16 *)MAP_PTR(1))[RANKING_Y * ROW_OFFSET + RANKING_X + i] = (RANKING_TILE + i) * 2;
-    }
-    ranking = 0;
+// rebuilds the column heights from the board
+INTERNAL void Game_UpdateSurface(GAME_CTX *ctx) {
+    Uint16 seen = ROW_EMPTY;
 
-    // setup score
-    for (int i = 0; i < 4; i++) { 
-        ((volatile Uint16 *)MAP_PTR(1))[SCORE_Y * ROW_OFFSET + SCORE_X + i] = (SCORE_TILE + i) * 2; 
+    for (int x = 0; x < GAME_COLS; x++) {
+        ctx->colTops[x] = GAME_ROWS;
     }
-    score = 0;
-    combo = 1;
 
-    // setup level
-    for (int i = 0; i < 4; i++) { 
-        ((volatile Uint16 *)MAP_PTR(1))[LEVEL_Y * ROW_OFFSET + LEVEL_X + i] = (LEVEL_TILE + i) * 2; 
+    for (int y = 0; (y < GAME_ROWS) && (seen != ROW_FULL); y++) {
+        Uint16 found = BOARD_ROW(ctx, y) & ~seen;
+        if (found) {
+            for (int x = 0; x < GAME_COLS; x++) {
+                if (found & (1 << (x + BOARD_WALL))) {
+                    ctx->colTops[x] = y;
+                }
+            }
+            seen |= found;
+        }
     }
-    level = 0;
-    levelCursor = 0;
-   
-    CD_ChangeDir("..");
+}
+
+// initializes a new piece
+static void Game_MakePiece(GAME_CTX *ctx) {
+    PIECE *gamePiece = &ctx->currPiece;
+    PIECE *previewPiece = &ctx->nextPiece;
+
+    gamePiece->num = previewPiece->num;
+    gamePiece->rotation = 0;
+    gamePiece->x = SPAWN_X;
+    gamePiece->y = SPAWN_Y;
 
-    // initialize the RNG
-    RNG_Init();
+    previewPiece->num = RNG_Get(&ctx->rng);
+    previewPiece->rotation = 0;
+    previewPiece->x = PREVIEW_X;
+    previewPiece->y = PREVIEW_Y;
+
+    Game_PlaySound(ctx, previewPiece->num);
+}
+
+void Game_Reset(GAME_CTX *ctx, RNG_STATE *rng) {
+    ctx->rng = *rng;
+    // split from a copy, so the pieces are the same as without garbage
+    RNG_STATE parent = *rng;
+    RNG_Split(&parent, &ctx->garbageRng);
 
     // initialize the board
-    for (int y = 0; y < GAME_ROWS; y++) {
-        for (int x = 0; x < GAME_COLS; x++) {
-            gameBoard[y][x] = 0;
-        }
-    }
-    
+    ctx->dirtyTop = GAME_ROWS;
+    ctx->dirtyBottom = -1;
+    ctx->clearedRows = 0;
+    Game_ClearBoard(ctx);
+
     // set up game state
-    gameState = STATE_NORMAL;
-    prevState = STATE_NORMAL;
+    ctx->state = GAME_STATE_NORMAL;
+    ctx->prevState = GAME_STATE_NORMAL;
+    ctx->timer = 0;
+
+    ctx->score = 0;
+    ctx->drop = 0;
+    ctx->combo = 1;
+    ctx->level = 0;
+    ctx->ranking = 0;
+    ctx->finalRank = 0;
+    ctx->song = 0;
+    ctx->bg = 0;
 
     // initialize movement timers
-    leftTimer = MOVE_FRAMES;
-    rightTimer = MOVE_FRAMES;
-    downTimer = DOWN_FRAMES;
-    lockTimer = -1;
-    gravityTimer = 0;
+    ctx->leftTimer = MOVE_FRAMES;
+    ctx->rightTimer = MOVE_FRAMES;
+    ctx->downTimer = DOWN_FRAMES;
+    ctx->lockTimer = -1;
+    ctx->gravityTimer = 0;
+    ctx->gameOverRow = 0;
+
+    ctx->sounds = 0;
+    ctx->events = 0;
+    // buttons held going into the game don't count as presses
+    ctx->prevHeld = 0xFFFF;
+    ctx->garbageIn = 0;
+    ctx->garbageOut = 0;
 
     // set the first piece
-    nextPiece.num = RNG_Get();
-    Game_MakePiece(&currPiece, &nextPiece);
-    
-    Sound_CDVolume(MUSIC_VOLUME, MUSIC_VOLUME);
-    Sound_CDDA(GAME_TRACK, 1);
-    song = 0;
+    ctx->rotationSystem = ROTATION_ARS;
+    ctx->speedCurve = SPEED_NORMAL;
+    ctx->nextPiece.num = RNG_Get(&ctx->rng);
+    Game_MakePiece(ctx);
 }
 
-// draws a piece
-static void Game_DrawPiece(PIECE *piece) {
-    int tileNo;
-
-    for (int y = 0; y < PIECE_SIZE; y++) {
-        for (int x = 0; x < PIECE_SIZE; x++) {
-            tileNo = pieces[piece->num][piece->rotation][y][x];
-            if (tileNo != 0) {
-                // subtract 1 from the sprite number because the piece arrays have the first
-                // block sprite as 1 and 0 as "nothing"
-                Sprite_Make(blockStart + tileNo - 1, MTH_IntToFixed((BOARD_X + piece->x + x) * TILE_SIZE),
-                        MTH_IntToFixed((BOARD_Y + piece->y + y) * TILE_SIZE), &blockSpr);
-                Sprite_Draw(&blockSpr);
-            }
-        }
-    }
+void Game_Snapshot(GAME_CTX *ctx, GAME_CTX *snapshot) {
+    *snapshot = *ctx;
 }
 
-static void Game_DrawRanking(int num) {
-    Sprite_Make(iconStart + num, MTH_FIXED((RANKING_X - 1) * 8), MTH_FIXED((RANKING_Y + 1) * 8), &iconSpr);
-    Sprite_Draw(&iconSpr);
-}
-
-// draws the score and level
-static void Game_DrawNums() {
-    int tmp = score;
-    volatile Uint16 *scorePtr = (volatile Uint16 *)MAP_PTR(1) + ((SCORE_Y + 1) * ROW_OFFSET) + SCORE_X;
-    for (int i = 0; i < 6; i++) {
-        scorePtr[5 - i] = (DIGITS_TILE + (tmp % 10)) * 2;
-        scorePtr[ROW_OFFSET + (5 - i)] = (DIGITS_TILE + (tmp % 10) + BORDER_WIDTH) * 2;
-        tmp /= 10;
-    }
-
-    tmp = level;
-    volatile Uint16 *levelPtr = (volatile Uint16 *)MAP_PTR(1) + ((LEVEL_Y + 1) * ROW_OFFSET) + LEVEL_X;
-    for (int i = 0; i < 3; i++) {
-        levelPtr[2 - i] = (DIGITS_TILE + (tmp % 10)) * 2;
-        levelPtr[ROW_OFFSET + (2 - i)] = (DIGITS_TILE + (tmp % 10) + BORDER_WIDTH) * 2;
-        tmp /= 10;
-    }
+void Game_Restore(GAME_CTX *ctx, GAME_CTX *snapshot) {
+    *ctx = *snapshot;
+    // whatever was pending when the snapshot was taken has already been handled
+    ctx->sounds = 0;
+    ctx->events = 0;
+    ctx->dirtyTop = GAME_ROWS;
+    ctx->dirtyBottom = -1;
+    Game_MarkDirty(ctx, 0, GAME_ROWS - 1);
 }
 
 // copies a piece to the board
-static void Game_CopyPiece(PIECE *piece) {
-    int tile;
+static void Game_CopyPiece(GAME_CTX *ctx, PIECE *piece) {
+    const Uint8 *mask = pieceMasks[piece->num][piece->rotation];
+    int shift = piece->x + BOARD_WALL;
+    int tile = piece->num + 1;
+
+    Game_MarkDirty(ctx, piece->y, piece->y + PIECE_SIZE - 1);
 
     for (int y = 0; y < PIECE_SIZE; y++) {
+        if (mask[y] == 0) {
+            continue;
+        }
+        BOARD_ROW(ctx, piece->y + y) |= (mask[y] << shift);
+
+        // rows above the playfield don't have any colors
+        if ((piece->y + y) < 0) {
+            continue;
+        }
         for (int x = 0; x < PIECE_SIZE; x++) {
-            tile = pieces[piece->num][piece->rotation][y][x];
-            if (((piece->x + x) >= 0) && ((piece->y + y) >= 0) && (tile != 0)) {
-                gameBoard[piece->y + y][piece->x + x] = tile;
+            if ((mask[y] & (1 << x)) && ((piece->x + x) >= 0)) {
+                ctx->boardColors[piece->y + y][piece->x + x] = tile;
+                if ((piece->y + y) < ctx->colTops[piece->x + x]) {
+                    ctx->colTops[piece->x + x] = piece->y + y;
+                }
             }
         }
     }
 }
 
-static inline int Game_BoardGet(int x, int y) {
-    if ((y < 0) || (y >= GAME_ROWS)) {
-        return 1;
-    }
-
-    if ((x < 0) || (x >= GAME_COLS)) {
-        return 1;
-    }
+// returns nonzero if the piece overlaps the board when moved down yOffset rows
+static inline int Game_Collide(GAME_CTX *ctx, PIECE *piece, int yOffset) {
+    const Uint8 *mask = pieceMasks[piece->num][piece->rotation];
+    Uint16 *row = &BOARD_ROW(ctx, piece->y + yOffset);
+    int shift = piece->x + BOARD_WALL;
 
-    return gameBoard[y][x];
+    return (row[0] & (mask[0] << shift)) | (row[1] & (mask[1] << shift)) |
+        (row[2] & (mask[2] << shift)) | (row[3] & (mask[3] << shift));
 }
 
-// returns 1 if a piece can fit on the board
-static int Game_CheckPiece(PIECE *piece) {
-    for (int y = 0; y < PIECE_SIZE; y++) {
-        for (int x = 0; x < PIECE_SIZE; x++) {
-            if (Game_BoardGet(piece->x + x, piece->y + y) &&
-                    pieces[piece->num][piece->rotation][y][x]) {
-                return 0;
-            }
-        }
-    }
-
-    return 1;
+int Game_CheckPiece(GAME_CTX *ctx, PIECE *piece) {
+    return !Game_Collide(ctx, piece, 0);
 }
 
 // checks the center column rule for kicks
-static int Game_CanKick(PIECE *piece) {
-    if ((piece->num == PIECE_L) || (piece->num == PIECE_J) || (piece->num == PIECE_T)) {
-        for (int y = 0; y < PIECE_SIZE; y++) {
-            for (int x = 0; x < PIECE_SIZE; x++) {
-                if (Game_BoardGet(piece->x + x, piece->y + y) &&
-                        pieces[piece->num][piece->rotation][y][x]) {
-                    if (x == 1) {
-                        return 0;
-                    }
-                    else {
-                        return 1;
-                    }
-                }
-            }
+static int Game_CanKick(GAME_CTX *ctx, PIECE *piece, Uint8 centerMask) {
+    const Uint8 *mask = pieceMasks[piece->num][piece->rotation];
+    int shift = piece->x + BOARD_WALL;
+    for (int y = 0; y < PIECE_SIZE; y++) {
+        int overlap = (BOARD_ROW(ctx, piece->y + y) >> shift) & mask[y];
+        // the first overlapping block (scanning left to right, top to bottom)
+        // can't be in the center column
+        if (overlap) {
+            return (overlap & -overlap & centerMask) == 0;
         }
     }
 
     return 1;
 }
 
-static int Game_CanMoveLeft() {
-    if (PadData1E & PAD_L) {
-        leftTimer = MOVE_FRAMES;
+static int Game_CanMoveLeft(GAME_CTX *ctx, GAME_INPUT *input) {
+    if (input->pressed & PAD_L) {
+        ctx->leftTimer = MOVE_FRAMES;
         return 1;
     }
 
-    else if (PadData1 & PAD_L) {
-        if (leftTimer == 0) {
-            leftTimer = DAS_FRAMES;
+    else if (input->held & PAD_L) {
+        if (ctx->leftTimer == 0) {
+            ctx->leftTimer = DAS_FRAMES;
             return 1;
         }
         else {
-            if (level >= FAST_LEVEL) {
-                leftTimer -= 2;
-            }
-            else {
-                leftTimer--;
-            }
+            ctx->leftTimer -= Game_Speed(ctx)->dasStep;
         }
     }
     return 0;
 }
 
-static int Game_CanMoveRight() {
-    if (PadData1E & PAD_R) {
-        rightTimer = MOVE_FRAMES;
+static int Game_CanMoveRight(GAME_CTX *ctx, GAME_INPUT *input) {
+    if (input->pressed & PAD_R) {
+        ctx->rightTimer = MOVE_FRAMES;
         return 1;
     }
 
-    else if (PadData1 & PAD_R) {
-        if (rightTimer == 0) {
-            rightTimer = DAS_FRAMES;
+    else if (input->held & PAD_R) {
+        if (ctx->rightTimer == 0) {
+            ctx->rightTimer = DAS_FRAMES;
             return 1;
         }
         else {
-            if (level >= FAST_LEVEL) {
-                rightTimer -= 2;
-            }
-            else {
-                rightTimer--;
-            }
+            ctx->rightTimer -= Game_Speed(ctx)->dasStep;
         }
     }
     return 0;
 }
 
 // returns 1 if the piece is on ground or another piece
-static int Game_CheckBelow(PIECE *piece) {
-    for (int y = 0; y < PIECE_SIZE; y++) {
-        for (int x = 0; x < PIECE_SIZE; x++) {
-            if (pieces[piece->num][piece->rotation][y][x] &&
-                    Game_BoardGet(piece->x + x, piece->y + y + 1)) {
-                return 1;
+INTERNAL int Game_CheckBelow(GAME_CTX *ctx, PIECE *piece) {
+    return Game_Collide(ctx, piece, 1) != 0;
+}
+
+int Game_DropDistance(GAME_CTX *ctx, PIECE *piece) {
+    const Sint8 *bottoms = pieceBottoms[piece->num][piece->rotation];
+    int dist = GAME_ROWS;
+    int col;
+    int colDist;
+
+    for (int x = 0; x < PIECE_SIZE; x++) {
+        if (bottoms[x] < 0) {
+            continue;
+        }
+        col = piece->x + x;
+        colDist = ctx->colTops[col] - (piece->y + bottoms[x]) - 1;
+        // the piece is under an overhang, so the surface doesn't say where it
+        // lands. fall back to testing each row
+        if (colDist < 0) {
+            dist = 0;
+            while (!Game_Collide(ctx, piece, dist + 1)) {
+                dist++;
             }
+            return dist;
+        }
+        if (colDist < dist) {
+            dist = colDist;
         }
     }
-    return 0;
+
+    return dist;
 }
 
-static int Game_CanMoveDown() {
-    if (PadData1E & (PAD_D | PAD_A)) {
-        downTimer = DOWN_FRAMES;
+static int Game_CanMoveDown(GAME_CTX *ctx, GAME_INPUT *input) {
+    if (input->pressed & (PAD_D | PAD_A)) {
+        ctx->downTimer = DOWN_FRAMES;
         return 1;
     }
 
-    else if (PadData1 & (PAD_D | PAD_A)) {
-        if (downTimer == 0) {
-            downTimer = DOWN_FRAMES;
+    else if (input->held & (PAD_D | PAD_A)) {
+        if (ctx->downTimer == 0) {
+            ctx->downTimer = DOWN_FRAMES;
             return 1;
         }
         else {
-            downTimer--;
+            ctx->downTimer--;
         }
     }
 
-    gravityTimer--;
+    ctx->gravityTimer--;
     return 0;
 }
 
-static int Game_Drop(PIECE *piece) {
-    if (!Game_CheckBelow(piece)) {
-        piece->y++;
-        drop++;
-        return 1;
+// moves the piece down up to the given number of rows, returns how far it moved
+static int Game_Drop(GAME_CTX *ctx, PIECE *piece, int rows) {
+    int dist = Game_DropDistance(ctx, piece);
+    if (rows > dist) {
+        rows = dist;
     }
-    return 0;
+    piece->y += rows;
+    ctx->drop += rows;
+    return rows;
 }
 
-static int Game_Rotate(PIECE *piece, int rotation) {
-    int originalX = piece->x;
-    int originalY = piece->y;
-    Uint8 originalRotation = piece->rotation;
-    piece->rotation += rotation;
-    piece->rotation %= PIECE_ROTATIONS;
-    if (Game_CheckPiece(piece)) {
-        return 1;
-    }
+int Game_Rotate(GAME_CTX *ctx, PIECE *piece, int dir) {
+    const ROTATION_SYSTEM *system = &rotationSystems[ctx->rotationSystem];
+    const KICK_LIST *list = &system->lists[piece->num][piece->rotation][dir];
+    PIECE base = *piece;
+    PIECE test;
+    int canKick = -1;
 
-    // ceiling kicks
-    if ((piece->y == SPAWN_Y) && !Game_CheckBelow(piece)) {
-        piece->y++;
-        if (Game_CheckPiece(piece)) {
-            return 1;
-        }
-    } 
+    base.rotation = list->to;
+    for (int i = 0; i < list->count; i++) {
+        const KICK *kick = &list->kicks[i];
 
-    if (Game_CanKick(piece)) {
-        // try going to the left
-        piece->x++;
-        if (Game_CheckPiece(piece)) {
-            return 1;
+        if (kick->flags & KICK_CEILING) {
+            if ((base.y != SPAWN_Y) || Game_CheckBelow(ctx, &base)) {
+                continue;
+            }
+            // the ceiling kick sticks even if it doesn't fit
+            base.y += kick->y;
+            test = base;
+        }
+        else {
+            if (kick->flags & KICK_CENTER) {
+                if (canKick == -1) {
+                    canKick = Game_CanKick(ctx, &base, system->centerMask);
+                }
+                if (!canKick) {
+                    continue;
+                }
+            }
+            test = base;
+            test.x += kick->x;
+            test.y += kick->y;
         }
 
-        // try going to the left
-        piece->x -= 2;
-        if (Game_CheckPiece(piece)) {
+        if (Game_CheckPiece(ctx, &test)) {
+            *piece = test;
             return 1;
         }
     }
-    
-    // move back
-    piece->x = originalX;
-    piece->y = originalY;
-    piece->rotation = originalRotation;
+
     return 0;
 }
 
 // buffer in next rotate before piece spawns
-static void Game_BufferRotate() {
-    if (PadData1 & PAD_C) {
-        Game_Rotate(&currPiece, ROTATE_CLOCKWISE);
-        Sound_Play(SOUND_ROTATE);
+static void Game_BufferRotate(GAME_CTX *ctx, GAME_INPUT *input) {
+    if (input->held & PAD_C) {
+        Game_Rotate(ctx, &ctx->currPiece, ROTATE_CLOCKWISE);
+        Game_PlaySound(ctx, SOUND_ROTATE);
     }
 
-    if (PadData1 & PAD_B) {
-        Game_Rotate(&currPiece, ROTATE_COUNTERCLOCKWISE);
-        Sound_Play(SOUND_ROTATE);
+    if (input->held & PAD_B) {
+        Game_Rotate(ctx, &ctx->currPiece, ROTATE_COUNTERCLOCKWISE);
+        Game_PlaySound(ctx, SOUND_ROTATE);
     }
 }
 
-static inline void Game_CopyRow(int dst, int src) {
+static inline void Game_CopyRow(GAME_CTX *ctx, int dst, int src) {
+    if (src >= 0) {
+        BOARD_ROW(ctx, dst) = BOARD_ROW(ctx, src);
+    }
+    else {
+        BOARD_ROW(ctx, dst) = ROW_EMPTY;
+    }
+
     for (int i = 0; i < GAME_COLS; i++) {
         if (src >= 0) {
-            gameBoard[dst][i] = gameBoard[src][i];
+            ctx->boardColors[dst][i] = ctx->boardColors[src][i];
         }
         else {
-            gameBoard[dst][i] = 0;
+            ctx->boardColors[dst][i] = 0;
         }
     }
 }
 
-static inline void Game_MoveDown(int row) {
-    for (int i = row; i >= 0; i--) {
-        Game_CopyRow(i, i - 1);
-    } 
+// removes the cleared rows and moves everything above them down in one pass,
+// so each remaining row is copied at most once
+INTERNAL void Game_RemoveLines(GAME_CTX *ctx) {
+    int top = GAME_ROWS;
+    int bottom = GAME_ROWS - 1;
+    int dst;
+
+    // only rows between the top of the stack and the lowest cleared row move
+    for (int x = 0; x < GAME_COLS; x++) {
+        if (ctx->colTops[x] < top) {
+            top = ctx->colTops[x];
+        }
+    }
+    while ((bottom >= 0) && !(ctx->clearedRows & (1 << bottom))) {
+        bottom--;
+    }
+    if (bottom < top) {
+        return;
+    }
+
+    dst = bottom;
+    for (int src = bottom; src >= top; src--) {
+        if (ctx->clearedRows & (1 << src)) {
+            continue;
+        }
+        Game_CopyRow(ctx, dst, src);
+        dst--;
+    }
+    for (; dst >= top; dst--) {
+        Game_CopyRow(ctx, dst, -1);
+    }
+
+    ctx->clearedRows = 0;
+    Game_MarkDirty(ctx, top, bottom);
 }
 
-// returns number of filled lines.
-static int Game_CheckLines() {
-    int full;
+// checks the rows a piece was locked into, returns number of filled lines.
+INTERNAL int Game_CheckLines(GAME_CTX *ctx, PIECE *piece) {
     int lines = 0;
+    int start = piece->y;
+    int end = piece->y + PIECE_SIZE;
 
-    // clear the "cleared lines" array
-    for (int i = 0; i < GAME_ROWS; i++) {
-        clearedLines[i] = 0;
+    if (start < 0) {
+        start = 0;
+    }
+    if (end > GAME_ROWS) {
+        end = GAME_ROWS;
     }
 
     // check and mark all filled lines
-    for (int y = 0; y < GAME_ROWS; y++) {
-        full = 1;
-        for (int x = 0; x < GAME_COLS; x++) {
-            if (gameBoard[y][x] == 0) {
-                full = 0;
-                break;
-            }
-        }
-
-        if (full) {
+    ctx->clearedRows = 0;
+    for (int y = start; y < end; y++) {
+        if (BOARD_ROW(ctx, y) == ROW_FULL) {
+            BOARD_ROW(ctx, y) = ROW_EMPTY;
             for (int x = 0; x < GAME_COLS; x++) {
-                gameBoard[y][x] = 0;
+                ctx->boardColors[y][x] = 0;
             }
-            clearedLines[y] = 1;
+            ctx->clearedRows |= (1 << y);
             lines++;
         }
     }
     return lines;
 }
 
-static int Game_Normal() {
+void Game_AddGarbage(GAME_CTX *ctx, int rows) {
+    rows += ctx->garbageIn;
+    if (rows > GAME_ROWS) {
+        rows = GAME_ROWS;
+    }
+    ctx->garbageIn = rows;
+}
+
+// garbage sent cancels out garbage that's waiting to come in first
+static void Game_SendGarbage(GAME_CTX *ctx, int rows) {
+    int cancel = (rows < ctx->garbageIn) ? rows : ctx->garbageIn;
+
+    ctx->garbageIn -= cancel;
+    rows += ctx->garbageOut - cancel;
+    if (rows > GAME_ROWS) {
+        rows = GAME_ROWS;
+    }
+    ctx->garbageOut = rows;
+}
+
+// pushes the stack up and fills the bottom with the waiting garbage rows (all
+// with the hole in the same column), returns 1 if blocks got pushed off the top
+static int Game_RaiseGarbage(GAME_CTX *ctx) {
+    int rows = ctx->garbageIn;
+    int hole = RNG_Next(&ctx->garbageRng) % GAME_COLS;
+    int toppedOut = 0;
+
+    for (int y = 0; y < rows; y++) {
+        if (BOARD_ROW(ctx, y) != ROW_EMPTY) {
+            toppedOut = 1;
+        }
+    }
+    for (int y = 0; y < GAME_ROWS - rows; y++) {
+        Game_CopyRow(ctx, y, y + rows);
+    }
+    for (int y = GAME_ROWS - rows; y < GAME_ROWS; y++) {
+        BOARD_ROW(ctx, y) = ROW_FULL & ~(1 << (hole + BOARD_WALL));
+        for (int x = 0; x < GAME_COLS; x++) {
+            ctx->boardColors[y][x] = (x == hole) ? 0 : GARBAGE_TILE;
+        }
+    }
+
+    ctx->garbageIn = 0;
+    Game_UpdateSurface(ctx);
+    Game_MarkDirty(ctx, 0, GAME_ROWS - 1);
+    return toppedOut;
+}
+
+static void Game_Normal(GAME_CTX *ctx, GAME_INPUT *input) {
+    PIECE *currPiece = &ctx->currPiece;
     int oldLevel;
     int lines;
     int lockSound = 1;
 
-    if (DEBUG && (PadData1E & PAD_Z)) {
-        for (int y = 0; y < GAME_ROWS; y++) {
-            for (int x = 0; x < GAME_COLS; x++) {
-                gameBoard[y][x] = 0;
-            }
-        }
+    if (DEBUG && (input->pressed & PAD_Z)) {
+        Game_ClearBoard(ctx);
     }
-    
+
     // clockwise rotation
-    if (PadData1E & PAD_C) {
-        Game_Rotate(&currPiece, ROTATE_CLOCKWISE);
+    if (input->pressed & PAD_C) {
+        Game_Rotate(ctx, currPiece, ROTATE_CLOCKWISE);
     }
 
     // counterclockwise rotation
-    if (PadData1E & PAD_B) {
-        Game_Rotate(&currPiece, ROTATE_COUNTERCLOCKWISE);
+    if (input->pressed & PAD_B) {
+        Game_Rotate(ctx, currPiece, ROTATE_COUNTERCLOCKWISE);
     }
-    
 
-    if ((lockTimer == -1) && Game_CheckBelow(&currPiece)) {
-        if (level >= FAST_LEVEL) {
-            lockTimer = FAST_LOCK_FRAMES;
-        }
-        else {
-            lockTimer = LOCK_FRAMES;
-        }
-        Sound_Play(SOUND_LAND);
+
+    if ((ctx->lockTimer == -1) && Game_CheckBelow(ctx, currPiece)) {
+        ctx->lockTimer = Game_Speed(ctx)->lockFrames;
+        Game_PlaySound(ctx, SOUND_LAND);
 
         // don't play lock sound & lock immediately if player's holding down
         // when piece lands (aka soft drop)
-        if (PadData1 & (PAD_D | PAD_A)) {
+        if (input->held & (PAD_D | PAD_A)) {
             lockSound = 0;
-            lockTimer = 0;
+            ctx->lockTimer = 0;
         }
     }
-    else if (!Game_CheckBelow(&currPiece)) {
-        lockTimer = -1;
+    else if (!Game_CheckBelow(ctx, currPiece)) {
+        ctx->lockTimer = -1;
     }
 
     // hard drop
-    if ((PadData1 & PAD_U) && (lockTimer == -1)) {
-        while (Game_Drop(&currPiece));
-        if (level >= FAST_LEVEL) {
-            lockTimer = FAST_LOCK_FRAMES;
-        }
-        else {
-            lockTimer = LOCK_FRAMES;
-        }
-        Sound_Play(SOUND_LAND);
+    if ((input->held & PAD_U) && (ctx->lockTimer == -1)) {
+        Game_Drop(ctx, currPiece, GAME_ROWS);
+        ctx->lockTimer = Game_Speed(ctx)->lockFrames;
+        Game_PlaySound(ctx, SOUND_LAND);
     }
 
     // gravity
-    while (level >= levels[levelCursor + 1]) {
-        levelCursor++;
-    }
-    gravityTimer += gravity[levelCursor];
-    Print_Num(gravityTimer, 0, 0);
-    Print_Num(levelCursor, 1, 0);
-    Print_Num(gravity[levelCursor], 2, 0);
-    while (gravityTimer >> 8) {
-        Game_Drop(&currPiece);
-        gravityTimer -= 256;
+    ctx->gravityTimer += Game_Speed(ctx)->gravity;
+    if (ctx->gravityTimer >> 8) {
+        Game_Drop(ctx, currPiece, ctx->gravityTimer >> 8);
+        ctx->gravityTimer &= 0xFF;
     }
 
     // soft drop
-    if (Game_CanMoveDown()) {
-        Game_Drop(&currPiece);
+    if (Game_CanMoveDown(ctx, input)) {
+        Game_Drop(ctx, currPiece, 1);
     }
 
     // allow player to interrupt lock timer if we're on the ground
-    if ((lockTimer > 0) && (PadData1 & (PAD_D | PAD_A))) {
-        lockTimer = 0;
+    if ((ctx->lockTimer > 0) && (input->held & (PAD_D | PAD_A))) {
+        ctx->lockTimer = 0;
     }
 
-    if (lockTimer == 0) {
-        lockTimer = -1;
-        drop = 0;
-        Game_CopyPiece(&currPiece);
-        
-        lines = Game_CheckLines();
-        oldLevel = level;
+    if (ctx->lockTimer == 0) {
+        ctx->lockTimer = -1;
+        ctx->drop = 0;
+        Game_CopyPiece(ctx, currPiece);
+
+        lines = Game_CheckLines(ctx, currPiece);
+        oldLevel = ctx->level;
         if (lines) {
-            gameState = STATE_LINE;
-            gameTimer = LINE_FRAMES;
-            Sound_Play(SOUND_CLEAR);
-            combo = combo + (lines * 2) - 2;
-            level += lines;
-            score += ((((level + lines) / 4) + 1) + drop) * lines * combo;
-            while (score >= ranks[ranking + 1]) {
-                ranking++;
+            ctx->state = GAME_STATE_LINE;
+            Game_PlaySound(ctx, SOUND_CLEAR);
+            ctx->combo = ctx->combo + (lines * 2) - 2;
+            ctx->level += lines;
+            ctx->timer = Game_Speed(ctx)->lineFrames;
+            ctx->score += ((((ctx->level + lines) / 4) + 1) + ctx->drop) * lines * ctx->combo;
+            while (ctx->score >= ranks[ctx->ranking + 1]) {
+                ctx->ranking++;
             }
+            Game_SendGarbage(ctx, garbageLines[lines]);
         }
         else {
-            combo = 1;
-            gameState = STATE_ARE;
-            gameTimer = ARE_FRAMES;
+            ctx->combo = 1;
+            ctx->state = GAME_STATE_ARE;
+            ctx->timer = Game_Speed(ctx)->areFrames;
         }
 
-        if (DEBUG && (PadData1 & PAD_Y)) {
-            level += 50;
+        if (DEBUG && (input->held & PAD_Y)) {
+            ctx->level += 50;
         }
 
         // bg changing
 
         // change every 100 levels before 600
-        if ((level < 600) && ((level / 100) > (oldLevel / 100))) {
-            BG_Next();
+        if ((ctx->level < 600) && ((ctx->level / 100) > (oldLevel / 100))) {
+            ctx->bg++;
         }
         // change at 800
-        else if ((level >= 800) && (level < 900) && ((level / 100) > (oldLevel / 100))) {
-            BG_Next();
+        else if ((ctx->level >= 800) && (ctx->level < 900) && ((ctx->level / 100) > (oldLevel / 100))) {
+            ctx->bg++;
         }
 
-        if (level > 999) {
-            Rank_Setup(9);
-            gameState = STATE_GAMEOVER_DONE;
+        if (ctx->level > 999) {
+            ctx->finalRank = FINISH_RANK;
+            ctx->state = GAME_STATE_GAMEOVER_DONE;
         }
 
         // cut volume before a song change for dramatic effect
-        if ((songs[song + 1] - level) <= 10) {
-            Sound_CDVolume(0, 0);
+        if ((songs[ctx->song + 1] - ctx->level) <= 10) {
+            ctx->events |= GAME_EVENT_MUSIC_CUT;
         }
 
         // if we've gotten to a song change, switch to the next song
-        if ((oldLevel < songs[song + 1]) && (level >= songs[song + 1])) {
-            song++;
-            Sound_CDDA(GAME_TRACK + song, 1);
-            Sound_CDVolume(MUSIC_VOLUME, MUSIC_VOLUME);
+        if ((oldLevel < songs[ctx->song + 1]) && (ctx->level >= songs[ctx->song + 1])) {
+            ctx->song++;
+            ctx->events |= GAME_EVENT_MUSIC_NEXT;
         }
-        
+
         if (lockSound) {
-            Sound_Play(SOUND_LOCK);
+            Game_PlaySound(ctx, SOUND_LOCK);
         }
     }
-    else if (lockTimer > 0) {
-        lockTimer--;
+    else if (ctx->lockTimer > 0) {
+        ctx->lockTimer--;
     }
 
     // horizontal movement
-    if (Game_CanMoveLeft()) {
-        currPiece.x--;
-        if (!Game_CheckPiece(&currPiece)) {
-            currPiece.x++;
+    if (Game_CanMoveLeft(ctx, input)) {
+        currPiece->x--;
+        if (!Game_CheckPiece(ctx, currPiece)) {
+            currPiece->x++;
         }
     }
 
-    if (Game_CanMoveRight()) {
-        currPiece.x++;
-        if (!Game_CheckPiece(&currPiece)) {
-            currPiece.x--;
+    if (Game_CanMoveRight(ctx, input)) {
+        currPiece->x++;
+        if (!Game_CheckPiece(ctx, currPiece)) {
+            currPiece->x--;
         }
     }
-
-    // don't draw the piece if we're replacing it with another one
-    if (gameState == STATE_NORMAL) {
-        Game_DrawPiece(&currPiece);
-    }
-
-    return 0;
 }
 
-static void Game_Line() {
-    if (gameTimer > 0) {
-        if (level >= 800) {
-            gameTimer -= 2;
-        }
-        else {
-            gameTimer--;
-        }
+static void Game_Line(GAME_CTX *ctx) {
+    if (ctx->timer > 0) {
+        ctx->timer--;
     }
     else {
         // delete all cleared rows
-        for (int i = 0; i < GAME_ROWS; i++) {
-            if (clearedLines[i]) {
-                Game_MoveDown(i);
-            }
-        }
-        Sound_Play(SOUND_FALL);
-        gameTimer = ARE_FRAMES;
-        gameState = STATE_ARE;
+        Game_RemoveLines(ctx);
+        Game_UpdateSurface(ctx);
+        Game_PlaySound(ctx, SOUND_FALL);
+        ctx->timer = Game_Speed(ctx)->areFrames;
+        ctx->state = GAME_STATE_ARE;
     }
 }
 
-static void Game_Are() {
-    if (gameTimer > 0) {
-        if (level >= 800) {
-            gameTimer -= 2;
-        }
-        else {
-            gameTimer--;
-        }
+static void Game_Are(GAME_CTX *ctx, GAME_INPUT *input) {
+    if (ctx->timer > 0) {
+        ctx->timer--;
     }
     else {
-        Game_MakePiece(&currPiece, &nextPiece);
+        int toppedOut = 0;
+        if (ctx->garbageIn) {
+            toppedOut = Game_RaiseGarbage(ctx);
+        }
+        Game_MakePiece(ctx);
         // if the new piece collides with the board, it's game over
-        if (!Game_CheckPiece(&currPiece)) {
-            Game_CopyPiece(&currPiece);
-            gameState = STATE_GAMEOVER;
-            gameTimer = GAME_OVER_FRAMES;
-            gameOverRow = 0;
+        if (toppedOut || !Game_CheckPiece(ctx, &ctx->currPiece)) {
+            Game_CopyPiece(ctx, &ctx->currPiece);
+            ctx->state = GAME_STATE_GAMEOVER;
+            ctx->timer = GAME_OVER_FRAMES;
+            ctx->gameOverRow = 0;
             return;
         }
-        if ((level % 100) != 99) {
-            level++;
+        if ((ctx->level % 100) != 99) {
+            ctx->level++;
         }
-        gameState = STATE_NORMAL;
-        Game_BufferRotate();
+        ctx->state = GAME_STATE_NORMAL;
+        Game_BufferRotate(ctx, input);
     }
     // allow to charge DAS for the next piece
-    Game_CanMoveLeft();
-    Game_CanMoveRight();
+    Game_CanMoveLeft(ctx, input);
+    Game_CanMoveRight(ctx, input);
 }
 
-static void Game_Over() {
-    if (gameTimer > 0) {
-        gameTimer--;
+static void Game_Over(GAME_CTX *ctx) {
+    if (ctx->timer > 0) {
+        ctx->timer--;
     }
     else {
         // replace the blocks with the "grayed out" block one row at a time
         for (int i = 0; i < GAME_COLS; i++) {
-            if (gameBoard[gameOverRow][i]) {
-                gameBoard[gameOverRow][i] = 8;
+            if (ctx->boardColors[ctx->gameOverRow][i]) {
+                ctx->boardColors[ctx->gameOverRow][i] = GAME_OVER_TILE;
             }
         }
-        gameOverRow++;
-        gameTimer = GAME_OVER_FRAMES;
-        if (gameOverRow == GAME_ROWS) {
-            gameState = STATE_GAMEOVER_DONE;
-            Rank_Setup(ranking);
+        Game_MarkDirty(ctx, ctx->gameOverRow, ctx->gameOverRow);
+        ctx->gameOverRow++;
+        ctx->timer = GAME_OVER_FRAMES;
+        if (ctx->gameOverRow == GAME_ROWS) {
+            ctx->state = GAME_STATE_GAMEOVER_DONE;
+            ctx->finalRank = ctx->ranking;
         }
     }
 }
 
-int Game_Run() {
+int Game_Step(GAME_CTX *ctx, Uint16 held) {
+    GAME_INPUT in;
+    GAME_INPUT *input = &in;
+
+    // presses come from the previous tick rather than the previous vblank, so
+    // catching up several ticks at once doesn't repeat them
+    input->held = held;
+    input->pressed = held & ~ctx->prevHeld;
+    ctx->prevHeld = held;
+
     // handle pause button
-    if (PadData1E & PAD_S) {
+    if (input->pressed & PAD_S) {
         // pause: save previous state
-        if (gameState != STATE_PAUSED) {
-            prevState = gameState;
-            gameState = STATE_PAUSED;
-            
-            // clear board on screen so player can't cheat
-            for (int y = 0; y < GAME_ROWS; y++) {
-                for (int x = 0; x < GAME_COLS; x++) {
-                    boardVram[(y * ROW_OFFSET) + x] = 0;
-                }
-            }
+        if (ctx->state != GAME_STATE_PAUSED) {
+            ctx->prevState = ctx->state;
+            ctx->state = GAME_STATE_PAUSED;
+            ctx->events |= GAME_EVENT_PAUSE;
         }
         // resume: restore state
         else {
-            gameState = prevState;
+            ctx->state = ctx->prevState;
+            ctx->events |= GAME_EVENT_RESUME;
+            Game_MarkDirty(ctx, 0, GAME_ROWS - 1);
         }
     }
 
-    switch (gameState) {
-        case STATE_NORMAL:
-            Game_Normal();
+    switch (ctx->state) {
+        case GAME_STATE_NORMAL:
+            Game_Normal(ctx, input);
             break;
 
-        case STATE_LINE:
-            Game_Line();
+        case GAME_STATE_LINE:
+            Game_Line(ctx);
             break;
 
-        case STATE_ARE:
-            Game_Are();
+        case GAME_STATE_ARE:
+            Game_Are(ctx, input);
             break;
 
-        case STATE_GAMEOVER:
-            Game_Over();
+        case GAME_STATE_GAMEOVER:
+            Game_Over(ctx);
             break;
 
-        case STATE_PAUSED:
+        case GAME_STATE_PAUSED:
             break;
     }
-    
-    Game_DrawPiece(&nextPiece); 
-    Game_DrawRanking(ranking);
-    Game_DrawNums();
-    
-
-
-    // copy the board to VRAM
-    if (gameState != STATE_PAUSED) {
-        for (int y = 0; y < GAME_ROWS; y++) {
-            for (int x = 0; x < GAME_COLS; x++) {
-                boardVram[(y * ROW_OFFSET) + x] = (gameBoard[y][x] * 2);
-            }
-        }
-    }
-
-    BG_Run();
 
-    if (gameState == STATE_GAMEOVER_DONE) {
+    if (ctx->state == GAME_STATE_GAMEOVER_DONE) {
         return 1;
     }
 
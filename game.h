@@ -3,6 +3,37 @@
 
 #include <sega_mth.h>
 
+#include "rng.h"
+
+#define GAME_ROWS (20)
+#define GAME_COLS (10)
+
+// the board is stored as one bitmask per row, with column x at bit (x + BOARD_WALL).
+// bits outside the playfield are always set so they act as walls, and there are
+// BOARD_PAD solid rows above and below the playfield, so a piece can be tested
+// against the board without any bounds checks
+#define BOARD_WALL (3)
+#define BOARD_PAD (4)
+#define ROW_FULL (0xFFFF)
+#define ROW_EMPTY ((Uint16)(ROW_FULL ^ (((1 << GAME_COLS) - 1) << BOARD_WALL)))
+#define BOARD_ROW(ctx, y) ((ctx)->boardRows[(y) + BOARD_PAD])
+
+// where new pieces show up
+#define SPAWN_X (3)
+#define SPAWN_Y (-1)
+
+// autoshift: ticks held before a piece starts sliding, then ticks between
+// slides. these and the ones below are also used by the batch engine in
+// host/batch.c
+#define MOVE_FRAMES (14)
+#define DAS_FRAMES (2)
+// ticks between soft drops
+#define DOWN_FRAMES (3)
+// ticks between each row being grayed out on game over
+#define GAME_OVER_FRAMES (5)
+// ranking given for finishing the game
+#define FINISH_RANK (9)
+
 typedef struct {
     int x;
     int y;
@@ -10,11 +41,108 @@ typedef struct {
     Uint8 rotation;
 } PIECE;
 
-// reloads all assets & initializes game
-void Game_Init();
+typedef enum {
+    GAME_STATE_NORMAL,
+    GAME_STATE_LINE,
+    GAME_STATE_ARE,
+    GAME_STATE_GAMEOVER,
+    GAME_STATE_GAMEOVER_DONE,
+    GAME_STATE_PAUSED,
+} GAME_STATES;
 
-// advances gameplay by one frame
-int Game_Run();
+// things that happened during a tick that the frontend has to act on
+#define GAME_EVENT_PAUSE (1 << 0)
+#define GAME_EVENT_RESUME (1 << 1)
+// cut the music volume before a song change
+#define GAME_EVENT_MUSIC_CUT (1 << 2)
+// start playing the song in GAME_CTX.song
+#define GAME_EVENT_MUSIC_NEXT (1 << 3)
 
-#endif
+// all the state for one game. it doesn't hold any pointers, so it can be
+// copied with memcpy
+typedef struct {
+    Uint16 boardRows[GAME_ROWS + (BOARD_PAD * 2)];
+    // block tile for each square, only used for drawing
+    Uint8 boardColors[GAME_ROWS][GAME_COLS];
+    // highest filled row in each column (GAME_ROWS if the column is empty)
+    Uint8 colTops[GAME_COLS];
+    // bit y is set if row y was cleared
+    Uint32 clearedRows;
+    // range of rows that changed since the frontend last drew the board
+    int dirtyTop;
+    int dirtyBottom;
+
+    PIECE currPiece;
+    PIECE nextPiece;
+    RNG_STATE rng;
+    // where the holes in garbage rows go. it's kept apart from rng so taking
+    // garbage doesn't change the pieces a board gets
+    RNG_STATE garbageRng;
+    int rotationSystem; // index into rotationSystems
+    int speedCurve; // index into speedCurves
+
+    int state;
+    int prevState; // used to keep track of state when the game is paused
+    int timer;
+
+    int score;
+    // these two are used to calculate the score
+    int drop;
+    int combo;
+    int level;
+    int ranking;
+    // ranking shown on the rank screen once the game is over
+    int finalRank;
+    int song;
+    // background the frontend should be showing
+    int bg;
+
+    int leftTimer;
+    int rightTimer;
+    int downTimer;
+    int lockTimer;
+    int gravityTimer;
+    int gameOverRow;
 
+    // bit n is set if sound n (see PCM_INDEX) should be played
+    Uint16 sounds;
+    // GAME_EVENT flags
+    Uint16 events;
+    // buttons held on the last tick, used to find new presses
+    Uint16 prevHeld;
+
+    // versus mode: garbage rows waiting to be pushed in under the stack, and
+    // rows this board has sent that the frontend hasn't passed on yet
+    Uint8 garbageIn;
+    Uint8 garbageOut;
+} GAME_CTX;
+
+// sets up a new game that takes its pieces from (a copy of) rng
+void Game_Reset(GAME_CTX *ctx, RNG_STATE *rng);
+
+// saves everything needed to restore the game later (including the RNG and
+// bg stage)
+void Game_Snapshot(GAME_CTX *ctx, GAME_CTX *snapshot);
+
+// puts the game back to a snapshot. the whole board is marked as dirty, so
+// the frontend redraws it without needing anything else
+void Game_Restore(GAME_CTX *ctx, GAME_CTX *snapshot);
+
+// advances the game by one tick with the given buttons held (PadData1 format),
+// returns 1 once the game is over
+int Game_Step(GAME_CTX *ctx, Uint16 held);
+
+// queues garbage rows, they get added before the board's next piece spawns
+void Game_AddGarbage(GAME_CTX *ctx, int rows);
+
+// returns how many rows the piece can fall before it lands
+int Game_DropDistance(GAME_CTX *ctx, PIECE *piece);
+
+// returns 1 if a piece can fit on the board
+int Game_CheckPiece(GAME_CTX *ctx, PIECE *piece);
+
+// rotates a piece (dir is ROTATE_CLOCKWISE or ROTATE_COUNTERCLOCKWISE) with the
+// same kicks the player gets, returns 0 and leaves the piece alone if it can't
+int Game_Rotate(GAME_CTX *ctx, PIECE *piece, int dir);
+
+#endif
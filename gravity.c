@@ -0,0 +1,9 @@
+#include "gravity.h"
+
+int ranks[] = {
+    0, 800, 2000, 5500, 1200, 22000, 40000, 60000, 80000, 999999
+};
+
+int songs[] = {
+    0, 200, 500, 800, 9999
+};
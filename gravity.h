@@ -1,28 +1,10 @@
 #ifndef GRAVITY_H
 #define GRAVITY_H
 
-int levels[] = {
-    0, 30, 35, 40, 50, 60, 70, 80, 90,
-    100, 120, 140, 160, 170,
-    200, 220, 230, 233, 236, 239, 243, 247, 251,
-    300, 330, 360,
-    400, 420, 450,
-    500,
-    1000,
-};
+// score needed for each ranking
+extern int ranks[];
 
-int gravity[] = {
-    4, 6, 8, 10, 12, 16, 32, 48, 64, 80, 96, 112, 128, 144,
-    4, 32, 64, 96, 128, 160, 192, 224, 256, 512, 768, 1024,
-    1280, 1024, 768, 5120
-};
-
-int ranks[] = {
-    0, 800, 2000, 5500, 1200, 22000, 40000, 60000, 80000, 999999
-};
-
-int songs[] = {
-    0, 200, 500, 800, 9999
-};
+// level each song starts at (the last one is never reached)
+extern int songs[];
 
 #endif
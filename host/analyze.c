@@ -0,0 +1,349 @@
+// post-game analysis of a replay: plays it back, and for every piece works
+// out the fewest presses that would have put it where the player did
+// (finesse), and whether the board and the pieces coming up from the game's
+// RNG had a perfect clear in them that the player didn't take. the searches
+// for each piece are independent, so they're shared out between threads.
+//
+// prints one line per piece and a summary at the end (-q for just the
+// summary). -b plays a game with the bot instead of reading a replay, for
+// trying it out without a Saturn
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../bot.h"
+#include "../game.h"
+#include "../speed.h"
+#include "../vblank.h"
+#include "movegen.h"
+#include "replayinput.h"
+#include "solver.h"
+
+// longest a -b game can run before it's cut off (an hour and a half of play)
+#define DEFAULT_MAX_TICKS (60 * 60 * 90)
+#define MAX_THREADS (256)
+// pieces the perfect clear search looks ahead by default
+#define DEFAULT_LOOKAHEAD (6)
+// the buttons finesse counts presses of
+#define FINESSE_BUTTONS (PAD_L | PAD_R | PAD_B | PAD_C)
+
+typedef struct {
+    // the board when the piece spawned, and the pieces from then on
+    Uint16 rows[GAME_ROWS + (BOARD_PAD * 2)];
+    Uint8 pieces[SOLVER_MAX_DEPTH];
+    int level;
+    int sonic;
+    // where the player put it, and the presses it took (counted from the
+    // last piece locking, so moves charged during the spawn delay count)
+    int top;
+    uint64_t cells;
+    int presses;
+    int cleared; // the player got a perfect clear with this piece
+
+    // filled in by the workers
+    int optimal; // -1 if the search couldn't find the player's placement
+    int clearIn; // pieces to a perfect clear from here, 0 if there isn't one
+} JOB;
+
+static JOB *jobs;
+static int jobCount;
+static int lookahead = DEFAULT_LOOKAHEAD;
+static int nextJob;
+static int finalLevel;
+
+static double Analyze_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+// has the bot play a game, returns the buttons it held on each tick
+static Uint16 *Analyze_BotGame(uint64_t seed, uint32_t *ticks) {
+    static GAME_CTX ctx;
+    static BOT bot;
+    RNG_STATE rng;
+    Uint16 *inputs = malloc(DEFAULT_MAX_TICKS * sizeof(Uint16));
+
+    if (!inputs) {
+        return NULL;
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    RNG_Seed(&rng, seed, 0);
+    Game_Reset(&ctx, &rng);
+    Bot_Init(&bot, &botDefaultWeights, 0);
+
+    for (*ticks = 0; *ticks < DEFAULT_MAX_TICKS;) {
+        Uint16 held = Bot_Input(&bot, &ctx);
+        inputs[(*ticks)++] = held;
+        if (Game_Step(&ctx, held)) {
+            break;
+        }
+    }
+    return inputs;
+}
+
+static int Analyze_AddJob(int *capacity) {
+    if (jobCount == *capacity) {
+        *capacity = *capacity ? (*capacity * 2) : 1024;
+        JOB *bigger = realloc(jobs, *capacity * sizeof(JOB));
+        if (!bigger) {
+            return -1;
+        }
+        jobs = bigger;
+    }
+    memset(&jobs[jobCount], 0, sizeof(JOB));
+    return jobCount++;
+}
+
+// plays the game back the same way Replay_Reset starts it, and makes a job for
+// every piece that locked. returns 0 if out of memory
+static int Analyze_Play(uint64_t seed, const Uint16 *inputs, uint32_t ticks) {
+    static GAME_CTX ctx;
+    static GAME_CTX before;
+    RNG_STATE rng;
+    int capacity = 0;
+    int job = -1;
+    int presses = 0;
+
+    RNG_Seed(&rng, seed, 0);
+    memset(&ctx, 0, sizeof(ctx));
+    Game_Reset(&ctx, &rng);
+
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        Uint16 held = inputs[tick];
+
+        // a new piece (the first one's there from the start)
+        if ((ctx.state == GAME_STATE_NORMAL) && (job == -1)) {
+            job = Analyze_AddJob(&capacity);
+            if (job < 0) {
+                return 0;
+            }
+            JOB *newJob = &jobs[job];
+            RNG_STATE upcoming = ctx.rng;
+            memcpy(newJob->rows, ctx.boardRows, sizeof(newJob->rows));
+            newJob->pieces[0] = ctx.currPiece.num;
+            newJob->pieces[1] = ctx.nextPiece.num;
+            for (int i = 2; i < SOLVER_MAX_DEPTH; i++) {
+                newJob->pieces[i] = RNG_Get(&upcoming);
+            }
+            newJob->level = ctx.level;
+            int level = (ctx.level < SPEED_LEVELS) ? ctx.level : (SPEED_LEVELS - 1);
+            newJob->sonic = speedCurves[ctx.speedCurve][level].gravity >= 256;
+        }
+
+        presses += __builtin_popcount(held & ~ctx.prevHeld & FINESSE_BUTTONS);
+        before = ctx;
+        int over = Game_Step(&ctx, held);
+        ctx.sounds = 0;
+        ctx.events = 0;
+
+        PIECE piece;
+        if ((job != -1) && Movegen_Locked(&before, &ctx, &piece)) {
+            JOB *lockedJob = &jobs[job];
+            lockedJob->top = Movegen_Cells(&piece, &lockedJob->cells);
+            lockedJob->presses = presses;
+            lockedJob->cleared = 1;
+            for (int y = 0; y < GAME_ROWS; y++) {
+                if (BOARD_ROW(&ctx, y) != ROW_EMPTY) {
+                    lockedJob->cleared = 0;
+                }
+            }
+            presses = 0;
+            job = -1;
+        }
+        if (over) {
+            break;
+        }
+    }
+    finalLevel = ctx.level;
+
+    // a piece that never locked (topped out or the replay ended) isn't
+    // counted
+    if (job != -1) {
+        jobCount--;
+    }
+    return 1;
+}
+
+static void *Analyze_Worker(void *arg) {
+    SOLVER *solver = malloc(sizeof(SOLVER));
+    (void)arg;
+
+    if (!solver) {
+        return NULL;
+    }
+    Solver_Init(solver);
+    for (;;) {
+        int i = __atomic_fetch_add(&nextJob, 1, __ATOMIC_RELAXED);
+        if (i >= jobCount) {
+            break;
+        }
+        JOB *job = &jobs[i];
+        job->optimal = Solver_Finesse(solver, job->rows, job->pieces[0], job->sonic, job->top, job->cells);
+        job->clearIn = Solver_PerfectClear(solver, job->rows, job->pieces, lookahead, job->sonic);
+    }
+    free(solver);
+    return NULL;
+}
+
+static void Analyze_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-j threads] [-p perfect clear lookahead] [-q (summary only)] (replay | -b seed)\n",
+        name);
+}
+
+int main(int argc, char **argv) {
+    static const char pieceNames[PIECE_COUNT] = {'I', 'Z', 'S', 'J', 'L', 'O', 'T'};
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *filename = NULL;
+    int useBot = 0;
+    uint64_t seed = 0;
+    int quiet = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+            continue;
+        }
+        if (argv[i][0] != '-') {
+            filename = argv[i];
+            continue;
+        }
+        if ((i + 1 == argc) || (strlen(argv[i]) != 2)) {
+            Analyze_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'j':
+                threads = atoi(argv[++i]);
+                break;
+
+            case 'p':
+                lookahead = atoi(argv[++i]);
+                break;
+
+            case 'b':
+                useBot = 1;
+                seed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            default:
+                Analyze_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if ((useBot == (filename != NULL)) || (lookahead < 0) || (lookahead > SOLVER_MAX_DEPTH)) {
+        Analyze_Usage(argv[0]);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    Uint16 *inputs;
+    uint32_t ticks;
+    if (useBot) {
+        inputs = Analyze_BotGame(seed, &ticks);
+    }
+    else {
+        int size;
+        uint8_t *buf = ReplayInput_ReadFile(filename, &size);
+        if (!buf) {
+            fprintf(stderr, "couldn't read %s\n", filename);
+            return 1;
+        }
+        inputs = ReplayInput_Decode(buf, size, &seed, &ticks, NULL);
+        free(buf);
+        if (!inputs) {
+            fprintf(stderr, "%s isn't a replay or is damaged\n", filename);
+            return 1;
+        }
+    }
+    if (!inputs || !Analyze_Play(seed, inputs, ticks)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    double start = Analyze_Seconds();
+    pthread_t ids[MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&ids[i], NULL, Analyze_Worker, NULL) != 0) {
+            fprintf(stderr, "couldn't start thread %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = Analyze_Seconds() - start;
+
+    uint64_t presses = 0;
+    uint64_t optimal = 0;
+    uint64_t wastedTotal = 0;
+    int faults = 0;
+    int unknown = 0;
+    int clears = 0;
+    int missed = 0;
+    int made = 0;
+    if (!quiet) {
+        printf("piece level type presses optimal wasted perfect-clear\n");
+    }
+    for (int i = 0; i < jobCount; i++) {
+        JOB *job = &jobs[i];
+        int wasted = 0;
+
+        if (job->optimal >= 0) {
+            // a button held over from the last piece can beat the count
+            wasted = (job->presses > job->optimal) ? (job->presses - job->optimal) : 0;
+            presses += job->presses;
+            optimal += job->optimal;
+            wastedTotal += wasted;
+            faults += (wasted > 0);
+        }
+        else {
+            unknown++;
+        }
+        made += job->cleared;
+
+        const char *clear = "-";
+        char clearText[32];
+        if (job->clearIn) {
+            int taken = 0;
+            for (int j = i; (j < i + job->clearIn) && (j < jobCount); j++) {
+                taken |= jobs[j].cleared;
+            }
+            clears++;
+            missed += !taken;
+            snprintf(clearText, sizeof(clearText), "%d %s", job->clearIn, taken ? "taken" : "missed");
+            clear = clearText;
+        }
+
+        if (!quiet) {
+            if (job->optimal >= 0) {
+                printf("%d %d %c %d %d %d %s\n", i, job->level, pieceNames[job->pieces[0]], job->presses,
+                    job->optimal, wasted, clear);
+            }
+            else {
+                printf("%d %d %c %d ? ? %s\n", i, job->level, pieceNames[job->pieces[0]], job->presses, clear);
+            }
+        }
+    }
+
+    printf("seed %llu\n", (unsigned long long)seed);
+    printf("ticks %u\n", ticks);
+    printf("level %d\n", finalLevel);
+    printf("pieces %d\n", jobCount);
+    printf("presses %llu (fewest possible %llu)\n", (unsigned long long)presses, (unsigned long long)optimal);
+    printf("wasted presses %llu on %d pieces\n", (unsigned long long)wastedTotal, faults);
+    printf("placements not found %d\n", unknown);
+    printf("perfect clears open %d, missed %d, made %d\n", clears, missed, made);
+    printf("threads %ld\n", threads);
+    printf("seconds %.3f\n", elapsed);
+    return 0;
+}
@@ -0,0 +1,736 @@
+// steps many games at once for tuning runs. the state is split into one
+// array per field, and most ticks (a piece falling or locking in place, or a
+// line clear or spawn delay counting down, with nothing held) are run with
+// SSE2 for 8 boards per instruction. that works because each board keeps the
+// number of rows its piece can fall, which only changes on the ticks that go
+// the slow way. the rest run board by board, where a piece is tested against
+// the board with one 64 bit AND: the four board rows under the piece are
+// loaded as a single word and checked against the piece's mask already
+// shifted to its column. full rows are found the same way, four at a time
+//
+// this follows game.c line for line (including its quirks), and batchsim -c
+// checks the two against each other tick by tick
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../gravity.h"
+#include "../piece.h"
+#include "../release.h"
+#include "../rotate.h"
+#include "../speed.h"
+#include "../vblank.h"
+#include "batch.h"
+
+// every board uses the default rotation system and speed curve, like
+// Game_Reset sets up
+#define BATCH_ROTATION (ROTATION_ARS)
+#define BATCH_SPEED_CURVE (SPEED_NORMAL)
+
+// a piece's mask rows, shifted to board column x at index x + BOARD_WALL and
+// packed the way Batch_Window loads the board
+#define SHIFTS (16)
+static uint64_t pieceWindows[PIECE_COUNT][PIECE_ROTATIONS][SHIFTS];
+// 1 in the low bit of each row in a window
+#define WINDOW_LOW (0x0001000100010001ULL)
+#define WINDOW_HIGH (0x8000800080008000ULL)
+
+static void Batch_MakeWindows() {
+    for (int num = 0; num < PIECE_COUNT; num++) {
+        for (int rotation = 0; rotation < PIECE_ROTATIONS; rotation++) {
+            for (int shift = 0; shift < SHIFTS; shift++) {
+                uint64_t window = 0;
+                for (int y = 0; y < PIECE_SIZE; y++) {
+                    Uint16 row = (Uint16)(pieceMasks[num][rotation][y] << shift);
+                    window |= (uint64_t)row << (y * 16);
+                }
+                pieceWindows[num][rotation][shift] = window;
+            }
+        }
+    }
+}
+
+// board rows y to y + 3 as one word, row y in the low 16 bits
+static inline uint64_t Batch_Window(const Uint16 *rows, int y) {
+    uint64_t window;
+    memcpy(&window, &rows[y + BOARD_PAD], sizeof(window));
+    return window;
+}
+
+static inline int Batch_Collide(const Uint16 *rows, int num, int rotation, int x, int y) {
+    return (Batch_Window(rows, y) & pieceWindows[num][rotation][x + BOARD_WALL]) != 0;
+}
+
+static inline const SPEED *Batch_Speed(BATCH *batch, int i) {
+    int level = batch->level[i];
+    if (level >= SPEED_LEVELS) {
+        level = SPEED_LEVELS - 1;
+    }
+    return &speedCurves[BATCH_SPEED_CURVE][level];
+}
+
+int Batch_Init(BATCH *batch, int count) {
+    // rounded up so the SSE loop doesn't need a tail
+    int padded = (count + 7) & ~7;
+
+    memset(batch, 0, sizeof(*batch));
+    batch->count = count;
+#define BATCH_ALLOC(field, n) \
+    if (!(batch->field = aligned_alloc(64, ((n) * sizeof(*batch->field) + 63) & ~63))) { \
+        Batch_Free(batch); \
+        return 0; \
+    }
+    BATCH_ALLOC(held, padded);
+    BATCH_ALLOC(pressed, padded);
+    BATCH_ALLOC(rows, padded * BATCH_STRIDE);
+    BATCH_ALLOC(pieceX, padded);
+    BATCH_ALLOC(pieceY, padded);
+    BATCH_ALLOC(pieceNum, padded);
+    BATCH_ALLOC(pieceRotation, padded);
+    BATCH_ALLOC(nextNum, padded);
+    BATCH_ALLOC(rng, padded);
+    BATCH_ALLOC(state, padded);
+    BATCH_ALLOC(prevState, padded);
+    BATCH_ALLOC(timer, padded);
+    BATCH_ALLOC(score, padded);
+    BATCH_ALLOC(drop, padded);
+    BATCH_ALLOC(combo, padded);
+    BATCH_ALLOC(level, padded);
+    BATCH_ALLOC(ranking, padded);
+    BATCH_ALLOC(finalRank, padded);
+    BATCH_ALLOC(song, padded);
+    BATCH_ALLOC(bg, padded);
+    BATCH_ALLOC(leftTimer, padded);
+    BATCH_ALLOC(rightTimer, padded);
+    BATCH_ALLOC(downTimer, padded);
+    BATCH_ALLOC(lockTimer, padded);
+    BATCH_ALLOC(gravityTimer, padded);
+    BATCH_ALLOC(gameOverRow, padded);
+    BATCH_ALLOC(clearedRows, padded);
+    BATCH_ALLOC(prevHeld, padded);
+    BATCH_ALLOC(groundDist, padded);
+    BATCH_ALLOC(gravity, padded);
+    BATCH_ALLOC(lockFrames, padded);
+#undef BATCH_ALLOC
+
+    // the padding boards never do anything
+    memset(batch->held, 0, padded * sizeof(*batch->held));
+    memset(batch->prevHeld, 0, padded * sizeof(*batch->prevHeld));
+    memset(batch->groundDist, 0, padded * sizeof(*batch->groundDist));
+    memset(batch->gravity, 0, padded * sizeof(*batch->gravity));
+    memset(batch->lockFrames, 0, padded * sizeof(*batch->lockFrames));
+    for (int i = 0; i < padded; i++) {
+        batch->state[i] = GAME_STATE_GAMEOVER_DONE;
+    }
+    Batch_MakeWindows();
+    return 1;
+}
+
+void Batch_Free(BATCH *batch) {
+    free(batch->held);
+    free(batch->pressed);
+    free(batch->rows);
+    free(batch->pieceX);
+    free(batch->pieceY);
+    free(batch->pieceNum);
+    free(batch->pieceRotation);
+    free(batch->nextNum);
+    free(batch->rng);
+    free(batch->state);
+    free(batch->prevState);
+    free(batch->timer);
+    free(batch->score);
+    free(batch->drop);
+    free(batch->combo);
+    free(batch->level);
+    free(batch->ranking);
+    free(batch->finalRank);
+    free(batch->song);
+    free(batch->bg);
+    free(batch->leftTimer);
+    free(batch->rightTimer);
+    free(batch->downTimer);
+    free(batch->lockTimer);
+    free(batch->gravityTimer);
+    free(batch->gameOverRow);
+    free(batch->clearedRows);
+    free(batch->prevHeld);
+    free(batch->groundDist);
+    free(batch->gravity);
+    free(batch->lockFrames);
+    memset(batch, 0, sizeof(*batch));
+}
+
+static void Batch_ClearBoard(Uint16 *rows) {
+    for (int i = 0; i < BOARD_PAD; i++) {
+        rows[i] = ROW_FULL;
+        rows[GAME_ROWS + BOARD_PAD + i] = ROW_FULL;
+    }
+    for (int y = 0; y < GAME_ROWS; y++) {
+        rows[y + BOARD_PAD] = ROW_EMPTY;
+    }
+    // the spare rows at the end act as more floor
+    for (int y = GAME_ROWS + (BOARD_PAD * 2); y < BATCH_STRIDE; y++) {
+        rows[y] = ROW_FULL;
+    }
+}
+
+// rows the piece can fall before it lands
+static inline int Batch_DropDistance(const Uint16 *rows, int num, int rotation, int x, int y) {
+    uint64_t mask = pieceWindows[num][rotation][x + BOARD_WALL];
+    int dist = 0;
+
+    while (!(Batch_Window(rows, y + dist + 1) & mask)) {
+        dist++;
+    }
+    return dist;
+}
+
+// fills in the fields the fast path reads
+static void Batch_Cache(BATCH *batch, int i) {
+    const SPEED *speed = Batch_Speed(batch, i);
+    batch->gravity[i] = speed->gravity;
+    batch->lockFrames[i] = speed->lockFrames;
+    if (batch->state[i] == GAME_STATE_NORMAL) {
+        batch->groundDist[i] = Batch_DropDistance(&batch->rows[i * BATCH_STRIDE], batch->pieceNum[i],
+            batch->pieceRotation[i], batch->pieceX[i], batch->pieceY[i]);
+    }
+}
+
+static void Batch_MakePiece(BATCH *batch, int i) {
+    batch->pieceNum[i] = batch->nextNum[i];
+    batch->pieceRotation[i] = 0;
+    batch->pieceX[i] = SPAWN_X;
+    batch->pieceY[i] = SPAWN_Y;
+    batch->nextNum[i] = RNG_Get(&batch->rng[i]);
+}
+
+void Batch_Reset(BATCH *batch, int board, RNG_STATE *rng) {
+    int i = board;
+
+    batch->rng[i] = *rng;
+    batch->clearedRows[i] = 0;
+    Batch_ClearBoard(&batch->rows[i * BATCH_STRIDE]);
+
+    batch->state[i] = GAME_STATE_NORMAL;
+    batch->prevState[i] = GAME_STATE_NORMAL;
+    batch->timer[i] = 0;
+
+    batch->score[i] = 0;
+    batch->drop[i] = 0;
+    batch->combo[i] = 1;
+    batch->level[i] = 0;
+    batch->ranking[i] = 0;
+    batch->finalRank[i] = 0;
+    batch->song[i] = 0;
+    batch->bg[i] = 0;
+
+    batch->leftTimer[i] = MOVE_FRAMES;
+    batch->rightTimer[i] = MOVE_FRAMES;
+    batch->downTimer[i] = DOWN_FRAMES;
+    batch->lockTimer[i] = -1;
+    batch->gravityTimer[i] = 0;
+    batch->gameOverRow[i] = 0;
+    batch->prevHeld[i] = 0xFFFF;
+
+    batch->nextNum[i] = RNG_Get(&batch->rng[i]);
+    Batch_MakePiece(batch, i);
+    Batch_Cache(batch, i);
+}
+
+// moves the piece down up to the given number of rows (like Game_Drop, a
+// negative number moves it up)
+static inline void Batch_Drop(BATCH *batch, int i, const Uint16 *rows, int count) {
+    int dist = Batch_DropDistance(rows, batch->pieceNum[i], batch->pieceRotation[i], batch->pieceX[i], batch->pieceY[i]);
+    if (count > dist) {
+        count = dist;
+    }
+    batch->pieceY[i] += count;
+    batch->drop[i] += count;
+}
+
+static int Batch_CanKick(const Uint16 *rows, int num, int rotation, int x, int y, Uint8 centerMask) {
+    const Uint8 *mask = pieceMasks[num][rotation];
+    int shift = x + BOARD_WALL;
+    for (int row = 0; row < PIECE_SIZE; row++) {
+        int overlap = (rows[y + row + BOARD_PAD] >> shift) & mask[row];
+        if (overlap) {
+            return (overlap & -overlap & centerMask) == 0;
+        }
+    }
+    return 1;
+}
+
+static int Batch_Rotate(BATCH *batch, int i, const Uint16 *rows, int dir) {
+    const ROTATION_SYSTEM *system = &rotationSystems[BATCH_ROTATION];
+    int num = batch->pieceNum[i];
+    const KICK_LIST *list = &system->lists[num][batch->pieceRotation[i]][dir];
+    int baseX = batch->pieceX[i];
+    int baseY = batch->pieceY[i];
+    int rotation = list->to;
+    int canKick = -1;
+
+    for (int k = 0; k < list->count; k++) {
+        const KICK *kick = &list->kicks[k];
+        int testX = baseX;
+        int testY = baseY;
+
+        if (kick->flags & KICK_CEILING) {
+            if ((baseY != SPAWN_Y) || Batch_Collide(rows, num, rotation, baseX, baseY + 1)) {
+                continue;
+            }
+            baseY += kick->y;
+            testY = baseY;
+        }
+        else {
+            if (kick->flags & KICK_CENTER) {
+                if (canKick == -1) {
+                    canKick = Batch_CanKick(rows, num, rotation, baseX, baseY, system->centerMask);
+                }
+                if (!canKick) {
+                    continue;
+                }
+            }
+            testX += kick->x;
+            testY += kick->y;
+        }
+
+        if (!Batch_Collide(rows, num, rotation, testX, testY)) {
+            batch->pieceX[i] = testX;
+            batch->pieceY[i] = testY;
+            batch->pieceRotation[i] = rotation;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static inline int Batch_CanMoveLeft(BATCH *batch, int i, Uint16 held, Uint16 pressed) {
+    if (pressed & PAD_L) {
+        batch->leftTimer[i] = MOVE_FRAMES;
+        return 1;
+    }
+    else if (held & PAD_L) {
+        if (batch->leftTimer[i] == 0) {
+            batch->leftTimer[i] = DAS_FRAMES;
+            return 1;
+        }
+        else {
+            batch->leftTimer[i] -= Batch_Speed(batch, i)->dasStep;
+        }
+    }
+    return 0;
+}
+
+static inline int Batch_CanMoveRight(BATCH *batch, int i, Uint16 held, Uint16 pressed) {
+    if (pressed & PAD_R) {
+        batch->rightTimer[i] = MOVE_FRAMES;
+        return 1;
+    }
+    else if (held & PAD_R) {
+        if (batch->rightTimer[i] == 0) {
+            batch->rightTimer[i] = DAS_FRAMES;
+            return 1;
+        }
+        else {
+            batch->rightTimer[i] -= Batch_Speed(batch, i)->dasStep;
+        }
+    }
+    return 0;
+}
+
+static inline int Batch_CanMoveDown(BATCH *batch, int i, Uint16 held, Uint16 pressed) {
+    if (pressed & (PAD_D | PAD_A)) {
+        batch->downTimer[i] = DOWN_FRAMES;
+        return 1;
+    }
+    else if (held & (PAD_D | PAD_A)) {
+        if (batch->downTimer[i] == 0) {
+            batch->downTimer[i] = DOWN_FRAMES;
+            return 1;
+        }
+        else {
+            batch->downTimer[i]--;
+        }
+    }
+
+    batch->gravityTimer[i]--;
+    return 0;
+}
+
+// copies the piece to the board and clears the rows it filled (without
+// moving anything down yet), returns the number of lines
+static int Batch_Lock(BATCH *batch, int i, Uint16 *rows) {
+    int y = batch->pieceY[i];
+    uint64_t window = Batch_Window(rows, y) |
+        pieceWindows[batch->pieceNum[i]][batch->pieceRotation[i]][batch->pieceX[i] + BOARD_WALL];
+    memcpy(&rows[y + BOARD_PAD], &window, sizeof(window));
+
+    // a row is full when its inverse is zero
+    uint64_t empty = ~window;
+    uint64_t full = (empty - WINDOW_LOW) & ~empty & WINDOW_HIGH;
+    batch->clearedRows[i] = 0;
+    if (!full) {
+        return 0;
+    }
+
+    int lines = 0;
+    for (int row = 0; row < PIECE_SIZE; row++) {
+        // the padding rows are always full, only playfield rows count
+        if ((full & (0x8000ULL << (row * 16))) && (y + row >= 0) && (y + row < GAME_ROWS)) {
+            rows[y + row + BOARD_PAD] = ROW_EMPTY;
+            batch->clearedRows[i] |= (1 << (y + row));
+            lines++;
+        }
+    }
+    return lines;
+}
+
+// the piece lands for good: the end of a GAME_STATE_NORMAL tick that locks
+static void Batch_LockPiece(BATCH *batch, int i, Uint16 *rows, Uint16 held) {
+    batch->lockTimer[i] = -1;
+    batch->drop[i] = 0;
+
+    int lines = Batch_Lock(batch, i, rows);
+    int oldLevel = batch->level[i];
+    if (lines) {
+        batch->state[i] = GAME_STATE_LINE;
+        batch->combo[i] = batch->combo[i] + (lines * 2) - 2;
+        batch->level[i] += lines;
+        batch->timer[i] = Batch_Speed(batch, i)->lineFrames;
+        batch->score[i] += ((((batch->level[i] + lines) / 4) + 1) + batch->drop[i]) * lines * batch->combo[i];
+        while (batch->score[i] >= ranks[batch->ranking[i] + 1]) {
+            batch->ranking[i]++;
+        }
+    }
+    else {
+        batch->combo[i] = 1;
+        batch->state[i] = GAME_STATE_ARE;
+        batch->timer[i] = Batch_Speed(batch, i)->areFrames;
+    }
+
+    if (DEBUG && (held & PAD_Y)) {
+        batch->level[i] += 50;
+    }
+
+    int level = batch->level[i];
+    if ((level < 600) && ((level / 100) > (oldLevel / 100))) {
+        batch->bg[i]++;
+    }
+    else if ((level >= 800) && (level < 900) && ((level / 100) > (oldLevel / 100))) {
+        batch->bg[i]++;
+    }
+
+    if (level > 999) {
+        batch->finalRank[i] = FINISH_RANK;
+        batch->state[i] = GAME_STATE_GAMEOVER_DONE;
+    }
+
+    int song = batch->song[i];
+    if ((oldLevel < songs[song + 1]) && (level >= songs[song + 1])) {
+        batch->song[i]++;
+    }
+}
+
+static void Batch_Normal(BATCH *batch, int i, Uint16 held, Uint16 pressed) {
+    Uint16 *rows = &batch->rows[i * BATCH_STRIDE];
+
+    if (DEBUG && (pressed & PAD_Z)) {
+        Batch_ClearBoard(rows);
+    }
+
+    if (pressed & PAD_C) {
+        Batch_Rotate(batch, i, rows, ROTATE_CLOCKWISE);
+    }
+    if (pressed & PAD_B) {
+        Batch_Rotate(batch, i, rows, ROTATE_COUNTERCLOCKWISE);
+    }
+
+    int below = Batch_Collide(rows, batch->pieceNum[i], batch->pieceRotation[i], batch->pieceX[i], batch->pieceY[i] + 1);
+    if ((batch->lockTimer[i] == -1) && below) {
+        batch->lockTimer[i] = Batch_Speed(batch, i)->lockFrames;
+        if (held & (PAD_D | PAD_A)) {
+            batch->lockTimer[i] = 0;
+        }
+    }
+    else if (!below) {
+        batch->lockTimer[i] = -1;
+    }
+
+    // hard drop
+    if ((held & PAD_U) && (batch->lockTimer[i] == -1)) {
+        Batch_Drop(batch, i, rows, GAME_ROWS);
+        batch->lockTimer[i] = Batch_Speed(batch, i)->lockFrames;
+    }
+
+    // gravity
+    batch->gravityTimer[i] += Batch_Speed(batch, i)->gravity;
+    if (batch->gravityTimer[i] >> 8) {
+        Batch_Drop(batch, i, rows, batch->gravityTimer[i] >> 8);
+        batch->gravityTimer[i] &= 0xFF;
+    }
+
+    // soft drop
+    if (Batch_CanMoveDown(batch, i, held, pressed)) {
+        Batch_Drop(batch, i, rows, 1);
+    }
+
+    if ((batch->lockTimer[i] > 0) && (held & (PAD_D | PAD_A))) {
+        batch->lockTimer[i] = 0;
+    }
+
+    if (batch->lockTimer[i] == 0) {
+        Batch_LockPiece(batch, i, rows, held);
+    }
+    else if (batch->lockTimer[i] > 0) {
+        batch->lockTimer[i]--;
+    }
+
+    // horizontal movement
+    if (Batch_CanMoveLeft(batch, i, held, pressed)) {
+        if (!Batch_Collide(rows, batch->pieceNum[i], batch->pieceRotation[i], batch->pieceX[i] - 1, batch->pieceY[i])) {
+            batch->pieceX[i]--;
+        }
+    }
+    if (Batch_CanMoveRight(batch, i, held, pressed)) {
+        if (!Batch_Collide(rows, batch->pieceNum[i], batch->pieceRotation[i], batch->pieceX[i] + 1, batch->pieceY[i])) {
+            batch->pieceX[i]++;
+        }
+    }
+}
+// moves everything above the cleared rows down
+static void Batch_RemoveLines(BATCH *batch, int i) {
+    Uint16 *rows = &batch->rows[i * BATCH_STRIDE];
+    Uint32 cleared = batch->clearedRows[i];
+    int dst = GAME_ROWS - 1;
+
+    for (int src = GAME_ROWS - 1; src >= 0; src--) {
+        if (cleared & (1 << src)) {
+            continue;
+        }
+        rows[dst + BOARD_PAD] = rows[src + BOARD_PAD];
+        dst--;
+    }
+    for (; dst >= 0; dst--) {
+        rows[dst + BOARD_PAD] = ROW_EMPTY;
+    }
+    batch->clearedRows[i] = 0;
+}
+
+static void Batch_Line(BATCH *batch, int i) {
+    if (batch->timer[i] > 0) {
+        batch->timer[i]--;
+    }
+    else {
+        Batch_RemoveLines(batch, i);
+        batch->timer[i] = Batch_Speed(batch, i)->areFrames;
+        batch->state[i] = GAME_STATE_ARE;
+    }
+}
+
+static void Batch_Are(BATCH *batch, int i, Uint16 held, Uint16 pressed) {
+    if (batch->timer[i] > 0) {
+        batch->timer[i]--;
+    }
+    else {
+        Uint16 *rows = &batch->rows[i * BATCH_STRIDE];
+        Batch_MakePiece(batch, i);
+        if (Batch_Collide(rows, batch->pieceNum[i], 0, SPAWN_X, SPAWN_Y)) {
+            uint64_t window = Batch_Window(rows, SPAWN_Y) | pieceWindows[batch->pieceNum[i]][0][SPAWN_X + BOARD_WALL];
+            memcpy(&rows[SPAWN_Y + BOARD_PAD], &window, sizeof(window));
+            batch->state[i] = GAME_STATE_GAMEOVER;
+            batch->timer[i] = GAME_OVER_FRAMES;
+            batch->gameOverRow[i] = 0;
+            return;
+        }
+        if ((batch->level[i] % 100) != 99) {
+            batch->level[i]++;
+        }
+        batch->state[i] = GAME_STATE_NORMAL;
+
+        // buffered rotation
+        if (held & PAD_C) {
+            Batch_Rotate(batch, i, rows, ROTATE_CLOCKWISE);
+        }
+        if (held & PAD_B) {
+            Batch_Rotate(batch, i, rows, ROTATE_COUNTERCLOCKWISE);
+        }
+    }
+    Batch_CanMoveLeft(batch, i, held, pressed);
+    Batch_CanMoveRight(batch, i, held, pressed);
+}
+
+static void Batch_Over(BATCH *batch, int i) {
+    if (batch->timer[i] > 0) {
+        batch->timer[i]--;
+    }
+    else {
+        batch->gameOverRow[i]++;
+        batch->timer[i] = GAME_OVER_FRAMES;
+        if (batch->gameOverRow[i] == GAME_ROWS) {
+            batch->state[i] = GAME_STATE_GAMEOVER_DONE;
+            batch->finalRank[i] = batch->ranking[i];
+        }
+    }
+}
+
+// one tick on a board the slow way
+static void Batch_StepBoard(BATCH *batch, int i) {
+    Uint16 held = batch->held[i];
+    Uint16 pressed = batch->pressed[i];
+    int oldState = batch->state[i];
+    int oldX = batch->pieceX[i];
+    int oldY = batch->pieceY[i];
+    int oldRotation = batch->pieceRotation[i];
+
+    if (pressed & PAD_S) {
+        if (batch->state[i] != GAME_STATE_PAUSED) {
+            batch->prevState[i] = batch->state[i];
+            batch->state[i] = GAME_STATE_PAUSED;
+        }
+        else {
+            batch->state[i] = batch->prevState[i];
+        }
+    }
+
+    switch (batch->state[i]) {
+        case GAME_STATE_NORMAL:
+            Batch_Normal(batch, i, held, pressed);
+            break;
+
+        case GAME_STATE_LINE:
+            Batch_Line(batch, i);
+            break;
+
+        case GAME_STATE_ARE:
+            Batch_Are(batch, i, held, pressed);
+            break;
+
+        case GAME_STATE_GAMEOVER:
+            Batch_Over(batch, i);
+            break;
+    }
+
+    // a piece that only fell is still the same distance from the ground,
+    // minus the rows it fell (the level can't have changed either)
+    int fell = batch->pieceY[i] - oldY;
+    if ((batch->state[i] == GAME_STATE_NORMAL) && (oldState == GAME_STATE_NORMAL) && (fell >= 0) &&
+        (batch->pieceX[i] == oldX) && (batch->pieceRotation[i] == oldRotation) && !(DEBUG && (pressed & PAD_Z))) {
+        batch->groundDist[i] -= fell;
+    }
+    else {
+        Batch_Cache(batch, i);
+    }
+}
+
+#ifdef __SSE2__
+// one tick on the 8 boards from i that have nothing held, where that doesn't
+// need anything but counting down and the piece falling. returns 2 bits per
+// board (like _mm_movemask_epi8) for the boards that still have to run
+// Batch_StepBoard, and sets the bits in *locks for the boards whose piece
+// locked, which still have to run Batch_LockPiece
+static inline int Batch_Fast(BATCH *batch, int i, int *locks) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+
+    __m128i held = _mm_load_si128((__m128i *)&batch->held[i]);
+    __m128i prev = _mm_load_si128((__m128i *)&batch->prevHeld[i]);
+    _mm_store_si128((__m128i *)&batch->pressed[i], _mm_andnot_si128(prev, held));
+    _mm_store_si128((__m128i *)&batch->prevHeld[i], held);
+
+    __m128i idle = _mm_cmpeq_epi16(held, zero);
+    __m128i state = _mm_load_si128((__m128i *)&batch->state[i]);
+    __m128i normal = _mm_and_si128(idle, _mm_cmpeq_epi16(state, _mm_set1_epi16(GAME_STATE_NORMAL)));
+    __m128i counting = _mm_or_si128(_mm_cmpeq_epi16(state, _mm_set1_epi16(GAME_STATE_LINE)),
+        _mm_or_si128(_mm_cmpeq_epi16(state, _mm_set1_epi16(GAME_STATE_ARE)),
+        _mm_cmpeq_epi16(state, _mm_set1_epi16(GAME_STATE_GAMEOVER))));
+    counting = _mm_and_si128(idle, counting);
+
+    // line clear, spawn delay and game over countdowns (adding the all ones
+    // mask subtracts 1), they go the slow way when they run out
+    __m128i timer = _mm_load_si128((__m128i *)&batch->timer[i]);
+    __m128i running = _mm_cmpgt_epi16(timer, zero);
+    timer = _mm_add_epi16(timer, _mm_and_si128(counting, running));
+    _mm_store_si128((__m128i *)&batch->timer[i], timer);
+    __m128i slow = _mm_or_si128(_mm_xor_si128(idle, ones), _mm_andnot_si128(running, counting));
+
+    // Batch_Normal with nothing held, skipping rotation, hard drop and
+    // horizontal movement
+    __m128i ground = _mm_load_si128((__m128i *)&batch->groundDist[i]);
+    __m128i below = _mm_cmpeq_epi16(ground, zero);
+    __m128i lock = _mm_load_si128((__m128i *)&batch->lockTimer[i]);
+    __m128i start = _mm_and_si128(normal, _mm_and_si128(below, _mm_cmpeq_epi16(lock, ones)));
+    __m128i lockFrames = _mm_load_si128((__m128i *)&batch->lockFrames[i]);
+    lock = _mm_or_si128(_mm_andnot_si128(start, lock), _mm_and_si128(start, lockFrames));
+    lock = _mm_or_si128(lock, _mm_andnot_si128(below, normal));
+
+    // gravity, the timer is never negative after this so it only moves down
+    __m128i gravity = _mm_load_si128((__m128i *)&batch->gravity[i]);
+    __m128i gravityTimer = _mm_load_si128((__m128i *)&batch->gravityTimer[i]);
+    gravityTimer = _mm_add_epi16(gravityTimer, _mm_and_si128(normal, gravity));
+    __m128i fall = _mm_srai_epi16(gravityTimer, 8);
+    __m128i falling = _mm_andnot_si128(_mm_cmpeq_epi16(fall, zero), normal);
+    fall = _mm_and_si128(falling, _mm_min_epi16(fall, ground));
+    __m128i y = _mm_load_si128((__m128i *)&batch->pieceY[i]);
+    __m128i drop = _mm_load_si128((__m128i *)&batch->drop[i]);
+    _mm_store_si128((__m128i *)&batch->pieceY[i], _mm_add_epi16(y, fall));
+    _mm_store_si128((__m128i *)&batch->drop[i], _mm_add_epi16(drop, fall));
+    _mm_store_si128((__m128i *)&batch->groundDist[i], _mm_sub_epi16(ground, fall));
+    gravityTimer = _mm_or_si128(_mm_andnot_si128(falling, gravityTimer),
+        _mm_and_si128(falling, _mm_and_si128(gravityTimer, _mm_set1_epi16(0xFF))));
+    // no soft drop
+    gravityTimer = _mm_add_epi16(gravityTimer, normal);
+    _mm_store_si128((__m128i *)&batch->gravityTimer[i], gravityTimer);
+
+    __m128i locking = _mm_and_si128(normal, _mm_cmpeq_epi16(lock, zero));
+    lock = _mm_add_epi16(lock, _mm_and_si128(normal, _mm_cmpgt_epi16(lock, zero)));
+    _mm_store_si128((__m128i *)&batch->lockTimer[i], lock);
+
+    *locks = _mm_movemask_epi8(locking);
+    return _mm_movemask_epi8(slow);
+}
+#endif
+
+int Batch_Step(BATCH *batch) {
+    int count = batch->count;
+    int done = 0;
+
+#ifdef __SSE2__
+    int padded = (count + 7) & ~7;
+    for (int i = 0; i < padded; i += 8) {
+        int locks;
+        int slow = Batch_Fast(batch, i, &locks);
+
+        for (int bits = slow | locks; bits; bits &= bits - 1) {
+            // 2 bits per board
+            int board = i + (__builtin_ctz(bits) >> 1);
+            bits &= bits - 1;
+            if (slow & (1 << ((board - i) * 2))) {
+                Batch_StepBoard(batch, board);
+            }
+            else {
+                Batch_LockPiece(batch, board, &batch->rows[board * BATCH_STRIDE], 0);
+                Batch_Cache(batch, board);
+            }
+        }
+
+        __m128i state = _mm_load_si128((__m128i *)&batch->state[i]);
+        int over = _mm_movemask_epi8(_mm_cmpeq_epi16(state, _mm_set1_epi16(GAME_STATE_GAMEOVER_DONE)));
+        done += __builtin_popcount(over) >> 1;
+    }
+    // the padding boards count as finished
+    done -= padded - count;
+#else
+    for (int i = 0; i < count; i++) {
+        batch->pressed[i] = batch->held[i] & ~batch->prevHeld[i];
+        batch->prevHeld[i] = batch->held[i];
+        Batch_StepBoard(batch, i);
+        done += (batch->state[i] == GAME_STATE_GAMEOVER_DONE);
+    }
+#endif
+    return done;
+}
@@ -0,0 +1,76 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+
+#include <sega_mth.h>
+
+#include "../game.h"
+#include "../rng.h"
+
+// board rows per board, GAME_CTX.boardRows plus spare rows so every board
+// starts on a 64 byte boundary
+#define BATCH_STRIDE (32)
+
+// many single player games stepped in lockstep, stored as structure of
+// arrays (element i of each array belongs to board i). the rules are the same
+// as Game_Step's and give the same results, but only the state the rules read
+// is kept: there are no block colors, column tops, dirty rows, sounds, events
+// or versus garbage
+typedef struct {
+    int count;
+    Uint16 *held; // filled in by the caller before each Batch_Step
+    Uint16 *pressed; // scratch
+
+    // BATCH_STRIDE rows per board, laid out like GAME_CTX.boardRows
+    Uint16 *rows;
+    Sint8 *pieceX;
+    Sint16 *pieceY;
+    Uint8 *pieceNum;
+    Uint8 *pieceRotation;
+    Uint8 *nextNum;
+    RNG_STATE *rng;
+
+    Uint16 *state;
+    Uint8 *prevState;
+    Sint16 *timer;
+    Sint32 *score;
+    Sint16 *drop;
+    Sint32 *combo;
+    Sint32 *level;
+    Sint32 *ranking;
+    Sint32 *finalRank;
+    Sint32 *song;
+    Sint32 *bg;
+
+    Sint32 *leftTimer;
+    Sint32 *rightTimer;
+    Sint32 *downTimer;
+    Sint16 *lockTimer;
+    Sint16 *gravityTimer;
+    Sint32 *gameOverRow;
+    Uint32 *clearedRows;
+    Uint16 *prevHeld;
+
+    // worked out from the rest after every tick that doesn't take the fast
+    // path: rows the piece can fall (while it's in play) and the speed for the
+    // board's level
+    Sint16 *groundDist;
+    Sint16 *gravity;
+    Sint16 *lockFrames;
+} BATCH;
+
+// allocates count boards (not set up yet), returns 0 if out of memory
+int Batch_Init(BATCH *batch, int count);
+
+void Batch_Free(BATCH *batch);
+
+// starts a new game on one board, same as Game_Reset
+void Batch_Reset(BATCH *batch, int board, RNG_STATE *rng);
+
+// runs one tick on every board with the buttons in batch->held. boards whose
+// game is over stay that way until they're reset. returns the number of boards
+// with a finished game
+int Batch_Step(BATCH *batch);
+
+#endif
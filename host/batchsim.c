@@ -0,0 +1,206 @@
+// steps a batch of boards with scripted input and reports how many board
+// ticks per second the batch engine runs. finished games are replaced with
+// new ones right away, so every board is busy for the whole run
+//
+// with -c, every board is also played with Game_Step and the two are
+// compared after every tick, which stops at the first difference. -r mashes
+// random buttons instead of running the script, to also cover pausing and
+// the debug buttons
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../game.h"
+#include "../vblank.h"
+#include "batch.h"
+#include "script.h"
+
+// buttons -r presses, changed about every 8 ticks
+#define RANDOM_BUTTONS (PAD_L | PAD_R | PAD_U | PAD_D | PAD_A | PAD_B | PAD_C | PAD_S | PAD_Y | PAD_Z)
+#define RANDOM_CHANGE (8)
+
+typedef struct {
+    SCRIPT script;
+    Uint16 held; // for -r
+    GAME_CTX ctx; // only used with -c
+} BOARD;
+
+static BATCH batch;
+static BOARD *boards;
+static uint64_t baseSeed;
+static uint64_t gamesStarted;
+static int check;
+static int mash;
+
+static double Batchsim_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static void Batchsim_NewGame(int i) {
+    uint64_t seed = baseSeed + gamesStarted++;
+    RNG_STATE rng;
+
+    RNG_Seed(&rng, seed, 0);
+    Batch_Reset(&batch, i, &rng);
+    Script_Init(&boards[i].script, seed);
+    if (check) {
+        memset(&boards[i].ctx, 0, sizeof(boards[i].ctx));
+        Game_Reset(&boards[i].ctx, &rng);
+    }
+}
+
+// returns the name of the first field that's different, or NULL if they match
+static const char *Batchsim_Compare(int i, GAME_CTX *ctx) {
+    if (memcmp(&batch.rows[i * BATCH_STRIDE], ctx->boardRows, sizeof(ctx->boardRows)) != 0) {
+        return "boardRows";
+    }
+#define COMPARE(field, value) \
+    if ((batch.field[i]) != (value)) { \
+        return #field; \
+    }
+    COMPARE(pieceX, ctx->currPiece.x);
+    COMPARE(pieceY, ctx->currPiece.y);
+    COMPARE(pieceNum, ctx->currPiece.num);
+    COMPARE(pieceRotation, ctx->currPiece.rotation);
+    COMPARE(nextNum, ctx->nextPiece.num);
+    COMPARE(state, ctx->state);
+    COMPARE(prevState, ctx->prevState);
+    COMPARE(timer, ctx->timer);
+    COMPARE(score, ctx->score);
+    COMPARE(drop, ctx->drop);
+    COMPARE(combo, ctx->combo);
+    COMPARE(level, ctx->level);
+    COMPARE(ranking, ctx->ranking);
+    COMPARE(finalRank, ctx->finalRank);
+    COMPARE(song, ctx->song);
+    COMPARE(bg, ctx->bg);
+    COMPARE(leftTimer, ctx->leftTimer);
+    COMPARE(rightTimer, ctx->rightTimer);
+    COMPARE(downTimer, ctx->downTimer);
+    COMPARE(lockTimer, ctx->lockTimer);
+    COMPARE(gravityTimer, ctx->gravityTimer);
+    COMPARE(gameOverRow, ctx->gameOverRow);
+    COMPARE(clearedRows, ctx->clearedRows);
+    COMPARE(prevHeld, ctx->prevHeld);
+#undef COMPARE
+    if (memcmp(&batch.rng[i], &ctx->rng, sizeof(ctx->rng)) != 0) {
+        return "rng";
+    }
+    return NULL;
+}
+
+static Uint16 Batchsim_Input(BOARD *board) {
+    if (!mash) {
+        return Script_Next(&board->script);
+    }
+    // the script's RNG is reused for the buttons
+    Uint32 random = RNG_Next(&board->script.rng);
+    if ((random % RANDOM_CHANGE) == 0) {
+        board->held = (random >> 16) & RANDOM_BUTTONS;
+    }
+    return board->held;
+}
+
+static void Batchsim_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n boards] [-t ticks] [-s seed] [-c (check against Game_Step)] "
+        "[-r (random buttons)]\n", name);
+}
+
+int main(int argc, char **argv) {
+    int count = 4096;
+    uint64_t ticks = 10000;
+    baseSeed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            check = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "-r") == 0) {
+            mash = 1;
+            continue;
+        }
+        if ((i + 1 == argc) || (argv[i][0] != '-') || (strlen(argv[i]) != 2)) {
+            Batchsim_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'n':
+                count = atoi(argv[++i]);
+                break;
+
+            case 't':
+                ticks = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 's':
+                baseSeed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            default:
+                Batchsim_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (count < 1) {
+        Batchsim_Usage(argv[0]);
+        return 1;
+    }
+
+    boards = calloc(count, sizeof(BOARD));
+    if (!boards || !Batch_Init(&batch, count)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        Batchsim_NewGame(i);
+    }
+
+    double elapsed = 0;
+    uint64_t games = 0;
+    for (uint64_t tick = 0; tick < ticks; tick++) {
+        for (int i = 0; i < count; i++) {
+            batch.held[i] = Batchsim_Input(&boards[i]);
+        }
+
+        double start = Batchsim_Seconds();
+        int done = Batch_Step(&batch);
+        elapsed += Batchsim_Seconds() - start;
+
+        if (check) {
+            for (int i = 0; i < count; i++) {
+                GAME_CTX *ctx = &boards[i].ctx;
+                Game_Step(ctx, batch.held[i]);
+                const char *field = Batchsim_Compare(i, ctx);
+                if (field) {
+                    printf("board %d differs from Game_Step at tick %llu: %s\n", i, (unsigned long long)tick, field);
+                    return 1;
+                }
+            }
+        }
+
+        if (done) {
+            for (int i = 0; i < count; i++) {
+                if (batch.state[i] == GAME_STATE_GAMEOVER_DONE) {
+                    games++;
+                    Batchsim_NewGame(i);
+                }
+            }
+        }
+    }
+
+    double steps = (double)count * ticks;
+    printf("boards %d\n", count);
+    printf("ticks %llu\n", (unsigned long long)ticks);
+    printf("games finished %llu\n", (unsigned long long)games);
+    printf("seconds %.3f\n", elapsed);
+    printf("board ticks/sec %.0f\n", (elapsed > 0) ? (steps / elapsed) : 0.0);
+    if (check) {
+        printf("matched Game_Step on every tick\n");
+    }
+    return 0;
+}
@@ -0,0 +1,519 @@
+// times the engine's hot paths on the host and compares them against stored
+// baselines, so a slowdown shows up before anything's burned to disc. the
+// results are printed as JSON
+//
+// the board checks and the sprite loaders are static in game.c and sprite.c,
+// so this links copies of both built with them exported (see internal.h).
+// assets come from the disc image, like the rest of the host build
+//
+// every time is also taken relative to a fixed reference loop timed in the same
+// run, and that's what gets compared, so the baselines hold up across machines
+// and whatever else the machine is doing. baseline files have one
+// "name relative time" line per benchmark
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sega_def.h>
+#include <sega_scl.h>
+
+#include "../cd.h"
+#include "../crc.h"
+#include "../game.h"
+#include "../internal.h"
+#include "../piece.h"
+#include "../rng.h"
+#include "../scroll.h"
+#include "../sprite.h"
+#include "../statehash.h"
+#include "hostsys.h"
+#include "iso.h"
+
+// each benchmark runs for at least this long per sample, and the fastest
+// sample is kept
+#define SAMPLE_SECONDS (0.02)
+#define SAMPLES (5)
+#define DEFAULT_THRESHOLD (1.5)
+#define MAX_BENCHES (32)
+
+// keeps results alive so the compiler can't skip the work
+static volatile Uint32 sink;
+
+// random words for the reference loop to look up
+static Uint32 referenceTable[256];
+
+static GAME_CTX board;
+static GAME_CTX lineBoard;
+static PIECE linePiece;
+static RNG_STATE rng;
+
+static const Uint8 *crcData;
+static Sint32 crcSize;
+
+#define TILE_FILES (5)
+static const char *tileDirs[TILE_FILES] = {"BG", "BG", "TITLE", "TITLE", "GAME"};
+static const char *tileNames[TILE_FILES] = {"0.TLE", "6.TLE", "LOGO.TLE", "TITLE.TLE", "BORDER.TLE"};
+static const Uint8 *tiles[TILE_FILES];
+
+// the font in its shipped (RGB) format, and converted to the 4 bit palette
+// format (no shipped sprite uses it)
+static const Uint8 *fontRGB;
+static Uint8 fontPal[0x10000];
+
+typedef struct {
+    const char *name;
+    // runs the benchmark n times
+    void (*run)(int n);
+    // calls made per run, for the per call time
+    int calls;
+} BENCH;
+
+static double Bench_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static void Bench_Put32(Uint8 **cursor, Uint32 val) {
+    (*cursor)[0] = val >> 24;
+    (*cursor)[1] = val >> 16;
+    (*cursor)[2] = val >> 8;
+    (*cursor)[3] = val;
+    *cursor += 4;
+}
+
+// every piece, rotation and position that stays inside the board's padding
+#define CHECK_X_MIN (-2)
+#define CHECK_Y_MIN (-BOARD_PAD)
+#define CHECK_Y_MAX (GAME_ROWS - 1)
+#define CHECK_CALLS (PIECE_COUNT * PIECE_ROTATIONS * (GAME_COLS - CHECK_X_MIN) * (CHECK_Y_MAX - CHECK_Y_MIN + 1))
+
+static void Bench_CheckPiece(int n) {
+    Uint32 fits = 0;
+    PIECE piece;
+
+    for (int i = 0; i < n; i++) {
+        for (piece.num = 0; piece.num < PIECE_COUNT; piece.num++) {
+            for (piece.rotation = 0; piece.rotation < PIECE_ROTATIONS; piece.rotation++) {
+                for (piece.x = CHECK_X_MIN; piece.x < GAME_COLS; piece.x++) {
+                    for (piece.y = CHECK_Y_MIN; piece.y <= CHECK_Y_MAX; piece.y++) {
+                        fits += Game_CheckPiece(&board, &piece);
+                    }
+                }
+            }
+        }
+    }
+    sink = fits;
+}
+
+static void Bench_CheckBelow(int n) {
+    Uint32 landed = 0;
+    PIECE piece;
+
+    for (int i = 0; i < n; i++) {
+        for (piece.num = 0; piece.num < PIECE_COUNT; piece.num++) {
+            for (piece.rotation = 0; piece.rotation < PIECE_ROTATIONS; piece.rotation++) {
+                for (piece.x = CHECK_X_MIN; piece.x < GAME_COLS; piece.x++) {
+                    for (piece.y = CHECK_Y_MIN; piece.y <= CHECK_Y_MAX; piece.y++) {
+                        landed += Game_CheckBelow(&board, &piece);
+                    }
+                }
+            }
+        }
+    }
+    sink = landed;
+}
+
+// clears two lines out of a half full board and moves the stack down
+// (includes copying the board back each time)
+static void Bench_CheckLines(int n) {
+    Uint32 lines = 0;
+
+    for (int i = 0; i < n; i++) {
+        memcpy(&board, &lineBoard, sizeof(board));
+        lines += Game_CheckLines(&board, &linePiece);
+        Game_RemoveLines(&board);
+    }
+    sink = lines;
+}
+
+#define REFERENCE_CALLS (1000)
+
+// the work every benchmark is measured against: a chain of multiplies, shifts
+// and table lookups that each depend on the last, like most of the engine
+static void Bench_Reference(int n) {
+    Uint32 val = 1;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < REFERENCE_CALLS; j++) {
+            val = (val ^ referenceTable[val & 0xFF]) * 16777619u;
+            val ^= val >> 15;
+        }
+    }
+    sink = val;
+}
+
+static const BENCH reference = {"reference", Bench_Reference, REFERENCE_CALLS};
+
+#define RNG_CALLS (1000)
+
+static void Bench_RngGet(int n) {
+    Uint32 total = 0;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < RNG_CALLS; j++) {
+            total += RNG_Get(&rng);
+        }
+    }
+    sink = total;
+}
+
+#define HASH_CALLS (1000)
+
+// run on every tick, so it has to stay a tiny part of the frame
+static void Bench_StateHash(int n) {
+    Uint32 total = 0;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < HASH_CALLS; j++) {
+            board.timer = j;
+            total += StateHash_Get(&board);
+        }
+    }
+    sink = total;
+}
+
+// over a whole background file, like a devcart upload
+static void Bench_Crc(int n) {
+    crc_t crc = crc_init();
+
+    for (int i = 0; i < n; i++) {
+        crc = crc_update(crc, crcData, crcSize);
+    }
+    sink = crc_finalize(crc);
+}
+
+static void Bench_TilePtr(int n) {
+    Uint32 total = 0;
+    int size;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < TILE_FILES; j++) {
+            total += (Uint32)(uintptr_t)Scroll_TilePtr((void *)tiles[j], &size) + size;
+        }
+    }
+    sink = total;
+}
+
+// header and palette only, nothing goes to VRAM
+static void Bench_LoadTile(int n) {
+    Uint32 total = 0;
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < TILE_FILES; j++) {
+            total += Scroll_LoadTile((void *)tiles[j], NULL, SCL_RBG0, 0);
+        }
+    }
+    sink = total;
+}
+
+// includes clearing the character table each time
+static void Bench_LoadRGB(int n) {
+    Uint32 total = 0;
+    int count;
+
+    for (int i = 0; i < n; i++) {
+        Sprite_Clear();
+        total += Sprite_LoadRGB((Uint8 *)fontRGB + sizeof(Sint32), &count) + count;
+    }
+    sink = total;
+}
+
+static void Bench_LoadPal(int n) {
+    Uint32 total = 0;
+    int count;
+
+    for (int i = 0; i < n; i++) {
+        Sprite_Clear();
+        total += Sprite_LoadPal(fontPal + sizeof(Sint32), &count) + count;
+    }
+    sink = total;
+}
+
+// fills the pool, frees every other sprite (out of order) and fills it back
+// up. the time is per sprite taken out
+static void Bench_SpritePool(int n) {
+    Uint32 total = 0;
+
+    for (int i = 0; i < n; i++) {
+        Sprite_DeleteAll();
+        for (int j = 0; j < SPRITE_POOL_SIZE; j++) {
+            total += Sprite_Next();
+        }
+        for (int j = 0; j < SPRITE_POOL_SIZE; j += 2) {
+            Sprite_Delete((j * 7) % SPRITE_POOL_SIZE);
+        }
+        for (int j = 0; j < SPRITE_POOL_SIZE / 2; j++) {
+            total += Sprite_Next();
+        }
+    }
+    sink = total;
+}
+
+static const BENCH benches[] = {
+    {"game_check_piece", Bench_CheckPiece, CHECK_CALLS},
+    {"game_check_below", Bench_CheckBelow, CHECK_CALLS},
+    {"game_check_lines", Bench_CheckLines, 1},
+    {"rng_get", Bench_RngGet, RNG_CALLS},
+    {"state_hash", Bench_StateHash, HASH_CALLS},
+    {"crc_update", Bench_Crc, 1},
+    {"scroll_tile_ptr", Bench_TilePtr, TILE_FILES},
+    {"scroll_load_tile", Bench_LoadTile, TILE_FILES},
+    {"sprite_load_rgb", Bench_LoadRGB, 1},
+    {"sprite_load_pal", Bench_LoadPal, 1},
+    {"sprite_pool", Bench_SpritePool, SPRITE_POOL_SIZE + (SPRITE_POOL_SIZE / 2)},
+};
+#define BENCH_COUNT ((int)(sizeof(benches) / sizeof(benches[0])))
+
+// returns the fastest time per call in nanoseconds
+static double Bench_Time(const BENCH *bench) {
+    // find how many runs fill a sample
+    int n = 1;
+    while (1) {
+        double start = Bench_Seconds();
+        bench->run(n);
+        if ((Bench_Seconds() - start) >= SAMPLE_SECONDS) {
+            break;
+        }
+        n *= 2;
+    }
+
+    double best = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        double start = Bench_Seconds();
+        bench->run(n);
+        double elapsed = Bench_Seconds() - start;
+        if ((i == 0) || (elapsed < best)) {
+            best = elapsed;
+        }
+    }
+    return (best * 1e9) / ((double)n * bench->calls);
+}
+
+static int Bench_Setup(void) {
+    RNG_STATE tableRng;
+
+    RNG_Seed(&rng, 1, 0);
+    RNG_Seed(&tableRng, 1, 1);
+    for (int i = 0; i < 256; i++) {
+        referenceTable[i] = RNG_Next(&tableRng);
+    }
+
+    // a stack with one hole in each row, up to a bit over halfway
+    memset(&board, 0, sizeof(board));
+    Game_Reset(&board, &rng);
+    for (int y = GAME_ROWS - 12; y < GAME_ROWS; y++) {
+        int hole = RNG_Next(&rng) % GAME_COLS;
+        BOARD_ROW(&board, y) = ROW_FULL & ~(1 << (hole + BOARD_WALL));
+        for (int x = 0; x < GAME_COLS; x++) {
+            board.boardColors[y][x] = (x == hole) ? 0 : 1;
+        }
+    }
+    Game_UpdateSurface(&board);
+
+    // the same stack with two rows filled in by an I piece standing up
+    lineBoard = board;
+    linePiece.num = PIECE_I;
+    linePiece.x = 0;
+    linePiece.rotation = 1;
+    linePiece.y = GAME_ROWS - 4;
+    for (int y = GAME_ROWS - 2; y < GAME_ROWS; y++) {
+        BOARD_ROW(&lineBoard, y) = ROW_FULL;
+        for (int x = 0; x < GAME_COLS; x++) {
+            lineBoard.boardColors[y][x] = 1;
+        }
+    }
+
+    for (int i = 0; i < TILE_FILES; i++) {
+        CD_ChangeDir((char *)tileDirs[i]);
+        tiles[i] = Iso_File(tileNames[i], NULL);
+        CD_ChangeDir("..");
+        if (!tiles[i]) {
+            fprintf(stderr, "no %s/%s on the disc\n", tileDirs[i], tileNames[i]);
+            return 0;
+        }
+    }
+    CD_ChangeDir("BG");
+    crcData = Iso_File("0.TLE", &crcSize);
+    CD_ChangeDir("..");
+    if (!crcData) {
+        fprintf(stderr, "no BG/0.TLE on the disc\n");
+        return 0;
+    }
+
+    fontRGB = Iso_File("FONT.SPR", NULL);
+    if (!fontRGB || (CD_Get32(fontRGB) != 1)) {
+        fprintf(stderr, "no RGB FONT.SPR on the disc\n");
+        return 0;
+    }
+
+    // palette version of the font: one palette, every drawn dot is color 1
+    const Uint8 *src = fontRGB + sizeof(Sint32);
+    Uint8 *dst = fontPal;
+    Bench_Put32(&dst, 0);
+    Bench_Put32(&dst, 1);
+    for (int i = 0; i < 16; i++) {
+        Bench_Put32(&dst, (i == 1) ? 0xFFFF : 0);
+    }
+    Sint32 count = CD_Get32(src);
+    src += 4;
+    Bench_Put32(&dst, count);
+    for (int i = 0; i < count; i++) {
+        Sint32 w = CD_Get32(src);
+        Sint32 h = CD_Get32(src + 4);
+        src += 8;
+        if ((dst + 12 + ((w / 2) * h)) > (fontPal + sizeof(fontPal))) {
+            fprintf(stderr, "FONT.SPR is too big to convert\n");
+            return 0;
+        }
+        Bench_Put32(&dst, w);
+        Bench_Put32(&dst, h);
+        Bench_Put32(&dst, 0);
+        for (int j = 0; j < (w / 2) * h; j++) {
+            int left = src[(j * 4) + 0] | src[(j * 4) + 1];
+            int right = src[(j * 4) + 2] | src[(j * 4) + 3];
+            *dst++ = ((left ? 1 : 0) << 4) | (right ? 1 : 0);
+        }
+        src += w * h * 2;
+    }
+    return 1;
+}
+
+// returns the number of baselines read, or -1 if the file couldn't be opened
+static int Bench_ReadBaselines(const char *filename, char names[][64], double *times) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        return -1;
+    }
+
+    int count = 0;
+    while ((count < MAX_BENCHES) && (fscanf(file, "%63s %lf", names[count], &times[count]) == 2)) {
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+static void Bench_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-i disc image] [-b baseline file] [-t threshold] "
+        "[-u (update baseline file)]\n", name);
+}
+
+int main(int argc, char **argv) {
+    const char *iso = "out/main.iso";
+    const char *baselineFile = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+    int update = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-u") == 0) {
+            update = 1;
+            continue;
+        }
+        if ((i + 1 == argc) || (argv[i][0] != '-') || (strlen(argv[i]) != 2)) {
+            Bench_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'i':
+                iso = argv[++i];
+                break;
+
+            case 'b':
+                baselineFile = argv[++i];
+                break;
+
+            case 't':
+                threshold = atof(argv[++i]);
+                break;
+
+            default:
+                Bench_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if ((update && !baselineFile) || (threshold <= 0)) {
+        Bench_Usage(argv[0]);
+        return 1;
+    }
+
+    if (!Host_Init(iso)) {
+        fprintf(stderr, "couldn't map Saturn memory or open %s\n", iso);
+        return 1;
+    }
+    CD_Init();
+    if (!Bench_Setup()) {
+        return 1;
+    }
+
+    static char names[MAX_BENCHES][64];
+    static double baselines[MAX_BENCHES];
+    int baselineCount = 0;
+    if (baselineFile && !update) {
+        baselineCount = Bench_ReadBaselines(baselineFile, names, baselines);
+        if (baselineCount < 0) {
+            fprintf(stderr, "couldn't read %s\n", baselineFile);
+            return 1;
+        }
+    }
+
+    // the reference is timed before and after, and the faster one kept, in
+    // case the machine got busier or quieter partway through
+    double referenceTime = Bench_Time(&reference);
+    double times[BENCH_COUNT];
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        times[i] = Bench_Time(&benches[i]);
+    }
+    double after = Bench_Time(&reference);
+    if (after < referenceTime) {
+        referenceTime = after;
+    }
+
+    int failed = 0;
+    printf("{\n  \"threshold\": %.2f,\n  \"reference_ns_per_call\": %.3f,\n  \"benchmarks\": [\n",
+        threshold, referenceTime);
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        double relative = times[i] / referenceTime;
+        printf("    {\"name\": \"%s\", \"ns_per_call\": %.3f, \"relative\": %.3f", benches[i].name, times[i],
+            relative);
+
+        for (int j = 0; j < baselineCount; j++) {
+            if (strcmp(names[j], benches[i].name) == 0) {
+                double ratio = relative / baselines[j];
+                int pass = ratio <= threshold;
+                printf(", \"baseline\": %.3f, \"ratio\": %.3f, \"pass\": %s",
+                    baselines[j], ratio, pass ? "true" : "false");
+                failed += !pass;
+            }
+        }
+        printf("}%s\n", (i + 1 < BENCH_COUNT) ? "," : "");
+    }
+    printf("  ],\n  \"failed\": %d\n}\n", failed);
+
+    if (update) {
+        FILE *file = fopen(baselineFile, "w");
+        if (!file) {
+            fprintf(stderr, "couldn't write %s\n", baselineFile);
+            return 1;
+        }
+        for (int i = 0; i < BENCH_COUNT; i++) {
+            fprintf(file, "%s %.4f\n", benches[i].name, times[i] / referenceTime);
+        }
+        if (fclose(file) != 0) {
+            fprintf(stderr, "couldn't write %s\n", baselineFile);
+            return 1;
+        }
+    }
+    return failed != 0;
+}
@@ -0,0 +1,109 @@
+// runs the rules engine on the host with scripted input, as fast as it can.
+// each game gets its own piece seed and its own input script, so a run is
+// repeatable: the same arguments always print the same checksum
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../game.h"
+#include "script.h"
+
+// longest a game can run before it's cut off (an hour and a half of play)
+#define DEFAULT_MAX_TICKS (60 * 60 * 90)
+
+// plays one game to the end, returns the number of ticks it took
+static uint64_t Sim_Game(GAME_CTX *ctx, uint64_t seed, uint64_t maxTicks) {
+    RNG_STATE rng;
+    SCRIPT script;
+    uint64_t ticks = 0;
+
+    memset(ctx, 0, sizeof(*ctx));
+    RNG_Seed(&rng, seed, 0);
+    Game_Reset(ctx, &rng);
+    Script_Init(&script, seed);
+
+    while (ticks < maxTicks) {
+        ticks++;
+        if (Game_Step(ctx, Script_Next(&script))) {
+            break;
+        }
+        // nothing reads these on the host
+        ctx->sounds = 0;
+        ctx->events = 0;
+    }
+    return ticks;
+}
+
+static double Sim_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static void Sim_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n games] [-s seed] [-t max ticks per game]\n", name);
+}
+
+int main(int argc, char **argv) {
+    int games = 1000;
+    uint64_t seed = 1;
+    uint64_t maxTicks = DEFAULT_MAX_TICKS;
+
+    for (int i = 1; i < argc; i++) {
+        if ((i + 1 == argc) || (argv[i][0] != '-') || (strlen(argv[i]) != 2)) {
+            Sim_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'n':
+                games = atoi(argv[++i]);
+                break;
+
+            case 's':
+                seed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 't':
+                maxTicks = strtoull(argv[++i], NULL, 0);
+                break;
+
+            default:
+                Sim_Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    GAME_CTX ctx;
+    uint64_t totalTicks = 0;
+    uint64_t totalScore = 0;
+    uint64_t totalLevel = 0;
+    // FNV-1a over every game's result, to spot rules changes that affect play
+    uint64_t checksum = 14695981039346656037ULL;
+
+    double start = Sim_Seconds();
+    for (int i = 0; i < games; i++) {
+        uint64_t ticks = Sim_Game(&ctx, seed + i, maxTicks);
+        totalTicks += ticks;
+        totalScore += ctx.score;
+        totalLevel += ctx.level;
+
+        Uint32 result[] = {ticks, ctx.score, ctx.level, ctx.finalRank};
+        for (size_t j = 0; j < sizeof(result); j++) {
+            checksum = (checksum ^ ((Uint8 *)result)[j]) * 1099511628211ULL;
+        }
+    }
+    double elapsed = Sim_Seconds() - start;
+
+    printf("games %d\n", games);
+    printf("ticks %llu\n", (unsigned long long)totalTicks);
+    printf("seconds %.3f\n", elapsed);
+    printf("ticks/sec %.0f\n", (elapsed > 0) ? (totalTicks / elapsed) : 0.0);
+    if (games > 0) {
+        printf("avg score %.1f\n", (double)totalScore / games);
+        printf("avg level %.1f\n", (double)totalLevel / games);
+    }
+    printf("checksum %016llx\n", (unsigned long long)checksum);
+    return 0;
+}
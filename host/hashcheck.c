@@ -0,0 +1,232 @@
+// checks the host build plays a replay the same way the Saturn did: plays the
+// replay back, hashes the state after every tick (StateHash_Get) and compares
+// against the hashes the Saturn logged during the game. the hashes can come
+// from either
+//   - a dump of the hash log in LWRAM (see HASH_BUFFER in play.c), e.g. saved
+//     from mednafen's memory editor, or
+//   - the lines the game printed over the devcart with HASH_PRINT on. other
+//     lines mixed in are skipped
+//
+// the log in LWRAM only has room for the first 32763 ticks, and stops for good
+// if the game gets rewound. its header says which happened, and the ticks
+// after it are reported as not checked rather than as a mismatch. the devcart
+// lines don't run out
+//
+// prints the first tick that differs along with the host's state before and
+// after it and the buttons held leading up to it, and exits with 1. with no
+// hash file it prints the host's own hashes in the devcart format instead, so
+// two host builds can be checked against each other too
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../game.h"
+#include "../replayfmt.h"
+#include "../statehash.h"
+#include "replayinput.h"
+
+// ticks of input shown before a mismatch
+#define INPUT_CONTEXT (8)
+
+static Uint32 *refHashes;
+static Uint8 *refHave;
+static Uint32 refCount;
+// set if the hashes came from the log, with why it stopped early
+static int refFromLog;
+static Uint32 refStop;
+
+// adds a hash from the Saturn, returns 0 if out of memory
+static int Check_AddHash(Uint32 tick, Uint32 hash, Uint32 *capacity) {
+    if (tick >= *capacity) {
+        Uint32 newCapacity = *capacity ? *capacity : 4096;
+        while (newCapacity <= tick) {
+            newCapacity *= 2;
+        }
+        Uint32 *newHashes = realloc(refHashes, newCapacity * sizeof(Uint32));
+        Uint8 *newHave = realloc(refHave, newCapacity);
+        if (newHashes) {
+            refHashes = newHashes;
+        }
+        if (newHave) {
+            refHave = newHave;
+        }
+        if (!newHashes || !newHave) {
+            return 0;
+        }
+        memset(refHave + *capacity, 0, newCapacity - *capacity);
+        *capacity = newCapacity;
+    }
+    refHashes[tick] = hash;
+    refHave[tick] = 1;
+    if (tick >= refCount) {
+        refCount = tick + 1;
+    }
+    return 1;
+}
+
+// reads the Saturn's hashes from a hash log dump or devcart output. returns 0
+// if the file doesn't hold any
+static int Check_ReadHashes(const uint8_t *buf, int size, uint64_t seed) {
+    Uint32 capacity = 0;
+
+    if ((size >= STATEHASH_HEADER_SIZE) && !memcmp(buf, STATEHASH_MAGIC, 4)) {
+        uint64_t logSeed = ((uint64_t)ReplayFmt_Get32(buf + 4) << 32) | ReplayFmt_Get32(buf + 8);
+        Uint32 count = ReplayFmt_Get32(buf + 12);
+        refFromLog = 1;
+        refStop = ReplayFmt_Get32(buf + 16);
+        if (logSeed != seed) {
+            fprintf(stderr, "the hash log is from a different game (seed %llu, replay has %llu)\n",
+                (unsigned long long)logSeed, (unsigned long long)seed);
+            return 0;
+        }
+        // the dump can stop before the log does
+        if (count > (Uint32)((size - STATEHASH_HEADER_SIZE) / 4)) {
+            count = (size - STATEHASH_HEADER_SIZE) / 4;
+        }
+        for (Uint32 i = 0; i < count; i++) {
+            if (!Check_AddHash(i, ReplayFmt_Get32(buf + STATEHASH_HEADER_SIZE + (i * 4)), &capacity)) {
+                return 0;
+            }
+        }
+        return (count > 0);
+    }
+
+    // devcart output, one "H tick hash" per line
+    int pos = 0;
+    while (pos < size) {
+        char line[128];
+        int len = 0;
+        while ((pos < size) && (buf[pos] != '\n')) {
+            if (len < (int)sizeof(line) - 1) {
+                line[len++] = buf[pos];
+            }
+            pos++;
+        }
+        pos++;
+        line[len] = '\0';
+
+        unsigned int tick;
+        unsigned int hash;
+        char *start = strstr(line, "H ");
+        if (start && (sscanf(start, "H %x %x", &tick, &hash) == 2)) {
+            if (!Check_AddHash(tick, hash, &capacity)) {
+                return 0;
+            }
+        }
+    }
+    return (refCount > 0);
+}
+
+static void Check_PrintState(const char *label, GAME_CTX *ctx) {
+    printf("%s: state %d timer %d level %d score %d\n", label, ctx->state, ctx->timer, ctx->level, ctx->score);
+    printf("  piece %d x %d y %d rotation %d, next %d\n", ctx->currPiece.num, ctx->currPiece.x,
+        ctx->currPiece.y, ctx->currPiece.rotation, ctx->nextPiece.num);
+    printf("  timers left %d right %d down %d lock %d gravity %d, held %04X\n", ctx->leftTimer,
+        ctx->rightTimer, ctx->downTimer, ctx->lockTimer, ctx->gravityTimer, ctx->prevHeld);
+    printf("  rng %016llx history %d %d %d %d\n", (unsigned long long)ctx->rng.state, ctx->rng.history[0],
+        ctx->rng.history[1], ctx->rng.history[2], ctx->rng.history[3]);
+    for (int y = 0; y < GAME_ROWS; y++) {
+        char row[GAME_COLS + 1];
+        for (int x = 0; x < GAME_COLS; x++) {
+            row[x] = (BOARD_ROW(ctx, y) & (1 << (x + BOARD_WALL))) ? '#' : '.';
+        }
+        row[GAME_COLS] = '\0';
+        printf("  |%s|\n", row);
+    }
+}
+
+int main(int argc, char **argv) {
+    if ((argc != 2) && (argc != 3)) {
+        fprintf(stderr, "usage: %s replay [hash log or devcart output]\n", argv[0]);
+        return 1;
+    }
+
+    int size;
+    uint64_t seed;
+    uint32_t ticks;
+    uint8_t *buf = ReplayInput_ReadFile(argv[1], &size);
+    if (!buf) {
+        fprintf(stderr, "couldn't read %s\n", argv[1]);
+        return 1;
+    }
+    Uint16 *inputs = ReplayInput_Decode(buf, size, &seed, &ticks, NULL);
+    free(buf);
+    if (!inputs) {
+        fprintf(stderr, "%s isn't a replay or is damaged\n", argv[1]);
+        return 1;
+    }
+
+    int checking = (argc == 3);
+    if (checking) {
+        buf = ReplayInput_ReadFile(argv[2], &size);
+        if (!buf) {
+            fprintf(stderr, "couldn't read %s\n", argv[2]);
+            return 1;
+        }
+        int ok = Check_ReadHashes(buf, size, seed);
+        free(buf);
+        if (!ok) {
+            fprintf(stderr, "no hashes in %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    // same start as Replay_Reset
+    static GAME_CTX ctx;
+    static GAME_CTX before;
+    RNG_STATE rng;
+    RNG_Seed(&rng, seed, 0);
+    memset(&ctx, 0, sizeof(ctx));
+    Game_Reset(&ctx, &rng);
+
+    Uint32 checked = 0;
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        before = ctx;
+        Game_Step(&ctx, inputs[tick]);
+        ctx.sounds = 0;
+        ctx.events = 0;
+        Uint32 hash = StateHash_Get(&ctx);
+
+        if (!checking) {
+            char line[STATEHASH_LINE_LEN];
+            StateHash_Format(line, tick, hash);
+            printf("%s\n", line);
+            continue;
+        }
+        if ((tick >= refCount) || !refHave[tick]) {
+            continue;
+        }
+        checked++;
+        if (refHashes[tick] != hash) {
+            printf("first mismatch at tick %u: saturn %08x host %08x\n", tick, refHashes[tick], hash);
+            printf("buttons held:\n");
+            for (uint32_t i = (tick > INPUT_CONTEXT) ? (tick - INPUT_CONTEXT) : 0; i <= tick; i++) {
+                printf("  %u %04X\n", i, inputs[i]);
+            }
+            Check_PrintState("host before the tick", &before);
+            Check_PrintState("host after the tick", &ctx);
+            return 1;
+        }
+    }
+
+    if (checking) {
+        printf("ticks %u, checked %u, all match\n", ticks, checked);
+        if (refCount > ticks) {
+            printf("(the hash log has %u more ticks than the replay)\n", refCount - ticks);
+        }
+        else if (refCount < ticks) {
+            const char *why = refFromLog ? "the log was dumped before the game ended" :
+                "the devcart output stops there";
+            if (refStop == STATEHASH_STOP_FULL) {
+                why = "the hash log filled up";
+            }
+            else if (refStop == STATEHASH_STOP_REWOUND) {
+                why = "the game was rewound";
+            }
+            printf("(ticks %u on weren't checked, %s)\n", refCount, why);
+        }
+    }
+    free(inputs);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// everything else the frontend needs to run on the host: LWRAM, the SBL
+// math calls, and stubs for the hardware that has nothing to do here
+// (interrupts, sound)
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <machine.h>
+#include <sega_mth.h>
+
+#include "../cd.h"
+#include "../sound.h"
+#include "../vblank.h"
+#include "hostsys.h"
+#include "iso.h"
+#include "vdp.h"
+
+#define LWRAM_SIZE (0x100000)
+
+volatile Uint16 PadData[PAD_MAX];
+volatile Uint16 PadDataE[PAD_MAX];
+volatile Sint32 VblankFlg;
+volatile int vblank_frames;
+
+int Host_Init(const char *iso) {
+    void *addr = (void *)LWRAM;
+    void *mapped = mmap(addr, LWRAM_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mapped != addr) {
+        return 0;
+    }
+
+    return Iso_Open(iso) && Vdp_Init();
+}
+
+// math
+
+Fixed32 MTH_Mul(Fixed32 a, Fixed32 b) {
+    return (Fixed32)(((int64_t)a * b) >> 16);
+}
+
+Fixed32 MTH_Sin(Fixed32 degree) {
+    return (Fixed32)(sin((degree / 65536.0) * (M_PI / 180.0)) * 65536.0);
+}
+
+Fixed32 MTH_Cos(Fixed32 degree) {
+    return (Fixed32)(cos((degree / 65536.0) * (M_PI / 180.0)) * 65536.0);
+}
+
+// hardware with nothing to do on the host
+
+void set_imask(int mask) {
+}
+
+void SetVblank(void) {
+}
+
+void Sound_CDVolume(Uint8 vol_l, Uint8 vol_r) {
+}
+
+void Sound_Init(void) {
+}
+
+void Sound_CDDA(int track, int loop) {
+}
+
+void Sound_Play(short num) {
+}
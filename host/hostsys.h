@@ -0,0 +1,8 @@
+#ifndef HOSTSYS_H
+#define HOSTSYS_H
+
+// maps LWRAM and VDP2 VRAM at their Saturn addresses and opens the disc
+// image CD_Load reads from. returns 0 if either fails
+int Host_Init(const char *iso);
+
+#endif
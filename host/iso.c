@@ -0,0 +1,197 @@
+// CD for the host build. the disc image is mapped once and every directory
+// on it is indexed up front, so loading a file is a lookup and a memcpy with
+// no file system calls, and host runs use exactly what's on the disc
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sega_xpt.h>
+
+#include "../cd.h"
+#include "iso.h"
+
+#define SECT_SIZE (2048)
+#define PVD_SECTOR (16)
+// offsets into the primary volume descriptor and directory records (the
+// numbers are stored both ways round, these are the little endian copies)
+#define PVD_ROOT (156)
+#define REC_LEN (0)
+#define REC_EXTENT (2)
+#define REC_SIZE (10)
+#define REC_FLAGS (25)
+#define REC_NAME_LEN (32)
+#define REC_NAME (33)
+#define REC_FLAG_DIR (1 << 1)
+
+#define MAX_ENTRIES (1024)
+#define MAX_NAME (32)
+
+typedef struct {
+    char name[MAX_NAME]; // without the ";1" version
+    Uint32 offset;
+    Uint32 size;
+    int isDir;
+    int parent; // directory the entry is in
+    // for directories, the entries inside (they're stored next to each other)
+    int first;
+    int count;
+} ISO_ENTRY;
+
+static const Uint8 *image;
+static size_t imageSize;
+// entry 0 is the root directory
+static ISO_ENTRY entries[MAX_ENTRIES];
+static int entryCount;
+static int currDir;
+
+static Uint32 Iso_Get32(const Uint8 *ptr) {
+    return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((Uint32)ptr[3] << 24);
+}
+
+// adds everything in a directory's extent to the index
+static int Iso_ReadDir(int dir) {
+    Uint32 pos = entries[dir].offset;
+    Uint32 end = pos + entries[dir].size;
+    if (end > imageSize) {
+        return 0;
+    }
+
+    entries[dir].first = entryCount;
+    entries[dir].count = 0;
+    while (pos < end) {
+        const Uint8 *rec = image + pos;
+        // records don't cross sectors, the rest of the sector is zeroes
+        if (rec[REC_LEN] == 0) {
+            pos = (pos + SECT_SIZE) & ~(SECT_SIZE - 1);
+            continue;
+        }
+        if ((pos + rec[REC_LEN] > end) || (REC_NAME + rec[REC_NAME_LEN] > rec[REC_LEN])) {
+            return 0;
+        }
+        pos += rec[REC_LEN];
+
+        // skip "." and ".."
+        int nameLen = rec[REC_NAME_LEN];
+        if ((nameLen == 1) && (rec[REC_NAME] <= 1)) {
+            continue;
+        }
+        if (entryCount == MAX_ENTRIES) {
+            return 0;
+        }
+
+        ISO_ENTRY *entry = &entries[entryCount++];
+        int i;
+        for (i = 0; (i < nameLen) && (i < MAX_NAME - 1) && (rec[REC_NAME + i] != ';'); i++) {
+            entry->name[i] = rec[REC_NAME + i];
+        }
+        entry->name[i] = '\0';
+        entry->offset = Iso_Get32(rec + REC_EXTENT) * SECT_SIZE;
+        entry->size = Iso_Get32(rec + REC_SIZE);
+        entry->isDir = (rec[REC_FLAGS] & REC_FLAG_DIR) != 0;
+        entry->parent = dir;
+        entry->first = 0;
+        entry->count = 0;
+        if ((entry->offset > imageSize) || (entry->size > imageSize - entry->offset)) {
+            return 0;
+        }
+        entries[dir].count++;
+    }
+    return 1;
+}
+
+int Iso_Open(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    if ((fstat(fd, &info) < 0) || (info.st_size < (PVD_SECTOR + 1) * SECT_SIZE)) {
+        close(fd);
+        return 0;
+    }
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return 0;
+    }
+    image = mapped;
+    imageSize = info.st_size;
+
+    const Uint8 *pvd = image + (PVD_SECTOR * SECT_SIZE);
+    if ((pvd[0] != 1) || (memcmp(pvd + 1, "CD001", 5) != 0)) {
+        return 0;
+    }
+
+    // the directories get added as they're found, so this reaches all of them
+    const Uint8 *root = pvd + PVD_ROOT;
+    memset(&entries[0], 0, sizeof(entries[0]));
+    entries[0].offset = Iso_Get32(root + REC_EXTENT) * SECT_SIZE;
+    entries[0].size = Iso_Get32(root + REC_SIZE);
+    entries[0].isDir = 1;
+    entryCount = 1;
+    for (int i = 0; i < entryCount; i++) {
+        if (entries[i].isDir && !Iso_ReadDir(i)) {
+            return 0;
+        }
+    }
+    currDir = 0;
+    return 1;
+}
+
+static ISO_ENTRY *Iso_Find(const char *name) {
+    ISO_ENTRY *dir = &entries[currDir];
+
+    for (int i = dir->first; i < dir->first + dir->count; i++) {
+        if (strcasecmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+const void *Iso_File(const char *filename, Sint32 *size) {
+    ISO_ENTRY *entry = Iso_Find(filename);
+    if (!entry || entry->isDir) {
+        return NULL;
+    }
+
+    if (size) {
+        *size = entry->size;
+    }
+    return image + entry->offset;
+}
+
+void CD_Init(void) {
+    currDir = 0;
+}
+
+void CD_ChangeDir(char *directory) {
+    if (strcmp(directory, "..") == 0) {
+        currDir = entries[currDir].parent;
+        return;
+    }
+
+    ISO_ENTRY *entry = Iso_Find(directory);
+    if (!entry || !entry->isDir) {
+        fprintf(stderr, "cd: no directory %s\n", directory);
+        return;
+    }
+    currDir = entry - entries;
+}
+
+Sint32 CD_Load(char *filename, void *dataBuf) {
+    Sint32 size;
+    const void *data = Iso_File(filename, &size);
+    if (!data) {
+        fprintf(stderr, "cd: no file %s\n", filename);
+        return 0;
+    }
+
+    memcpy(dataBuf, data, size);
+    return size;
+}
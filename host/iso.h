@@ -0,0 +1,17 @@
+#ifndef ISO_H
+#define ISO_H
+
+#include <sega_xpt.h>
+
+// maps an ISO9660 disc image and indexes every directory on it, so CD_Load
+// and CD_ChangeDir work from memory afterwards. returns 0 if the image
+// couldn't be opened or isn't ISO9660
+int Iso_Open(const char *filename);
+
+// returns a pointer to a file in the current directory (straight into the
+// image, nothing is copied) and sets *size to its length. names are matched
+// without case or version, like GFS does. returns NULL if there's no such
+// file
+const void *Iso_File(const char *filename, Sint32 *size);
+
+#endif
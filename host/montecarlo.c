@@ -0,0 +1,368 @@
+// plays a lot of complete games across every core and prints histograms of
+// how they went (final level, score, rank, and time spent in each 100 level
+// section), for checking the rank thresholds, speed curves and score formula.
+//
+// each game's pieces and input are seeded from its number, so the results
+// don't depend on how many threads ran or which thread got which game. the
+// games are split evenly between the workers up front, and a worker that
+// runs out steals half of what's left from another one. workers share
+// nothing else: each has its own game state, stats, and RNG stream (used to
+// pick who to steal from)
+//
+// the games are played by the bot, which also makes this a soak test for the
+// bot and the rules. -r plays them with the random input script instead, which
+// is much faster but tops out well below level 50, so it's only good for
+// timing the engine and soaking the rules, not for the level, rank and section
+// numbers
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../bot.h"
+#include "../game.h"
+#include "script.h"
+
+// longest a game can run before it's cut off (an hour and a half of play)
+#define DEFAULT_MAX_TICKS (60 * 60 * 90)
+// the bot plays a few games a second per core
+#define DEFAULT_GAMES (1000)
+// games a worker takes from its own queue at a time
+#define CHUNK_GAMES (16)
+#define MAX_THREADS (256)
+
+#define SECTIONS (10)
+#define LEVEL_BIN_SIZE (50)
+// the last bin is for games that got past 999
+#define LEVEL_BINS ((1000 / LEVEL_BIN_SIZE) + 1)
+// bin 0 is a score of 0, bin n is [2^(n-1), 2^n)
+#define SCORE_BINS (24)
+// ranks run from 0 to the finish rank (9)
+#define RANK_BINS (10)
+#define TIME_BIN_TICKS (60 * 15)
+// the last bin is for everything longer
+#define TIME_BINS (21)
+
+typedef struct {
+    uint64_t games;
+    uint64_t ticks;
+    uint64_t pieces; // only counted when the bot is playing
+    uint64_t cutOff; // games that hit the tick limit, not in the rank bins
+    uint64_t levels[LEVEL_BINS];
+    uint64_t scores[SCORE_BINS];
+    uint64_t ranks[RANK_BINS];
+    // only sections a game got all the way through
+    uint64_t sectionTimes[SECTIONS][TIME_BINS];
+} STATS;
+
+// a worker's queue is the range of game numbers [begin, end). the owner
+// takes from the front, thieves take from the back
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t begin;
+    uint64_t end;
+    RNG_STATE rng;
+    GAME_CTX ctx;
+    BOT bot;
+    STATS stats;
+} __attribute__((aligned(64))) WORKER;
+
+static WORKER *workers;
+static int workerCount;
+static uint64_t baseSeed;
+static uint64_t maxTicks;
+static int useScript;
+
+static inline int Monte_Bin(uint64_t val, int bins) {
+    return (val < (uint64_t)bins) ? (int)val : bins - 1;
+}
+
+static void Monte_Game(WORKER *worker, uint64_t game) {
+    GAME_CTX *ctx = &worker->ctx;
+    STATS *stats = &worker->stats;
+    RNG_STATE rng;
+    SCRIPT script;
+    uint64_t sectionTicks[SECTIONS] = {0};
+    uint64_t ticks = 0;
+
+    memset(ctx, 0, sizeof(*ctx));
+    RNG_Seed(&rng, baseSeed + game, 0);
+    Game_Reset(ctx, &rng);
+    if (useScript) {
+        Script_Init(&script, baseSeed + game);
+    }
+    else {
+        Bot_Init(&worker->bot, &botDefaultWeights, 0);
+    }
+
+    int over = 0;
+    while (ticks < maxTicks) {
+        ticks++;
+        sectionTicks[Monte_Bin(ctx->level / 100, SECTIONS)]++;
+        Uint16 held = useScript ? Script_Next(&script) : Bot_Input(&worker->bot, ctx);
+        if (Game_Step(ctx, held)) {
+            over = 1;
+            break;
+        }
+        ctx->sounds = 0;
+        ctx->events = 0;
+    }
+
+    stats->games++;
+    stats->ticks += ticks;
+    if (!useScript) {
+        stats->pieces += worker->bot.pieces;
+    }
+    stats->levels[Monte_Bin(ctx->level / LEVEL_BIN_SIZE, LEVEL_BINS)]++;
+    int scoreBin = 0;
+    for (Uint32 score = ctx->score; score; score >>= 1) {
+        scoreBin++;
+    }
+    stats->scores[Monte_Bin(scoreBin, SCORE_BINS)]++;
+    // a game that was cut off never got a final rank
+    if (over) {
+        stats->ranks[Monte_Bin(ctx->finalRank, RANK_BINS)]++;
+    }
+    else {
+        stats->cutOff++;
+    }
+
+    int done = (ctx->level > 999) ? SECTIONS : (ctx->level / 100);
+    for (int i = 0; i < done; i++) {
+        stats->sectionTimes[i][Monte_Bin(sectionTicks[i] / TIME_BIN_TICKS, TIME_BINS)]++;
+    }
+}
+
+// takes half the games left in another worker's queue, returns 0 if there
+// weren't any left anywhere
+static int Monte_Steal(WORKER *worker) {
+    int start = RNG_Next(&worker->rng) % workerCount;
+
+    for (int i = 0; i < workerCount; i++) {
+        WORKER *victim = &workers[(start + i) % workerCount];
+        if (victim == worker) {
+            continue;
+        }
+
+        pthread_mutex_lock(&victim->lock);
+        uint64_t left = victim->end - victim->begin;
+        uint64_t take = (left + 1) / 2;
+        uint64_t end = victim->end;
+        victim->end -= take;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (take) {
+            pthread_mutex_lock(&worker->lock);
+            worker->begin = end - take;
+            worker->end = end;
+            pthread_mutex_unlock(&worker->lock);
+            return 1;
+        }
+    }
+    // games are never added, so once every queue is empty it stays that way
+    return 0;
+}
+
+static void *Monte_Worker(void *arg) {
+    WORKER *worker = arg;
+
+    while (1) {
+        pthread_mutex_lock(&worker->lock);
+        uint64_t begin = worker->begin;
+        uint64_t end = begin + CHUNK_GAMES;
+        if (end > worker->end) {
+            end = worker->end;
+        }
+        worker->begin = end;
+        pthread_mutex_unlock(&worker->lock);
+
+        if (begin == end) {
+            if (!Monte_Steal(worker)) {
+                break;
+            }
+            continue;
+        }
+        for (uint64_t game = begin; game < end; game++) {
+            Monte_Game(worker, game);
+        }
+    }
+    return NULL;
+}
+
+static double Monte_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static void Monte_PrintBin(const char *label, uint64_t count, uint64_t total) {
+    double percent = total ? ((100.0 * count) / total) : 0.0;
+    char bar[51];
+    int len = (int)(percent / 2);
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    printf("  %-12s %12llu %6.2f%% %s\n", label, (unsigned long long)count, percent, bar);
+}
+
+static void Monte_Print(STATS *stats) {
+    char label[32];
+
+    printf("\nfinal level\n");
+    for (int i = 0; i < LEVEL_BINS; i++) {
+        if (i == LEVEL_BINS - 1) {
+            snprintf(label, sizeof(label), "finished");
+        }
+        else {
+            snprintf(label, sizeof(label), "%d-%d", i * LEVEL_BIN_SIZE, ((i + 1) * LEVEL_BIN_SIZE) - 1);
+        }
+        Monte_PrintBin(label, stats->levels[i], stats->games);
+    }
+
+    printf("\nscore\n");
+    for (int i = 0; i < SCORE_BINS; i++) {
+        if (i == 0) {
+            snprintf(label, sizeof(label), "0");
+        }
+        else if (i == SCORE_BINS - 1) {
+            snprintf(label, sizeof(label), "%u+", 1u << (i - 1));
+        }
+        else {
+            snprintf(label, sizeof(label), "%u-%u", 1u << (i - 1), (1u << i) - 1);
+        }
+        Monte_PrintBin(label, stats->scores[i], stats->games);
+    }
+
+    uint64_t ranked = stats->games - stats->cutOff;
+    printf("\nrank (%llu games cut off at the tick limit aren't counted)\n", (unsigned long long)stats->cutOff);
+    for (int i = 0; i < RANK_BINS; i++) {
+        snprintf(label, sizeof(label), "%d", i);
+        Monte_PrintBin(label, stats->ranks[i], ranked);
+    }
+
+    for (int section = 0; section < SECTIONS; section++) {
+        uint64_t total = 0;
+        for (int i = 0; i < TIME_BINS; i++) {
+            total += stats->sectionTimes[section][i];
+        }
+        printf("\nseconds in levels %d-%d (%llu games got through)\n", section * 100, (section * 100) + 99,
+            (unsigned long long)total);
+        if (!total) {
+            continue;
+        }
+        for (int i = 0; i < TIME_BINS; i++) {
+            int seconds = (i * TIME_BIN_TICKS) / 60;
+            if (i == TIME_BINS - 1) {
+                snprintf(label, sizeof(label), "%d+", seconds);
+            }
+            else {
+                snprintf(label, sizeof(label), "%d-%d", seconds, seconds + (TIME_BIN_TICKS / 60) - 1);
+            }
+            Monte_PrintBin(label, stats->sectionTimes[section][i], total);
+        }
+    }
+}
+
+static void Monte_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n games] [-j threads] [-s seed] [-t max ticks per game] "
+        "[-r (random input instead of the bot)]\n", name);
+}
+
+int main(int argc, char **argv) {
+    uint64_t games = DEFAULT_GAMES;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    baseSeed = 1;
+    maxTicks = DEFAULT_MAX_TICKS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0) {
+            useScript = 1;
+            continue;
+        }
+        if ((i + 1 == argc) || (argv[i][0] != '-') || (strlen(argv[i]) != 2)) {
+            Monte_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'n':
+                games = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 'j':
+                threads = atoi(argv[++i]);
+                break;
+
+            case 's':
+                baseSeed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 't':
+                maxTicks = strtoull(argv[++i], NULL, 0);
+                break;
+
+            default:
+                Monte_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    workerCount = threads;
+    workers = aligned_alloc(64, sizeof(WORKER) * workerCount);
+    if (!workers) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        WORKER *worker = &workers[i];
+        memset(worker, 0, sizeof(*worker));
+        pthread_mutex_init(&worker->lock, NULL);
+        worker->begin = (games * i) / workerCount;
+        worker->end = (games * (i + 1)) / workerCount;
+        // streams 0 and 1 are the pieces and the input script
+        RNG_Seed(&worker->rng, baseSeed, 2 + i);
+    }
+
+    pthread_t ids[MAX_THREADS];
+    double start = Monte_Seconds();
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&ids[i], NULL, Monte_Worker, &workers[i]) != 0) {
+            fprintf(stderr, "couldn't start thread %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < workerCount; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = Monte_Seconds() - start;
+
+    STATS total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < workerCount; i++) {
+        uint64_t *src = (uint64_t *)&workers[i].stats;
+        uint64_t *dst = (uint64_t *)&total;
+        for (size_t j = 0; j < sizeof(STATS) / sizeof(uint64_t); j++) {
+            dst[j] += src[j];
+        }
+    }
+
+    printf("games %llu\n", (unsigned long long)total.games);
+    printf("threads %d\n", workerCount);
+    printf("seconds %.3f\n", elapsed);
+    printf("games/sec %.0f\n", (elapsed > 0) ? (total.games / elapsed) : 0.0);
+    printf("ticks/sec %.0f\n", (elapsed > 0) ? (total.ticks / elapsed) : 0.0);
+    printf("games cut off %llu\n", (unsigned long long)total.cutOff);
+    if (!useScript) {
+        printf("pieces %llu\n", (unsigned long long)total.pieces);
+        printf("pieces/sec %.0f\n", (elapsed > 0) ? (total.pieces / elapsed) : 0.0);
+    }
+    Monte_Print(&total);
+    return 0;
+}
@@ -0,0 +1,418 @@
+// finds where a piece can lock and how to get it there, for analysis tools.
+// the search is breadth first over ticks: each position is stepped with
+// Game_Step once for every button combination, so it gets the game's DAS,
+// gravity, lock delay and kicks exactly, and the first time a placement shows
+// up it's with the fewest ticks. positions are told apart by the piece's x, y
+// and rotation, the lock timer, the movement buttons held and the DAS and soft
+// drop timers for the buttons that are held. the gravity timer isn't part of
+// it: at low gravity, keeping it (or even just the ticks left until the next
+// fall) makes the search over ten times bigger, past MOVEGEN_MAX_NODES. two
+// ways of getting to the same position keep the first one's gravity timer, so
+// every path is real, but a slower path that would have fallen at another time
+// is skipped, and anything only it could reach is missed. that sets
+// MOVEGEN_RESULT.gravityMerged (not truncated, which is kept for running out of
+// room)
+//
+// positions and boards are hashed Zobrist style (one random word per value of
+// each part, XORed together), and whole searches are cached by the hash of
+// the board and starting position, since tools ask about the same board over
+// and over. hash matches are always checked against the real state
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rng.h"
+#include "../vblank.h"
+#include "movegen.h"
+
+#define MOVEGEN_SEED (0x6d6f766567656eULL)
+#define MOVEGEN_SLOTS (MOVEGEN_MAX_NODES * 2)
+#define PLACEMENT_SLOTS (MOVEGEN_MAX_PLACEMENTS * 2)
+
+// the held buttons that tell positions apart: the ones with a timer. hard
+// drop only looks at whether U is held now, and a turn button held from the
+// last tick only means the piece can't turn again until it's let go, so those
+// are left out to keep the search small (which can cost a tick on back to back
+// turns). the starting position is matched on the turn buttons too
+#define MOVEGEN_BUTTONS (PAD_L | PAD_R | PAD_D | PAD_A)
+#define MOVEGEN_START_BUTTONS (MOVEGEN_BUTTONS | PAD_B | PAD_C)
+
+// every tick holds one of these: nothing, left or right, nothing or either
+// rotation, and nothing, soft drop or hard drop
+#define MOVEGEN_INPUTS (27)
+static Uint16 movegenInputs[MOVEGEN_INPUTS];
+
+static uint64_t Movegen_Random(RNG_STATE *rng) {
+    uint64_t high = RNG_Next(rng);
+    return (high << 32) | RNG_Next(rng);
+}
+
+int Movegen_Init(MOVEGEN *gen, int cacheSize) {
+    static const Uint16 horizontal[] = {0, PAD_L, PAD_R};
+    static const Uint16 rotation[] = {0, PAD_C, PAD_B};
+    static const Uint16 vertical[] = {0, PAD_D, PAD_U};
+    RNG_STATE rng;
+
+    memset(gen, 0, sizeof(*gen));
+    gen->nodes = malloc(MOVEGEN_MAX_NODES * sizeof(*gen->nodes));
+    gen->slots = malloc(MOVEGEN_SLOTS * sizeof(*gen->slots));
+    gen->slotStamps = calloc(MOVEGEN_SLOTS, sizeof(*gen->slotStamps));
+    gen->cache = calloc(cacheSize, sizeof(*gen->cache));
+    gen->cacheSize = cacheSize;
+    if (!gen->nodes || !gen->slots || !gen->slotStamps || !gen->cache) {
+        Movegen_Free(gen);
+        return 0;
+    }
+
+    RNG_Seed(&rng, MOVEGEN_SEED, 0);
+#define MOVEGEN_FILL(table) \
+    for (int i = 0; i < (int)(sizeof(table) / sizeof(uint64_t)); i++) { \
+        ((uint64_t *)(table))[i] = Movegen_Random(&rng); \
+    }
+    MOVEGEN_FILL(gen->cellKeys);
+    MOVEGEN_FILL(gen->pieceKeys);
+    MOVEGEN_FILL(gen->xKeys);
+    MOVEGEN_FILL(gen->yKeys);
+    MOVEGEN_FILL(gen->rotationKeys);
+    MOVEGEN_FILL(gen->lockKeys);
+    MOVEGEN_FILL(gen->dasKeys);
+    MOVEGEN_FILL(gen->downKeys);
+    MOVEGEN_FILL(gen->heldKeys);
+    MOVEGEN_FILL(gen->levelKeys);
+#undef MOVEGEN_FILL
+
+    int n = 0;
+    for (int v = 0; v < 3; v++) {
+        for (int r = 0; r < 3; r++) {
+            for (int h = 0; h < 3; h++) {
+                movegenInputs[n++] = horizontal[h] | rotation[r] | vertical[v];
+            }
+        }
+    }
+    return 1;
+}
+
+void Movegen_Free(MOVEGEN *gen) {
+    free(gen->nodes);
+    free(gen->slots);
+    free(gen->slotStamps);
+    free(gen->cache);
+    memset(gen, 0, sizeof(*gen));
+}
+
+static void Movegen_FromGame(MOVEGEN_NODE *node, GAME_CTX *ctx) {
+    node->x = ctx->currPiece.x;
+    node->y = ctx->currPiece.y;
+    node->rotation = ctx->currPiece.rotation;
+    node->lockTimer = ctx->lockTimer;
+    node->gravityTimer = ctx->gravityTimer;
+    node->leftTimer = ctx->leftTimer;
+    node->rightTimer = ctx->rightTimer;
+    node->downTimer = ctx->downTimer;
+    node->prevHeld = ctx->prevHeld;
+}
+
+static void Movegen_ToGame(MOVEGEN_NODE *node, GAME_CTX *ctx) {
+    ctx->currPiece.x = node->x;
+    ctx->currPiece.y = node->y;
+    ctx->currPiece.rotation = node->rotation;
+    ctx->lockTimer = node->lockTimer;
+    ctx->gravityTimer = node->gravityTimer;
+    ctx->leftTimer = node->leftTimer;
+    ctx->rightTimer = node->rightTimer;
+    ctx->downTimer = node->downTimer;
+    ctx->prevHeld = node->prevHeld;
+}
+
+static uint64_t Movegen_NodeKey(MOVEGEN *gen, MOVEGEN_NODE *node) {
+    Uint16 held = node->prevHeld & MOVEGEN_BUTTONS;
+    uint64_t key = gen->xKeys[node->x & 31] ^ gen->yKeys[node->y & 63] ^
+        gen->rotationKeys[node->rotation & 3] ^ gen->lockKeys[node->lockTimer & 63];
+
+    for (int i = 0; i < 16; i++) {
+        if (held & (1 << i)) {
+            key ^= gen->heldKeys[i];
+        }
+    }
+    // the timers only matter while their button is held, a new press resets
+    // them
+    if (held & PAD_L) {
+        key ^= gen->dasKeys[0][node->leftTimer & 31];
+    }
+    if (held & PAD_R) {
+        key ^= gen->dasKeys[1][node->rightTimer & 31];
+    }
+    if (held & (PAD_D | PAD_A)) {
+        key ^= gen->downKeys[node->downTimer & 7];
+    }
+    return key;
+}
+
+static int Movegen_SameNode(MOVEGEN_NODE *a, MOVEGEN_NODE *b) {
+    Uint16 held = a->prevHeld & MOVEGEN_BUTTONS;
+
+    if ((a->x != b->x) || (a->y != b->y) || (a->rotation != b->rotation) ||
+        (a->lockTimer != b->lockTimer) || (held != (b->prevHeld & MOVEGEN_BUTTONS))) {
+        return 0;
+    }
+    if ((held & PAD_L) && (a->leftTimer != b->leftTimer)) {
+        return 0;
+    }
+    if ((held & PAD_R) && (a->rightTimer != b->rightTimer)) {
+        return 0;
+    }
+    if ((held & (PAD_D | PAD_A)) && (a->downTimer != b->downTimer)) {
+        return 0;
+    }
+    return 1;
+}
+
+// adds a node to the seen table, returns 0 if an equal one is already there.
+// if that one has a different gravity timer, the node's placements might not
+// all be found
+static int Movegen_Insert(MOVEGEN *gen, MOVEGEN_RESULT *result, MOVEGEN_NODE *node, int index) {
+    Uint32 slot = Movegen_NodeKey(gen, node) & (MOVEGEN_SLOTS - 1);
+
+    while (gen->slotStamps[slot] == gen->stamp) {
+        MOVEGEN_NODE *seen = &gen->nodes[gen->slots[slot]];
+        if (Movegen_SameNode(seen, node)) {
+            if (seen->gravityTimer != node->gravityTimer) {
+                result->gravityMerged = 1;
+            }
+            return 0;
+        }
+        slot = (slot + 1) & (MOVEGEN_SLOTS - 1);
+    }
+    gen->slotStamps[slot] = gen->stamp;
+    gen->slots[slot] = index;
+    return 1;
+}
+
+static inline const SPEED *Movegen_Speed(GAME_CTX *ctx) {
+    int level = ctx->level;
+    if (level >= SPEED_LEVELS) {
+        level = SPEED_LEVELS - 1;
+    }
+    return &speedCurves[ctx->speedCurve][level];
+}
+
+static uint64_t Movegen_Key(MOVEGEN *gen, GAME_CTX *ctx) {
+    MOVEGEN_NODE node;
+    int level = (ctx->level < SPEED_LEVELS) ? ctx->level : (SPEED_LEVELS - 1);
+    uint64_t key;
+
+    Movegen_FromGame(&node, ctx);
+    key = Movegen_NodeKey(gen, &node) ^ gen->pieceKeys[ctx->currPiece.num] ^ gen->levelKeys[level] ^
+        ((uint64_t)(Uint16)ctx->gravityTimer * 0x9E3779B97F4A7C15ULL);
+    if (ctx->prevHeld & PAD_B) {
+        key ^= gen->heldKeys[__builtin_ctz(PAD_B)];
+    }
+    if (ctx->prevHeld & PAD_C) {
+        key ^= gen->heldKeys[__builtin_ctz(PAD_C)];
+    }
+    for (int y = 0; y < GAME_ROWS; y++) {
+        Uint16 cells = (BOARD_ROW(ctx, y) ^ ROW_EMPTY) >> BOARD_WALL;
+        while (cells) {
+            key ^= gen->cellKeys[y][__builtin_ctz(cells)];
+            cells &= cells - 1;
+        }
+    }
+    return key;
+}
+
+// checks a cached search started from the same position as ctx is in now
+static int Movegen_SameStart(GAME_CTX *start, GAME_CTX *ctx) {
+    MOVEGEN_NODE a;
+    MOVEGEN_NODE b;
+
+    Movegen_FromGame(&a, start);
+    Movegen_FromGame(&b, ctx);
+    return Movegen_SameNode(&a, &b) && (a.gravityTimer == b.gravityTimer) &&
+        ((a.prevHeld & MOVEGEN_START_BUTTONS) == (b.prevHeld & MOVEGEN_START_BUTTONS)) &&
+        (start->currPiece.num == ctx->currPiece.num) && (start->rotationSystem == ctx->rotationSystem) &&
+        (start->speedCurve == ctx->speedCurve) && (Movegen_Speed(start) == Movegen_Speed(ctx)) &&
+        (memcmp(start->boardRows, ctx->boardRows, sizeof(ctx->boardRows)) == 0);
+}
+
+int Movegen_Cells(PIECE *piece, uint64_t *cells) {
+    const Uint8 *mask = pieceMasks[piece->num][piece->rotation];
+    int top = 0;
+
+    while ((top < PIECE_SIZE - 1) && !mask[top]) {
+        top++;
+    }
+    *cells = 0;
+    for (int y = top; y < PIECE_SIZE; y++) {
+        *cells |= (uint64_t)(Uint16)(mask[y] << (piece->x + BOARD_WALL)) << ((y - top) * 16);
+    }
+    return piece->y + top;
+}
+
+// checks that locking piece on the start board gives the board after the
+// lock (with the cleared rows still full)
+static int Movegen_LockedAt(GAME_CTX *start, GAME_CTX *after, PIECE *piece) {
+    const Uint8 *mask = pieceMasks[piece->num][piece->rotation];
+
+    for (int y = 0; y < PIECE_SIZE; y++) {
+        int row = piece->y + y;
+        Uint16 locked = BOARD_ROW(after, row);
+        if ((row >= 0) && (row < GAME_ROWS) && (after->clearedRows & (1 << row))) {
+            locked = ROW_FULL;
+        }
+        if ((Uint16)(BOARD_ROW(start, row) | (mask[y] << (piece->x + BOARD_WALL))) != locked) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int Movegen_Locked(GAME_CTX *before, GAME_CTX *after, PIECE *piece) {
+    // horizontal movement comes after the lock in Game_Normal, so the piece
+    // might have moved a column since it locked
+    static const int shifts[] = {0, 1, -1};
+
+    if ((before->state != GAME_STATE_NORMAL) || (after->state == GAME_STATE_NORMAL) ||
+        (after->state == GAME_STATE_PAUSED)) {
+        return 0;
+    }
+    *piece = after->currPiece;
+    for (int i = 0; i < 3; i++) {
+        piece->x = after->currPiece.x + shifts[i];
+        if (Movegen_LockedAt(before, after, piece)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// records where the piece in gen->scratch just locked, coming from node with
+// the buttons in held
+static void Movegen_AddPlacement(MOVEGEN *gen, MOVEGEN_RESULT *result, GAME_CTX *ctx, int node, Uint16 held) {
+    PIECE piece;
+
+    if (!Movegen_Locked(ctx, &gen->scratch, &piece)) {
+        // can't happen, but don't record a placement that's wrong
+        result->truncated = 1;
+        return;
+    }
+
+    uint64_t cells;
+    int top = Movegen_Cells(&piece, &cells);
+    Uint32 slot = (Uint32)(((cells ^ ((uint64_t)top << 58)) * 0x9E3779B97F4A7C15ULL) >> 40) & (PLACEMENT_SLOTS - 1);
+    while (gen->placementSlots[slot] != -1) {
+        MOVEGEN_PLACEMENT *placement = &result->placements[gen->placementSlots[slot]];
+        if ((placement->top == top) && (placement->cells == cells)) {
+            return;
+        }
+        slot = (slot + 1) & (PLACEMENT_SLOTS - 1);
+    }
+    if (result->placementCount == MOVEGEN_MAX_PLACEMENTS) {
+        result->truncated = 1;
+        return;
+    }
+
+    int index = result->placementCount++;
+    gen->placementSlots[slot] = index;
+    gen->placementNodes[index] = node;
+    gen->placementHeld[index] = held;
+    result->placements[index].piece = piece;
+    result->placements[index].top = top;
+    result->placements[index].cells = cells;
+}
+
+// writes out each placement's inputs by walking back up the search
+static void Movegen_MakePaths(MOVEGEN *gen, MOVEGEN_RESULT *result) {
+    int kept = 0;
+
+    for (int i = 0; i < result->placementCount; i++) {
+        MOVEGEN_PLACEMENT *placement = &result->placements[i];
+        int len = 1;
+        for (int n = gen->placementNodes[i]; gen->nodes[n].parent != -1; n = gen->nodes[n].parent) {
+            len++;
+        }
+        if (result->inputCount + len > MOVEGEN_MAX_INPUTS) {
+            result->truncated = 1;
+            continue;
+        }
+
+        Uint16 *path = &result->inputs[result->inputCount];
+        int pos = len - 1;
+        path[pos--] = gen->placementHeld[i];
+        for (int n = gen->placementNodes[i]; gen->nodes[n].parent != -1; n = gen->nodes[n].parent) {
+            path[pos--] = gen->nodes[n].held;
+        }
+        placement->pathStart = result->inputCount;
+        placement->pathLen = len;
+        result->inputCount += len;
+        result->placements[kept++] = *placement;
+    }
+    result->placementCount = kept;
+}
+
+const MOVEGEN_RESULT *Movegen_Search(MOVEGEN *gen, GAME_CTX *ctx) {
+    if (ctx->state != GAME_STATE_NORMAL) {
+        return NULL;
+    }
+
+    uint64_t key = Movegen_Key(gen, ctx);
+    MOVEGEN_RESULT *result = &gen->cache[key % gen->cacheSize];
+    gen->searches++;
+    if (result->used && (result->key == key) && Movegen_SameStart(&result->start, ctx)) {
+        gen->cacheHits++;
+        return result;
+    }
+
+    result->used = 1;
+    result->key = key;
+    result->start = *ctx;
+    result->placementCount = 0;
+    result->inputCount = 0;
+    result->truncated = 0;
+    result->gravityMerged = 0;
+
+    gen->stamp++;
+    if (gen->stamp == 0) {
+        memset(gen->slotStamps, 0, MOVEGEN_SLOTS * sizeof(*gen->slotStamps));
+        gen->stamp = 1;
+    }
+    memset(gen->placementSlots, -1, sizeof(gen->placementSlots));
+
+    MOVEGEN_NODE *nodes = gen->nodes;
+    int head = 0;
+    int tail = 1;
+    Movegen_FromGame(&nodes[0], ctx);
+    nodes[0].held = 0;
+    nodes[0].parent = -1;
+    Movegen_Insert(gen, result, &nodes[0], 0);
+
+    gen->scratch = *ctx;
+    for (; head < tail; head++) {
+        for (int i = 0; i < MOVEGEN_INPUTS; i++) {
+            MOVEGEN_NODE next;
+
+            Movegen_ToGame(&nodes[head], &gen->scratch);
+            Game_Step(&gen->scratch, movegenInputs[i]);
+            if (gen->scratch.state != GAME_STATE_NORMAL) {
+                Movegen_AddPlacement(gen, result, ctx, head, movegenInputs[i]);
+                // the lock changed the board and everything else
+                gen->scratch = *ctx;
+                continue;
+            }
+
+            Movegen_FromGame(&next, &gen->scratch);
+            next.held = movegenInputs[i];
+            next.parent = head;
+            if (tail == MOVEGEN_MAX_NODES) {
+                result->truncated = 1;
+                continue;
+            }
+            if (Movegen_Insert(gen, result, &next, tail)) {
+                nodes[tail++] = next;
+            }
+        }
+    }
+
+    result->nodes = tail;
+    Movegen_MakePaths(gen, result);
+    return result;
+}
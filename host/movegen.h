@@ -0,0 +1,124 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include <stdint.h>
+
+#include <sega_mth.h>
+
+#include "../game.h"
+#include "../piece.h"
+#include "../speed.h"
+
+// most positions one search visits, and most placements and path inputs one
+// result can hold. a search that runs out of room stops early and sets
+// MOVEGEN_RESULT.truncated
+#define MOVEGEN_MAX_NODES (1 << 20)
+#define MOVEGEN_MAX_PLACEMENTS (512)
+#define MOVEGEN_MAX_INPUTS (32768)
+
+// a spot the piece can lock in. pieces that cover the same squares (like the
+// two flat rotations of an S) count as one placement
+typedef struct {
+    PIECE piece;
+    // the squares it covers: row top of the board and the 3 below it, with the
+    // rows in the format of GAME_CTX.boardRows, row top in the low 16 bits
+    int top;
+    uint64_t cells;
+    // buttons to hold on each tick from the searched position (in
+    // MOVEGEN_RESULT.inputs), the piece locks on the last one
+    int pathStart;
+    int pathLen;
+} MOVEGEN_PLACEMENT;
+
+typedef struct {
+    int placementCount;
+    MOVEGEN_PLACEMENT placements[MOVEGEN_MAX_PLACEMENTS];
+    int inputCount;
+    Uint16 inputs[MOVEGEN_MAX_INPUTS];
+    // set if the search ran out of room, so placements are missing
+    int truncated;
+    // set if the search merged two paths to the same position that differ only
+    // in the gravity timer (see movegen.c). the one it dropped could have
+    // fallen at a different time, so a placement only it reaches could be
+    // missing. this happens in most searches below 1G. every placement listed
+    // is still reachable with its inputs either way
+    int gravityMerged;
+    int nodes; // positions the search visited
+
+    // what the search started from, to check cache hits against
+    int used;
+    uint64_t key;
+    GAME_CTX start;
+} MOVEGEN_RESULT;
+
+// one position in the search: everything Game_Normal reads except the board,
+// which stays the same until the piece locks
+typedef struct {
+    Sint8 x;
+    Sint8 y;
+    Uint8 rotation;
+    Sint8 lockTimer;
+    Sint16 gravityTimer;
+    Sint16 leftTimer;
+    Sint16 rightTimer;
+    Sint16 downTimer;
+    Uint16 prevHeld;
+    Uint16 held; // buttons held on the tick that got here
+    Sint32 parent; // -1 for the starting position
+} MOVEGEN_NODE;
+
+typedef struct {
+    // Zobrist tables, one random word for each value of each part of the state
+    uint64_t cellKeys[GAME_ROWS][GAME_COLS];
+    uint64_t pieceKeys[PIECE_COUNT];
+    uint64_t xKeys[32];
+    uint64_t yKeys[64];
+    uint64_t rotationKeys[4];
+    uint64_t lockKeys[64];
+    uint64_t dasKeys[2][32];
+    uint64_t downKeys[8];
+    uint64_t heldKeys[16];
+    uint64_t levelKeys[SPEED_LEVELS];
+
+    MOVEGEN_NODE *nodes;
+    // open addressed table of node indices, a slot is empty unless its stamp
+    // matches the current search
+    Sint32 *slots;
+    Uint32 *slotStamps;
+    Uint32 stamp;
+    // placement indices by the squares they cover (-1 for empty), and the
+    // position and buttons each placement locked from
+    Sint16 placementSlots[MOVEGEN_MAX_PLACEMENTS * 2];
+    Sint32 placementNodes[MOVEGEN_MAX_PLACEMENTS];
+    Uint16 placementHeld[MOVEGEN_MAX_PLACEMENTS];
+
+    // results by the hash of the board and starting position
+    MOVEGEN_RESULT *cache;
+    int cacheSize;
+    uint64_t searches;
+    uint64_t cacheHits;
+
+    GAME_CTX scratch;
+} MOVEGEN;
+
+// sets up a generator that keeps the results of the last cacheSize different
+// searches, returns 0 if out of memory
+int Movegen_Init(MOVEGEN *gen, int cacheSize);
+
+void Movegen_Free(MOVEGEN *gen);
+
+// the squares a piece covers, in the format of MOVEGEN_PLACEMENT.cells.
+// returns the top row
+int Movegen_Cells(PIECE *piece, uint64_t *cells);
+
+// works out where the piece locked on a tick, from the game before and after
+// it. returns 0 if it didn't lock
+int Movegen_Locked(GAME_CTX *before, GAME_CTX *after, PIECE *piece);
+
+// finds the placements the current piece can reach from where it is now,
+// with the fastest inputs to get there (all of them unless the result is
+// truncated or gravityMerged). ctx has to be in GAME_STATE_NORMAL.
+// the result belongs to the generator and stays valid until the next search
+const MOVEGEN_RESULT *Movegen_Search(MOVEGEN *gen, GAME_CTX *ctx);
+
+#endif
@@ -0,0 +1,175 @@
+// runs the move generator on every piece of some scripted games and reports
+// how many placements it finds and how long it takes. with -c, each
+// placement's inputs are played back with Game_Step to check the piece locks
+// where the search said it would. -r searches each position more than once,
+// the way analysis tools do, which should come from the cache
+//
+// -l starts the games at a higher level, to search with faster gravity
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../game.h"
+#include "movegen.h"
+#include "script.h"
+
+static MOVEGEN gen;
+
+static double Reach_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+// plays a placement's inputs from ctx, returns 0 if the piece doesn't lock on
+// the last one or doesn't cover the placement's squares
+static int Reach_Check(GAME_CTX *ctx, const MOVEGEN_RESULT *result, const MOVEGEN_PLACEMENT *placement) {
+    GAME_CTX copy = *ctx;
+
+    for (int i = 0; i < placement->pathLen; i++) {
+        if (copy.state != GAME_STATE_NORMAL) {
+            return 0;
+        }
+        Game_Step(&copy, result->inputs[placement->pathStart + i]);
+    }
+    if (copy.state == GAME_STATE_NORMAL) {
+        return 0;
+    }
+
+    for (int y = 0; y < PIECE_SIZE; y++) {
+        int row = placement->top + y;
+        Uint16 locked = BOARD_ROW(&copy, row);
+        if ((row >= 0) && (row < GAME_ROWS) && (copy.clearedRows & (1 << row))) {
+            locked = ROW_FULL;
+        }
+        if ((Uint16)(BOARD_ROW(ctx, row) | (placement->cells >> (y * 16))) != locked) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void Reach_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n games] [-s seed] [-l start level] [-r searches per piece] [-c (check paths)]\n", name);
+}
+
+int main(int argc, char **argv) {
+    int games = 10;
+    uint64_t seed = 1;
+    int startLevel = 0;
+    int repeats = 1;
+    int check = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            check = 1;
+            continue;
+        }
+        if ((i + 1 == argc) || (argv[i][0] != '-') || (strlen(argv[i]) != 2)) {
+            Reach_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'n':
+                games = atoi(argv[++i]);
+                break;
+
+            case 's':
+                seed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 'l':
+                startLevel = atoi(argv[++i]);
+                break;
+
+            case 'r':
+                repeats = atoi(argv[++i]);
+                break;
+
+            default:
+                Reach_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if ((games < 1) || (repeats < 1)) {
+        Reach_Usage(argv[0]);
+        return 1;
+    }
+
+    if (!Movegen_Init(&gen, 64)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    uint64_t pieces = 0;
+    uint64_t placements = 0;
+    uint64_t nodes = 0;
+    uint64_t inputs = 0;
+    uint64_t truncated = 0;
+    uint64_t gravityMerged = 0;
+    double elapsed = 0;
+    GAME_CTX ctx;
+
+    for (int game = 0; game < games; game++) {
+        RNG_STATE rng;
+        SCRIPT script;
+        int prevState = GAME_STATE_ARE;
+
+        memset(&ctx, 0, sizeof(ctx));
+        RNG_Seed(&rng, seed + game, 0);
+        Game_Reset(&ctx, &rng);
+        ctx.level = startLevel;
+        Script_Init(&script, seed + game);
+
+        for (;;) {
+            // search each piece on the tick it spawns
+            if ((ctx.state == GAME_STATE_NORMAL) && (prevState != GAME_STATE_NORMAL)) {
+                const MOVEGEN_RESULT *result = NULL;
+
+                double start = Reach_Seconds();
+                for (int r = 0; r < repeats; r++) {
+                    result = Movegen_Search(&gen, &ctx);
+                }
+                elapsed += Reach_Seconds() - start;
+
+                pieces++;
+                placements += result->placementCount;
+                nodes += result->nodes;
+                inputs += result->inputCount;
+                truncated += result->truncated;
+                gravityMerged += result->gravityMerged;
+                if (check) {
+                    for (int i = 0; i < result->placementCount; i++) {
+                        if (!Reach_Check(&ctx, result, &result->placements[i])) {
+                            const PIECE *piece = &result->placements[i].piece;
+                            printf("game %d piece %llu: placement %d (x %d y %d rotation %d) doesn't play back\n",
+                                game, (unsigned long long)pieces, i, piece->x, piece->y, piece->rotation);
+                            return 1;
+                        }
+                    }
+                }
+            }
+            prevState = ctx.state;
+            if (Game_Step(&ctx, Script_Next(&script))) {
+                break;
+            }
+            ctx.sounds = 0;
+            ctx.events = 0;
+        }
+    }
+
+    printf("pieces %llu\n", (unsigned long long)pieces);
+    printf("placements/piece %.1f\n", (double)placements / pieces);
+    printf("positions/piece %.0f\n", (double)nodes / pieces);
+    printf("inputs/placement %.1f\n", placements ? ((double)inputs / placements) : 0.0);
+    printf("truncated %llu\n", (unsigned long long)truncated);
+    printf("gravity merged %llu\n", (unsigned long long)gravityMerged);
+    printf("searches %llu (%llu from the cache)\n", (unsigned long long)gen.searches, (unsigned long long)gen.cacheHits);
+    printf("ms/piece %.3f\n", elapsed * 1000 / pieces);
+    if (check) {
+        printf("every path played back\n");
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+// runs the title screen or the backgrounds through the software VDP and
+// checks the frames against a list of known good hashes, so changes to the
+// graphics code can be tested without real hardware. frames can also be
+// written out as PPM files to look at
+//
+// golden files have one "frame hash" line per checked frame
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sega_scl.h>
+#include <sega_spr.h>
+
+#include "../bg.h"
+#include "../cd.h"
+#include "../print.h"
+#include "../scroll.h"
+#include "../sprite.h"
+#include "../title.h"
+#include "../vblank.h"
+#include "hostsys.h"
+#include "vdp.h"
+
+// the title waits for start after this many frames (the logo and bob
+// screens take 720)
+#define TITLE_START_FRAME (800)
+// the bg scene moves on to the next background this often
+#define BG_FRAMES (600)
+
+#define MAX_CHECKS (4096)
+
+typedef struct {
+    const char *name;
+    int frames; // default length
+    void (*init)(void);
+    // returns 1 when the scene's over
+    int (*run)(int frame);
+} SCENE;
+
+static void Render_TitleInit(void) {
+    Title_Init();
+}
+
+static int Render_TitleRun(int frame) {
+    PadData1 = (frame >= TITLE_START_FRAME) ? PAD_S : 0;
+    PadData1E = (frame == TITLE_START_FRAME) ? PAD_S : 0;
+    return Title_Run() != 0;
+}
+
+static void Render_BgInit(void) {
+    BG_Init();
+}
+
+static int Render_BgRun(int frame) {
+    if ((frame % BG_FRAMES) == 0) {
+        BG_Goto(frame / BG_FRAMES);
+    }
+    BG_Run();
+    return 0;
+}
+
+static const SCENE scenes[] = {
+    {"title", 1000, Render_TitleInit, Render_TitleRun},
+    {"bg", 5000, Render_BgInit, Render_BgRun},
+};
+#define SCENE_COUNT ((int)(sizeof(scenes) / sizeof(scenes[0])))
+
+typedef struct {
+    int frame;
+    uint64_t hash;
+} CHECK;
+
+static double Render_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+// returns the number of checks read, or -1 if the file couldn't be opened
+static int Render_ReadGolden(const char *filename, CHECK *checks) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        return -1;
+    }
+
+    int count = 0;
+    unsigned long long hash;
+    while ((count < MAX_CHECKS) && (fscanf(file, "%d %llx", &checks[count].frame, &hash) == 2)) {
+        checks[count].hash = hash;
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+static int Render_WriteGolden(const char *filename, CHECK *checks, int count) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "%d %016llx\n", checks[i].frame, (unsigned long long)checks[i].hash);
+    }
+    return fclose(file) == 0;
+}
+
+static void Render_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-i disc image] [-n frames] [-e check every n frames] "
+        "[-o ppm dir] [-g golden file] [-u (update golden file)] title|bg\n", name);
+}
+
+int main(int argc, char **argv) {
+    const char *iso = "out/main.iso";
+    const char *outDir = NULL;
+    const char *golden = NULL;
+    const SCENE *scene = NULL;
+    int frames = 0;
+    int every = 60;
+    int update = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            for (int j = 0; j < SCENE_COUNT; j++) {
+                if (strcmp(argv[i], scenes[j].name) == 0) {
+                    scene = &scenes[j];
+                }
+            }
+            if (!scene) {
+                Render_Usage(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "-u") == 0) {
+            update = 1;
+            continue;
+        }
+        if ((i + 1 == argc) || (strlen(argv[i]) != 2)) {
+            Render_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'i':
+                iso = argv[++i];
+                break;
+
+            case 'n':
+                frames = atoi(argv[++i]);
+                break;
+
+            case 'e':
+                every = atoi(argv[++i]);
+                break;
+
+            case 'o':
+                outDir = argv[++i];
+                break;
+
+            case 'g':
+                golden = argv[++i];
+                break;
+
+            default:
+                Render_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!scene || (every <= 0) || (update && !golden)) {
+        Render_Usage(argv[0]);
+        return 1;
+    }
+    if (frames <= 0) {
+        frames = scene->frames;
+    }
+
+    if (!Host_Init(iso)) {
+        fprintf(stderr, "couldn't map Saturn memory or open %s\n", iso);
+        return 1;
+    }
+
+    // same startup as main()
+    SCL_Vdp2Init();
+    CD_Init();
+    Sprite_Init();
+    Scroll_Init();
+    Print_Init();
+    Print_Load();
+    SCL_DisplayFrame();
+    scene->init();
+
+    static CHECK checks[MAX_CHECKS];
+    int checkCount = 0;
+
+    double start = Render_Seconds();
+    int frame;
+    for (frame = 0; frame < frames; frame++) {
+        Sprite_StartDraw();
+        int done = scene->run(frame);
+        Sprite_DrawAll();
+        SPR_2CloseCommand();
+        SCL_DisplayFrame();
+
+        if ((frame % every) == 0 && (checkCount < MAX_CHECKS)) {
+            checks[checkCount].frame = frame;
+            checks[checkCount].hash = Vdp_Hash();
+            checkCount++;
+            if (outDir) {
+                char filename[4096];
+                snprintf(filename, sizeof(filename), "%s/%s%05d.ppm", outDir, scene->name, frame);
+                if (!Vdp_WritePPM(filename)) {
+                    fprintf(stderr, "couldn't write %s\n", filename);
+                    return 1;
+                }
+            }
+        }
+        if (done) {
+            frame++;
+            break;
+        }
+    }
+    double elapsed = Render_Seconds() - start;
+
+    printf("scene %s\n", scene->name);
+    printf("frames %d\n", frame);
+    printf("seconds %.3f\n", elapsed);
+    printf("frames/sec %.0f\n", (elapsed > 0) ? (frame / elapsed) : 0.0);
+
+    if (!golden) {
+        return 0;
+    }
+    if (update) {
+        if (!Render_WriteGolden(golden, checks, checkCount)) {
+            fprintf(stderr, "couldn't write %s\n", golden);
+            return 1;
+        }
+        printf("wrote %d hashes to %s\n", checkCount, golden);
+        return 0;
+    }
+
+    static CHECK expected[MAX_CHECKS];
+    int expectedCount = Render_ReadGolden(golden, expected);
+    if (expectedCount < 0) {
+        fprintf(stderr, "couldn't read %s\n", golden);
+        return 1;
+    }
+    int mismatches = 0;
+    for (int i = 0; i < expectedCount; i++) {
+        int found = 0;
+        for (int j = 0; j < checkCount; j++) {
+            if (checks[j].frame == expected[i].frame) {
+                found = 1;
+                if (checks[j].hash != expected[i].hash) {
+                    printf("frame %d: got %016llx, expected %016llx\n", checks[j].frame,
+                        (unsigned long long)checks[j].hash, (unsigned long long)expected[i].hash);
+                    mismatches++;
+                }
+            }
+        }
+        if (!found) {
+            printf("frame %d: not rendered\n", expected[i].frame);
+            mismatches++;
+        }
+    }
+    printf("mismatches %d\n", mismatches);
+    return mismatches != 0;
+}
@@ -0,0 +1,68 @@
+// turns a replay recorded on the Saturn back into per-tick input, one line
+// per tick: tick number, buttons held, buttons pressed (both in PadData1
+// format). keyframes are listed as comments since they can only be read by
+// the build that made them
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../replayfmt.h"
+#include "replayinput.h"
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s replay\n", argv[0]);
+        return 1;
+    }
+
+    int size;
+    uint8_t *buf = ReplayInput_ReadFile(argv[1], &size);
+    if (!buf) {
+        fprintf(stderr, "couldn't read %s\n", argv[1]);
+        return 1;
+    }
+
+    REPLAY_READER reader;
+    if (!ReplayInput_Start(&reader, buf, size)) {
+        fprintf(stderr, "%s %s\n", argv[1], reader.error);
+        return 1;
+    }
+
+    printf("# seed %llu\n", (unsigned long long)reader.seed);
+    printf("# ticks %u\n", reader.ticks);
+
+    REPLAY_RECORD record;
+    uint32_t tick = 0;
+    uint16_t held = 0;
+    // same as the game: buttons held at the start don't count as presses
+    uint16_t prevHeld = 0xFFFF;
+    int status;
+    while ((status = ReplayInput_Next(&reader, &record)) > 0) {
+        if (record.kind == REPLAY_KIND_RESULT) {
+            printf("# result: score %u level %u rank %u\n", record.result.score, record.result.level,
+                record.result.rank);
+        }
+        for (uint32_t i = 0; i < record.run; i++) {
+            printf("%u %04X %04X\n", tick, held, held & ~prevHeld);
+            prevHeld = held;
+            tick++;
+        }
+        held ^= record.change;
+
+        if (record.kind == REPLAY_KIND_KEYFRAME) {
+            printf("# keyframe at tick %u (%u bytes)\n", tick, record.keyframeSize);
+        }
+    }
+    if (status < 0) {
+        fprintf(stderr, "%s at byte %d\n", reader.error, reader.pos);
+        return 1;
+    }
+
+    if (tick != reader.ticks) {
+        fprintf(stderr, "replay has %u ticks, header says %u\n", tick, reader.ticks);
+        return 1;
+    }
+
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../replayfmt.h"
+#include "replayinput.h"
+
+uint8_t *ReplayInput_ReadFile(const char *filename, int *size) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *buf = malloc(len ? len : 1);
+    if (buf && (fread(buf, 1, len, file) != (size_t)len)) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(file);
+    *size = (int)len;
+    return buf;
+}
+
+int ReplayInput_Start(REPLAY_READER *reader, const uint8_t *buf, int size) {
+    memset(reader, 0, sizeof(*reader));
+    if ((size < REPLAY_HEADER_SIZE) || memcmp(buf, REPLAY_MAGIC, 4)) {
+        reader->error = "isn't a replay";
+        return 0;
+    }
+    reader->buf = buf;
+    reader->seed = ((uint64_t)ReplayFmt_Get32(buf + 4) << 32) | ReplayFmt_Get32(buf + 8);
+    reader->ticks = ReplayFmt_Get32(buf + 12);
+    reader->len = REPLAY_HEADER_SIZE + ReplayFmt_Get32(buf + 16);
+    reader->pos = REPLAY_HEADER_SIZE;
+    if ((reader->len > size) || (reader->len < REPLAY_HEADER_SIZE)) {
+        reader->error = "is truncated";
+        return 0;
+    }
+    return 1;
+}
+
+int ReplayInput_Next(REPLAY_READER *reader, REPLAY_RECORD *record) {
+    uint32_t header;
+
+    if (reader->pos == reader->len) {
+        return 0;
+    }
+    memset(record, 0, sizeof(*record));
+    if (!ReplayFmt_GetVarint(reader->buf, reader->len, &reader->pos, &header)) {
+        reader->error = "bad record";
+        return -1;
+    }
+    record->kind = header & REPLAY_KIND_MASK;
+    record->run = header >> REPLAY_KIND_BITS;
+
+    if (record->kind < REPLAY_KIND_MASKED) {
+        record->change = 1 << record->kind;
+    }
+    else if (record->kind == REPLAY_KIND_MASKED) {
+        uint32_t val;
+        if (!ReplayFmt_GetVarint(reader->buf, reader->len, &reader->pos, &val)) {
+            reader->error = "bad record";
+            return -1;
+        }
+        record->change = val;
+    }
+    else if (record->kind == REPLAY_KIND_KEYFRAME) {
+        if (!ReplayFmt_GetVarint(reader->buf, reader->len, &reader->pos, &record->keyframeSize)) {
+            reader->error = "bad record";
+            return -1;
+        }
+        if (record->keyframeSize > (uint32_t)(reader->len - reader->pos)) {
+            reader->error = "keyframe runs past the end";
+            return -1;
+        }
+        record->keyframePos = reader->pos;
+        reader->pos += record->keyframeSize;
+    }
+    else if (record->kind == REPLAY_KIND_RESULT) {
+        uint32_t vals[3];
+        for (int i = 0; i < 3; i++) {
+            if (!ReplayFmt_GetVarint(reader->buf, reader->len, &reader->pos, &vals[i])) {
+                reader->error = "bad record";
+                return -1;
+            }
+        }
+        record->result.have = 1;
+        record->result.score = vals[0];
+        record->result.level = vals[1];
+        record->result.rank = vals[2];
+    }
+    else {
+        reader->error = "unknown record kind";
+        return -1;
+    }
+    return 1;
+}
+
+Uint16 *ReplayInput_Decode(const uint8_t *buf, int size, uint64_t *seed, uint32_t *ticks, REPLAY_RESULT *result) {
+    REPLAY_READER reader;
+    REPLAY_RECORD record;
+
+    if (!ReplayInput_Start(&reader, buf, size)) {
+        return NULL;
+    }
+    *seed = reader.seed;
+    *ticks = reader.ticks;
+    if (result) {
+        result->have = 0;
+    }
+
+    Uint16 *inputs = malloc((*ticks ? *ticks : 1) * sizeof(Uint16));
+    uint32_t tick = 0;
+    Uint16 held = 0;
+    int status = 0;
+    // keyframes aren't needed, the game is played from the start
+    while (inputs && ((status = ReplayInput_Next(&reader, &record)) > 0)) {
+        if (record.run > *ticks - tick) {
+            status = -1;
+            break;
+        }
+        for (uint32_t i = 0; i < record.run; i++) {
+            inputs[tick++] = held;
+        }
+        held ^= record.change;
+        if (result && record.result.have) {
+            *result = record.result;
+        }
+    }
+
+    if (!inputs || (status != 0) || (tick != *ticks)) {
+        free(inputs);
+        return NULL;
+    }
+    return inputs;
+}
@@ -0,0 +1,54 @@
+#ifndef REPLAYINPUT_H
+#define REPLAYINPUT_H
+
+#include <stdint.h>
+
+#include <sega_mth.h>
+
+// what a replay says its game ended with
+typedef struct {
+    int have; // 0 if the replay doesn't say (the game didn't finish, or it
+              // was recorded before replays had results)
+    Uint32 score;
+    Uint32 level;
+    Uint32 rank;
+} REPLAY_RESULT;
+
+// walks a replay's record stream one record at a time
+typedef struct {
+    const uint8_t *buf;
+    int len; // end of the record stream
+    int pos;
+    uint64_t seed;
+    uint32_t ticks;
+    const char *error; // what was wrong, when something was
+} REPLAY_READER;
+
+typedef struct {
+    int kind;
+    uint32_t run; // ticks the buttons stay the same for before the change
+    Uint16 change; // buttons pressed or released
+    // for REPLAY_KIND_KEYFRAME, where its delta is in the buffer
+    int keyframePos;
+    uint32_t keyframeSize;
+    // for REPLAY_KIND_RESULT
+    REPLAY_RESULT result;
+} REPLAY_RECORD;
+
+// reads a whole file into a malloc'd buffer, returns NULL if it can't
+uint8_t *ReplayInput_ReadFile(const char *filename, int *size);
+
+// reads a replay's header, returns 0 (and sets reader->error) if it isn't a
+// replay or the record stream is cut off
+int ReplayInput_Start(REPLAY_READER *reader, const uint8_t *buf, int size);
+
+// reads the next record, returns 1 if there was one, 0 at the end of the
+// stream, and -1 (with reader->error set) if the record is broken
+int ReplayInput_Next(REPLAY_READER *reader, REPLAY_RECORD *record);
+
+// turns a replay's record stream into the buttons held on each tick (a
+// malloc'd array of *ticks), returns NULL if it's broken. keyframes are
+// skipped, since the game gets played from the start. result can be NULL
+Uint16 *ReplayInput_Decode(const uint8_t *buf, int size, uint64_t *seed, uint32_t *ticks, REPLAY_RESULT *result);
+
+#endif
@@ -0,0 +1,411 @@
+// re-plays every replay in a directory and checks each one ends with the
+// score, level and rank it says it did (the result record Replay_Finish
+// writes), for vetting leaderboard entries. replays are shared out between
+// threads and played with nothing drawn, as fast as the rules engine goes.
+//
+// prints a line for every replay that doesn't check out and a summary of
+// the ones that do. -w fills the directory with replays of games played by
+// the bot instead, for trying it out without a Saturn
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../bot.h"
+#include "../game.h"
+#include "../gravity.h"
+#include "../replayfmt.h"
+#include "replayinput.h"
+
+#define MAX_THREADS (256)
+// longest a -w game can run before it's cut off (an hour and a half of play)
+#define DEFAULT_MAX_TICKS (60 * 60 * 90)
+// the last level bin holds games that reached the end
+#define LEVEL_BIN (100)
+#define LEVEL_BINS (11)
+#define RANK_COUNT (10)
+
+typedef enum {
+    RESULT_OK,
+    RESULT_MISMATCH, // played back to a different result
+    RESULT_UNFINISHED, // the game wasn't over when the input ran out
+    RESULT_NO_CLAIM, // the replay doesn't say how the game ended
+    RESULT_DAMAGED, // not a replay, couldn't be read, or has input after the game ended
+    RESULT_COUNT,
+} RESULT_KIND;
+
+static const char *resultNames[RESULT_COUNT] = {"ok", "mismatch", "unfinished", "no result", "damaged"};
+
+typedef struct {
+    char *path;
+    int kind;
+    uint32_t ticks;
+    uint32_t overTicks; // ticks until the game ended, 0 if it didn't
+    REPLAY_RESULT claimed;
+    // what playing it back gave
+    Uint32 score;
+    Uint32 level;
+    Uint32 rank;
+} JOB;
+
+static JOB *jobs;
+static int jobCount;
+static int nextJob;
+
+static double Rescore_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+// plays a replay back the same way Replay_Reset starts it
+static void Rescore_Job(JOB *job, GAME_CTX *ctx) {
+    int size;
+    uint64_t seed;
+    uint8_t *buf = ReplayInput_ReadFile(job->path, &size);
+    Uint16 *inputs = buf ? ReplayInput_Decode(buf, size, &seed, &job->ticks, &job->claimed) : NULL;
+    free(buf);
+    if (!inputs) {
+        job->kind = RESULT_DAMAGED;
+        return;
+    }
+
+    RNG_STATE rng;
+    RNG_Seed(&rng, seed, 0);
+    memset(ctx, 0, sizeof(*ctx));
+    Game_Reset(ctx, &rng);
+
+    // the game saves the replay on the tick the game ends, so that has to
+    // be the last one
+    int over = 0;
+    for (uint32_t tick = 0; (tick < job->ticks) && !over; tick++) {
+        over = Game_Step(ctx, inputs[tick]);
+        if (over) {
+            job->overTicks = tick + 1;
+        }
+    }
+    free(inputs);
+    job->score = ctx->score;
+    job->level = ctx->level;
+    job->rank = ctx->finalRank;
+
+    if (!job->claimed.have) {
+        job->kind = RESULT_NO_CLAIM;
+    }
+    else if (!over) {
+        job->kind = RESULT_UNFINISHED;
+    }
+    // input carrying on after the game ended
+    else if (job->overTicks != job->ticks) {
+        job->kind = RESULT_DAMAGED;
+    }
+    else if ((job->claimed.score != job->score) || (job->claimed.level != job->level) ||
+        (job->claimed.rank != job->rank)) {
+        job->kind = RESULT_MISMATCH;
+    }
+    else {
+        job->kind = RESULT_OK;
+    }
+}
+
+static void *Rescore_Worker(void *arg) {
+    // GAME_CTX is big enough that it's better off the thread's stack
+    GAME_CTX *ctx = malloc(sizeof(GAME_CTX));
+
+    (void)arg;
+    while (ctx) {
+        int i = __atomic_fetch_add(&nextJob, 1, __ATOMIC_RELAXED);
+        if (i >= jobCount) {
+            break;
+        }
+        Rescore_Job(&jobs[i], ctx);
+    }
+    free(ctx);
+    return NULL;
+}
+
+static int Rescore_CompareJobs(const void *a, const void *b) {
+    return strcmp(((const JOB *)a)->path, ((const JOB *)b)->path);
+}
+
+// makes a job for every file in dir, returns 0 if it can't be read
+static int Rescore_List(const char *dir) {
+    DIR *handle = opendir(dir);
+    int capacity = 0;
+
+    if (!handle) {
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(handle))) {
+        struct stat info;
+        size_t len = strlen(dir) + strlen(entry->d_name) + 2;
+        char *path = malloc(len);
+        if (!path) {
+            break;
+        }
+        snprintf(path, len, "%s/%s", dir, entry->d_name);
+        if ((stat(path, &info) != 0) || !S_ISREG(info.st_mode)) {
+            free(path);
+            continue;
+        }
+
+        if (jobCount == capacity) {
+            capacity = capacity ? (capacity * 2) : 256;
+            JOB *newJobs = realloc(jobs, capacity * sizeof(JOB));
+            if (!newJobs) {
+                free(path);
+                break;
+            }
+            jobs = newJobs;
+        }
+        memset(&jobs[jobCount], 0, sizeof(JOB));
+        jobs[jobCount].path = path;
+        jobCount++;
+    }
+    closedir(handle);
+
+    // same order every run, whatever order the directory lists them in
+    qsort(jobs, jobCount, sizeof(JOB), Rescore_CompareJobs);
+    return 1;
+}
+
+// writes held for run ticks, the same way Replay_Record does (minus the
+// keyframes, which are optional)
+static int Rescore_PutRun(uint8_t *buf, Uint16 changed, uint32_t run) {
+    int len = ReplayFmt_PutVarint(buf, (run << REPLAY_KIND_BITS) | REPLAY_KIND_MASKED);
+    return len + ReplayFmt_PutVarint(buf + len, changed);
+}
+
+// has the bot play a game and saves it as a replay, returns 0 on failure
+static int Rescore_WriteBotGame(const char *dir, uint64_t seed, BOT *bot, GAME_CTX *ctx) {
+    // at most 10 bytes for each tick, and the result
+    uint8_t *buf = malloc(REPLAY_HEADER_SIZE + (DEFAULT_MAX_TICKS * 10) + 20);
+    RNG_STATE rng;
+    int pos = REPLAY_HEADER_SIZE;
+    uint32_t ticks = 0;
+    uint32_t run = 0;
+    Uint16 held = 0;
+    int over = 0;
+
+    if (!buf) {
+        return 0;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    RNG_Seed(&rng, seed, 0);
+    Game_Reset(ctx, &rng);
+    Bot_Init(bot, &botDefaultWeights, 0);
+
+    while (!over && (ticks < DEFAULT_MAX_TICKS)) {
+        Uint16 next = Bot_Input(bot, ctx);
+        if (next != held) {
+            pos += Rescore_PutRun(buf + pos, next ^ held, run);
+            held = next;
+            run = 0;
+        }
+        over = Game_Step(ctx, held);
+        run++;
+        ticks++;
+    }
+    pos += Rescore_PutRun(buf + pos, 0, run);
+    if (over) {
+        pos += ReplayFmt_PutVarint(buf + pos, REPLAY_KIND_RESULT);
+        pos += ReplayFmt_PutVarint(buf + pos, ctx->score);
+        pos += ReplayFmt_PutVarint(buf + pos, ctx->level);
+        pos += ReplayFmt_PutVarint(buf + pos, ctx->finalRank);
+    }
+    memcpy(buf, REPLAY_MAGIC, 4);
+    ReplayFmt_Put32(buf + 4, (uint32_t)(seed >> 32));
+    ReplayFmt_Put32(buf + 8, (uint32_t)seed);
+    ReplayFmt_Put32(buf + 12, ticks);
+    ReplayFmt_Put32(buf + 16, pos - REPLAY_HEADER_SIZE);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%016llx.gmr", dir, (unsigned long long)seed);
+    FILE *file = fopen(path, "wb");
+    int ok = file && (fwrite(buf, 1, pos, file) == (size_t)pos);
+    if (file) {
+        fclose(file);
+    }
+    free(buf);
+    return ok;
+}
+
+static void Rescore_PrintBin(const char *label, uint64_t count, uint64_t total) {
+    double percent = total ? ((100.0 * count) / total) : 0.0;
+    char bar[51];
+    int len = (int)(percent / 2);
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    printf("  %-12s %8llu %6.2f%% %s\n", label, (unsigned long long)count, percent, bar);
+}
+
+static void Rescore_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-j threads] [-q] dir\n", name);
+    fprintf(stderr, "       %s -w games [-s seed] dir (writes bot replays to dir)\n", name);
+}
+
+int main(int argc, char **argv) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int quiet = 0;
+    int writeGames = 0;
+    uint64_t seed = 1;
+    const char *dir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            if (dir) {
+                Rescore_Usage(argv[0]);
+                return 1;
+            }
+            dir = argv[i];
+            continue;
+        }
+        if (!strcmp(argv[i], "-q")) {
+            quiet = 1;
+            continue;
+        }
+        if ((i + 1 == argc) || (strlen(argv[i]) != 2)) {
+            Rescore_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'j':
+                threads = atoi(argv[++i]);
+                break;
+
+            case 's':
+                seed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 'w':
+                writeGames = atoi(argv[++i]);
+                break;
+
+            default:
+                Rescore_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!dir) {
+        Rescore_Usage(argv[0]);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    if (writeGames > 0) {
+        static GAME_CTX ctx;
+        static BOT bot;
+        for (int i = 0; i < writeGames; i++) {
+            if (!Rescore_WriteBotGame(dir, seed + i, &bot, &ctx)) {
+                fprintf(stderr, "couldn't write a replay to %s\n", dir);
+                return 1;
+            }
+        }
+        printf("wrote %d replays\n", writeGames);
+        return 0;
+    }
+
+    if (!Rescore_List(dir)) {
+        fprintf(stderr, "couldn't read %s\n", dir);
+        return 1;
+    }
+
+    double start = Rescore_Seconds();
+    pthread_t ids[MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&ids[i], NULL, Rescore_Worker, NULL) != 0) {
+            fprintf(stderr, "couldn't start thread %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = Rescore_Seconds() - start;
+
+    uint64_t kinds[RESULT_COUNT] = {0};
+    uint64_t levels[LEVEL_BINS] = {0};
+    uint64_t rankCounts[RANK_COUNT] = {0};
+    uint64_t totalTicks = 0;
+    uint64_t totalScore = 0;
+    uint64_t totalLevel = 0;
+    Uint32 bestScore = 0;
+    const char *bestPath = NULL;
+
+    for (int i = 0; i < jobCount; i++) {
+        JOB *job = &jobs[i];
+        kinds[job->kind]++;
+        totalTicks += job->ticks;
+
+        if (job->kind == RESULT_MISMATCH) {
+            printf("%s: mismatch, says score %u level %u rank %u, played back to score %u level %u rank %u\n",
+                job->path, job->claimed.score, job->claimed.level, job->claimed.rank, job->score, job->level,
+                job->rank);
+        }
+        else if ((job->kind == RESULT_DAMAGED) && job->overTicks) {
+            printf("%s: damaged, the game ended on tick %u of %u\n", job->path, job->overTicks, job->ticks);
+        }
+        else if ((job->kind != RESULT_OK) && !quiet) {
+            printf("%s: %s\n", job->path, resultNames[job->kind]);
+        }
+        if (job->kind != RESULT_OK) {
+            continue;
+        }
+
+        totalScore += job->score;
+        totalLevel += job->level;
+        levels[(job->level / LEVEL_BIN < LEVEL_BINS) ? (job->level / LEVEL_BIN) : (LEVEL_BINS - 1)]++;
+        if (job->rank < RANK_COUNT) {
+            rankCounts[job->rank]++;
+        }
+        if (!bestPath || (job->score > bestScore)) {
+            bestScore = job->score;
+            bestPath = job->path;
+        }
+    }
+
+    printf("replays %d\n", jobCount);
+    for (int i = 0; i < RESULT_COUNT; i++) {
+        printf("  %-12s %llu\n", resultNames[i], (unsigned long long)kinds[i]);
+    }
+    if (kinds[RESULT_OK]) {
+        char label[32];
+        printf("avg score %.1f\n", (double)totalScore / kinds[RESULT_OK]);
+        printf("avg level %.1f\n", (double)totalLevel / kinds[RESULT_OK]);
+        printf("best score %u (%s)\n", bestScore, bestPath);
+        printf("final level\n");
+        for (int i = 0; i < LEVEL_BINS; i++) {
+            if (i == LEVEL_BINS - 1) {
+                snprintf(label, sizeof(label), "%d+", i * LEVEL_BIN);
+            }
+            else {
+                snprintf(label, sizeof(label), "%d-%d", i * LEVEL_BIN, (i * LEVEL_BIN) + LEVEL_BIN - 1);
+            }
+            Rescore_PrintBin(label, levels[i], kinds[RESULT_OK]);
+        }
+        // ranks[] has the score each rank starts at (the last one is only
+        // given for finishing)
+        printf("rank\n");
+        for (int i = 0; i < RANK_COUNT; i++) {
+            snprintf(label, sizeof(label), "%d (%d)", i, ranks[i]);
+            Rescore_PrintBin(label, rankCounts[i], kinds[RESULT_OK]);
+        }
+    }
+    printf("ticks %llu\n", (unsigned long long)totalTicks);
+    printf("threads %ld\n", threads);
+    printf("seconds %.3f\n", elapsed);
+    printf("replays/min %.0f\n", (elapsed > 0) ? ((jobCount * 60) / elapsed) : 0.0);
+    printf("ticks/sec %.0f\n", (elapsed > 0) ? (totalTicks / elapsed) : 0.0);
+    return (kinds[RESULT_MISMATCH] || kinds[RESULT_UNFINISHED] || kinds[RESULT_DAMAGED]) ? 1 : 0;
+}
@@ -0,0 +1,480 @@
+// draws a lot of pieces from the game's randomizer (RNG_Get, the real one)
+// and from a couple of others for comparison, and prints how they're
+// distributed: how often each piece comes up, how often a piece repeats
+// straight away, how long each piece goes without showing up (droughts), how
+// many rolls each pick takes, and which piece a game starts with.
+//
+// the pieces are drawn as games of -g pieces each, every game with its own
+// seed (from its number, so results don't depend on the thread count).
+// threads take games a chunk at a time and keep their own counts, which are
+// added up at the end
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../piece.h"
+#include "../rng.h"
+
+#define DEFAULT_PIECES (10000000000ULL)
+#define DEFAULT_GAME_PIECES (1000)
+#define CHUNK_GAMES (256)
+#define MAX_THREADS (256)
+
+// droughts of DROUGHT_BINS - 1 pieces or more go in the last bin
+#define DROUGHT_BINS (48)
+// a drought this long or longer counts as a long one in the summary
+#define LONG_DROUGHT (16)
+// more rolls than this go in the last bin (the first piece's ban can take a
+// few extra)
+#define ROLL_BINS (12)
+
+// these have to match rng.c, to count the rolls RNG_Get takes
+#define RNG_MULT (6364136223846793005ULL)
+#define REROLLS (6)
+#define HISTORY_LEN (RNG_HISTORY_LEN)
+
+// same scaling rng.c uses to turn a random number into 0 to n - 1
+#define RNG_SCALE(r, n) ((((r) >> 16) * (n)) >> 16)
+
+// TGM3 style pool: 5 of each piece, and every piece taken is replaced with
+// the one that's gone longest without showing up
+#define POOL_COPIES (5)
+#define POOL_SIZE (PIECE_COUNT * POOL_COPIES)
+
+typedef struct {
+    RNG_STATE rng;
+    // 7-bag
+    Uint8 bag[PIECE_COUNT];
+    int bagLeft;
+    // 35 piece pool
+    Uint8 pool[POOL_SIZE];
+    Uint8 order[PIECE_COUNT]; // pieces by when they last came up, oldest first
+    int orderCount;
+    Uint8 history[HISTORY_LEN];
+    int first;
+} RANDOMIZER_STATE;
+
+// a piece randomizer: seed sets up a new game, get returns the next piece
+// and the number of random numbers it rolled
+typedef struct {
+    const char *name;
+    void (*seed)(RANDOMIZER_STATE *state, uint64_t seed);
+    int (*get)(RANDOMIZER_STATE *state, int *rolls);
+} RANDOMIZER;
+
+typedef struct {
+    uint64_t pieces;
+    uint64_t counts[PIECE_COUNT];
+    uint64_t repeats;
+    uint64_t droughts[PIECE_COUNT][DROUGHT_BINS];
+    uint64_t droughtSums[PIECE_COUNT];
+    uint64_t longestDrought[PIECE_COUNT];
+    uint64_t rolls[ROLL_BINS];
+    uint64_t firsts[PIECE_COUNT];
+} STATS;
+
+static void TGM_Seed(RANDOMIZER_STATE *state, uint64_t seed) {
+    RNG_Seed(&state->rng, seed, 0);
+}
+
+static int TGM_Get(RANDOMIZER_STATE *state, int *rolls) {
+    uint64_t before = state->rng.state;
+    int piece = RNG_Get(&state->rng);
+
+    // RNG_Get doesn't say how many numbers it rolled, so step the generator's
+    // state until it catches up
+    *rolls = 0;
+    while (before != state->rng.state) {
+        before = (before * RNG_MULT) + state->rng.inc;
+        (*rolls)++;
+    }
+    return piece;
+}
+
+static void Bag_Seed(RANDOMIZER_STATE *state, uint64_t seed) {
+    RNG_Seed(&state->rng, seed, 0);
+    state->bagLeft = 0;
+}
+
+static int Bag_Get(RANDOMIZER_STATE *state, int *rolls) {
+    *rolls = 0;
+    if (state->bagLeft == 0) {
+        // Fisher-Yates shuffle
+        for (int i = 0; i < PIECE_COUNT; i++) {
+            state->bag[i] = i;
+        }
+        for (int i = PIECE_COUNT - 1; i > 0; i--) {
+            int j = RNG_SCALE(RNG_Next(&state->rng), i + 1);
+            Uint8 temp = state->bag[i];
+            state->bag[i] = state->bag[j];
+            state->bag[j] = temp;
+            (*rolls)++;
+        }
+        state->bagLeft = PIECE_COUNT;
+    }
+    return state->bag[--state->bagLeft];
+}
+
+static void Pool_Seed(RANDOMIZER_STATE *state, uint64_t seed) {
+    RNG_Seed(&state->rng, seed, 0);
+    for (int i = 0; i < POOL_SIZE; i++) {
+        state->pool[i] = i % PIECE_COUNT;
+    }
+    state->orderCount = 0;
+    state->history[0] = PIECE_S;
+    state->history[1] = PIECE_Z;
+    state->history[2] = PIECE_S;
+    state->history[3] = PIECE_Z;
+    state->first = 1;
+}
+
+static inline int Pool_InHistory(RANDOMIZER_STATE *state, int piece) {
+    return (state->history[0] == piece) || (state->history[1] == piece) || (state->history[2] == piece) ||
+        (state->history[3] == piece);
+}
+
+static int Pool_Get(RANDOMIZER_STATE *state, int *rolls) {
+    static const Uint8 firstPieces[] = {PIECE_I, PIECE_J, PIECE_L, PIECE_T};
+    int index = -1;
+    int piece;
+
+    *rolls = 0;
+    if (state->first) {
+        // the first piece doesn't come from the pool
+        piece = firstPieces[RNG_SCALE(RNG_Next(&state->rng), 4)];
+        (*rolls)++;
+        state->first = 0;
+    }
+    else {
+        for (int roll = 0; roll < REROLLS; roll++) {
+            index = RNG_SCALE(RNG_Next(&state->rng), POOL_SIZE);
+            piece = state->pool[index];
+            (*rolls)++;
+            if (!Pool_InHistory(state, piece) || (roll == REROLLS - 1)) {
+                break;
+            }
+            // a reroll puts the most droughted piece in the pool too
+            if (state->orderCount) {
+                state->pool[index] = state->order[0];
+            }
+        }
+    }
+
+    // move the piece to the back of the drought order
+    int i = 0;
+    while ((i < state->orderCount) && (state->order[i] != piece)) {
+        i++;
+    }
+    if (i == state->orderCount) {
+        state->orderCount++;
+    }
+    memmove(&state->order[i], &state->order[i + 1], state->orderCount - i - 1);
+    state->order[state->orderCount - 1] = piece;
+    if (index >= 0) {
+        state->pool[index] = state->order[0];
+    }
+
+    memmove(&state->history[1], &state->history[0], HISTORY_LEN - 1);
+    state->history[0] = piece;
+    return piece;
+}
+
+static const RANDOMIZER randomizers[] = {
+    {"tgm (RNG_Get)", TGM_Seed, TGM_Get},
+    {"7-bag", Bag_Seed, Bag_Get},
+    {"35 piece pool", Pool_Seed, Pool_Get},
+};
+#define RANDOMIZER_COUNT ((int)(sizeof(randomizers) / sizeof(randomizers[0])))
+
+typedef struct {
+    STATS stats[RANDOMIZER_COUNT];
+    RANDOMIZER_STATE state;
+} __attribute__((aligned(64))) WORKER;
+
+static WORKER *workers;
+static const char *pieceNames = "IZSJLOT";
+static uint64_t games;
+static uint64_t gamePieces;
+static uint64_t baseSeed;
+static uint64_t nextGame;
+static int enabled[RANDOMIZER_COUNT];
+
+static inline int Stats_Bin(uint64_t val, int bins) {
+    return (val < (uint64_t)bins) ? (int)val : bins - 1;
+}
+
+static void Stats_Game(WORKER *worker, int which, uint64_t game) {
+    const RANDOMIZER *randomizer = &randomizers[which];
+    RANDOMIZER_STATE *state = &worker->state;
+    STATS *stats = &worker->stats[which];
+    uint64_t lastSeen[PIECE_COUNT];
+    int prev = -1;
+    int rolls;
+
+    // a piece's first drought is from the start of the game
+    for (int i = 0; i < PIECE_COUNT; i++) {
+        lastSeen[i] = (uint64_t)-1;
+    }
+    randomizer->seed(state, baseSeed + game);
+    for (uint64_t i = 0; i < gamePieces; i++) {
+        int piece = randomizer->get(state, &rolls);
+
+        stats->counts[piece]++;
+        if (i == 0) {
+            stats->firsts[piece]++;
+        }
+        else {
+            // the first piece's rolls include the ban, so they're left out
+            stats->rolls[Stats_Bin(rolls, ROLL_BINS)]++;
+        }
+        stats->repeats += (piece == prev);
+        prev = piece;
+
+        uint64_t drought = i - lastSeen[piece] - 1;
+        lastSeen[piece] = i;
+        stats->droughts[piece][Stats_Bin(drought, DROUGHT_BINS)]++;
+        stats->droughtSums[piece] += drought;
+        if (drought > stats->longestDrought[piece]) {
+            stats->longestDrought[piece] = drought;
+        }
+    }
+    stats->pieces += gamePieces;
+}
+
+static void *Stats_Worker(void *arg) {
+    WORKER *worker = arg;
+
+    for (;;) {
+        uint64_t begin = __atomic_fetch_add(&nextGame, CHUNK_GAMES, __ATOMIC_RELAXED);
+        if (begin >= games) {
+            break;
+        }
+        uint64_t end = (begin + CHUNK_GAMES < games) ? (begin + CHUNK_GAMES) : games;
+        for (int which = 0; which < RANDOMIZER_COUNT; which++) {
+            if (!enabled[which]) {
+                continue;
+            }
+            for (uint64_t game = begin; game < end; game++) {
+                Stats_Game(worker, which, game);
+            }
+        }
+    }
+    return NULL;
+}
+
+static double Stats_Seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static void Stats_PrintBin(const char *label, uint64_t count, uint64_t total) {
+    double percent = total ? ((100.0 * count) / total) : 0.0;
+    char bar[51];
+    int len = (int)(percent / 2);
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    printf("  %-12s %14llu %8.4f%% %s\n", label, (unsigned long long)count, percent, bar);
+}
+
+static void Stats_Print(const RANDOMIZER *randomizer, STATS *stats) {
+    char label[32];
+    uint64_t rollTotal = 0;
+    uint64_t rollCount = 0;
+    uint64_t firstTotal = 0;
+
+    printf("\n== %s: %llu pieces\n", randomizer->name, (unsigned long long)stats->pieces);
+
+    printf("\npiece frequency\n");
+    for (int i = 0; i < PIECE_COUNT; i++) {
+        snprintf(label, sizeof(label), "%c", pieceNames[i]);
+        Stats_PrintBin(label, stats->counts[i], stats->pieces);
+    }
+
+    printf("\nrepeats (same piece twice in a row) %.4f%%\n",
+        stats->pieces ? ((100.0 * stats->repeats) / stats->pieces) : 0.0);
+
+    printf("\ndroughts (pieces between two of the same piece)\n");
+    printf("  piece        mean  longest  %d+\n", LONG_DROUGHT);
+    for (int i = 0; i < PIECE_COUNT; i++) {
+        uint64_t longOnes = 0;
+        for (int bin = LONG_DROUGHT; bin < DROUGHT_BINS; bin++) {
+            longOnes += stats->droughts[i][bin];
+        }
+        printf("  %c      %10.3f %8llu  %.6f%%\n", pieceNames[i],
+            stats->counts[i] ? ((double)stats->droughtSums[i] / stats->counts[i]) : 0.0,
+            (unsigned long long)stats->longestDrought[i],
+            stats->counts[i] ? ((100.0 * longOnes) / stats->counts[i]) : 0.0);
+    }
+
+    uint64_t all[DROUGHT_BINS] = {0};
+    uint64_t droughtTotal = 0;
+    for (int i = 0; i < PIECE_COUNT; i++) {
+        for (int bin = 0; bin < DROUGHT_BINS; bin++) {
+            all[bin] += stats->droughts[i][bin];
+            droughtTotal += stats->droughts[i][bin];
+        }
+    }
+    printf("\ndrought length, all pieces\n");
+    for (int bin = 0; bin < DROUGHT_BINS; bin++) {
+        if (bin == DROUGHT_BINS - 1) {
+            snprintf(label, sizeof(label), "%d+", bin);
+        }
+        else {
+            snprintf(label, sizeof(label), "%d", bin);
+        }
+        Stats_PrintBin(label, all[bin], droughtTotal);
+    }
+
+    for (int bin = 0; bin < ROLL_BINS; bin++) {
+        rollCount += stats->rolls[bin];
+        rollTotal += stats->rolls[bin] * bin;
+    }
+    printf("\nrandom numbers rolled per piece (mean %.4f, not counting each game's first piece)\n",
+        rollCount ? ((double)rollTotal / rollCount) : 0.0);
+    for (int bin = 0; bin < ROLL_BINS; bin++) {
+        if (bin == ROLL_BINS - 1) {
+            snprintf(label, sizeof(label), "%d+", bin);
+        }
+        else {
+            snprintf(label, sizeof(label), "%d", bin);
+        }
+        Stats_PrintBin(label, stats->rolls[bin], rollCount);
+    }
+
+    for (int i = 0; i < PIECE_COUNT; i++) {
+        firstTotal += stats->firsts[i];
+    }
+    printf("\nfirst piece of a game\n");
+    for (int i = 0; i < PIECE_COUNT; i++) {
+        snprintf(label, sizeof(label), "%c", pieceNames[i]);
+        Stats_PrintBin(label, stats->firsts[i], firstTotal);
+    }
+}
+
+static void Stats_Usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n pieces] [-g pieces per game] [-j threads] [-s seed] "
+        "[-r randomizer (0 tgm, 1 7-bag, 2 pool, can be given more than once)]\n", name);
+}
+
+int main(int argc, char **argv) {
+    uint64_t pieces = DEFAULT_PIECES;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int picked = 0;
+    gamePieces = DEFAULT_GAME_PIECES;
+    baseSeed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if ((i + 1 == argc) || (argv[i][0] != '-') || (strlen(argv[i]) != 2)) {
+            Stats_Usage(argv[0]);
+            return 1;
+        }
+        switch (argv[i][1]) {
+            case 'n':
+                pieces = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 'g':
+                gamePieces = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 'j':
+                threads = atoi(argv[++i]);
+                break;
+
+            case 's':
+                baseSeed = strtoull(argv[++i], NULL, 0);
+                break;
+
+            case 'r': {
+                int which = atoi(argv[++i]);
+                if ((which < 0) || (which >= RANDOMIZER_COUNT)) {
+                    Stats_Usage(argv[0]);
+                    return 1;
+                }
+                enabled[which] = 1;
+                picked = 1;
+                break;
+            }
+
+            default:
+                Stats_Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (gamePieces < 1) {
+        Stats_Usage(argv[0]);
+        return 1;
+    }
+    if (!picked) {
+        for (int i = 0; i < RANDOMIZER_COUNT; i++) {
+            enabled[i] = 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    games = (pieces + gamePieces - 1) / gamePieces;
+
+    workers = aligned_alloc(64, threads * sizeof(WORKER));
+    if (!workers) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    memset(workers, 0, threads * sizeof(WORKER));
+
+    double start = Stats_Seconds();
+    pthread_t ids[MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&ids[i], NULL, Stats_Worker, &workers[i]) != 0) {
+            fprintf(stderr, "couldn't start thread %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = Stats_Seconds() - start;
+
+    uint64_t drawn = 0;
+    for (int which = 0; which < RANDOMIZER_COUNT; which++) {
+        if (!enabled[which]) {
+            continue;
+        }
+        STATS *total = &workers[0].stats[which];
+        for (int t = 1; t < threads; t++) {
+            STATS *stats = &workers[t].stats[which];
+            total->pieces += stats->pieces;
+            total->repeats += stats->repeats;
+            for (int i = 0; i < PIECE_COUNT; i++) {
+                total->counts[i] += stats->counts[i];
+                total->droughtSums[i] += stats->droughtSums[i];
+                total->firsts[i] += stats->firsts[i];
+                if (stats->longestDrought[i] > total->longestDrought[i]) {
+                    total->longestDrought[i] = stats->longestDrought[i];
+                }
+                for (int bin = 0; bin < DROUGHT_BINS; bin++) {
+                    total->droughts[i][bin] += stats->droughts[i][bin];
+                }
+            }
+            for (int bin = 0; bin < ROLL_BINS; bin++) {
+                total->rolls[bin] += stats->rolls[bin];
+            }
+        }
+        Stats_Print(&randomizers[which], total);
+        drawn += total->pieces;
+    }
+
+    printf("\ngames %llu of %llu pieces each\n", (unsigned long long)games, (unsigned long long)gamePieces);
+    printf("threads %ld\n", threads);
+    printf("seconds %.3f\n", elapsed);
+    printf("pieces/sec %.0f\n", (elapsed > 0) ? (drawn / elapsed) : 0.0);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "../vblank.h"
+#include "script.h"
+
+typedef enum {
+    SCRIPT_ROTATE = 0,
+    SCRIPT_MOVE,
+    SCRIPT_DROP,
+    SCRIPT_WAIT,
+} SCRIPT_STEPS;
+
+#define SCRIPT_WAIT_TICKS (40)
+
+void Script_Init(SCRIPT *script, uint64_t seed) {
+    // a different stream from the pieces, so the input doesn't follow them
+    RNG_Seed(&script->rng, seed, 1);
+    script->step = SCRIPT_WAIT;
+    script->ticks = 0;
+    script->held = 0;
+}
+
+Uint16 Script_Next(SCRIPT *script) {
+    while (script->ticks == 0) {
+        script->step = (script->step + 1) % (SCRIPT_WAIT + 1);
+        switch (script->step) {
+            case SCRIPT_ROTATE:
+                // tap and release C for each quarter turn
+                script->ticks = (RNG_Next(&script->rng) % 4) * 2;
+                break;
+
+            case SCRIPT_MOVE:
+                script->ticks = RNG_Next(&script->rng) % 20;
+                script->held = (RNG_Next(&script->rng) & 1) ? PAD_L : PAD_R;
+                break;
+
+            case SCRIPT_DROP:
+                script->ticks = 1;
+                break;
+
+            case SCRIPT_WAIT:
+                script->ticks = SCRIPT_WAIT_TICKS;
+                break;
+        }
+    }
+
+    script->ticks--;
+    switch (script->step) {
+        case SCRIPT_ROTATE:
+            return (script->ticks & 1) ? PAD_C : 0;
+
+        case SCRIPT_MOVE:
+            return script->held;
+
+        case SCRIPT_DROP:
+            return PAD_U;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stdint.h>
+
+#include "../rng.h"
+
+// scripted input for host runs: the script turns the piece, moves it, drops
+// it, then waits for the next one, with the turns and moves picked at random
+typedef struct {
+    RNG_STATE rng;
+    int step;
+    int ticks; // ticks left in this step
+    Uint16 held;
+} SCRIPT;
+
+// starts a script. the same seed always gives the same input
+void Script_Init(SCRIPT *script, uint64_t seed);
+
+// returns the buttons held for this tick (PadData1 format)
+Uint16 Script_Next(SCRIPT *script);
+
+#endif
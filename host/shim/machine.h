@@ -0,0 +1,7 @@
+// host stand-in for the SH-2 intrinsics
+#ifndef MACHINE_H
+#define MACHINE_H
+
+void set_imask(int mask);
+
+#endif
@@ -0,0 +1,7 @@
+// host stand-in for the SBL common definitions
+#ifndef SEGA_DEF_H
+#define SEGA_DEF_H
+
+#include "sega_xpt.h"
+
+#endif
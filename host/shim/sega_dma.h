@@ -0,0 +1,10 @@
+// host stand-in for the SBL DMA library (copies happen right away)
+#ifndef SEGA_DMA_H
+#define SEGA_DMA_H
+
+#include "sega_xpt.h"
+
+void DMA_ScuInit(void);
+void DMA_ScuMemCopy(void *dst, void *src, Uint32 cnt);
+
+#endif
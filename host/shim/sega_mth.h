@@ -0,0 +1,19 @@
+// host stand-in for the parts of the SBL math library the game uses
+#ifndef SEGA_MTH_H
+#define SEGA_MTH_H
+
+#include "sega_xpt.h"
+
+typedef Sint32 Fixed32;
+
+#define MTH_FIXED(a) ((Fixed32)((a) * 65536.0))
+#define FIXED(a) MTH_FIXED(a)
+#define MTH_IntToFixed(a) ((Fixed32)((a) << 16))
+#define MTH_FixedToInt(a) ((a) >> 16)
+
+Fixed32 MTH_Mul(Fixed32 a, Fixed32 b);
+// angles are in degrees
+Fixed32 MTH_Sin(Fixed32 degree);
+Fixed32 MTH_Cos(Fixed32 degree);
+
+#endif
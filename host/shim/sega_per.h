@@ -0,0 +1,21 @@
+// host stand-in for the SBL peripheral library: only the digital pad bits
+#ifndef SEGA_PER_H
+#define SEGA_PER_H
+
+#include "sega_xpt.h"
+
+#define PER_DGT_R (1 << 15)
+#define PER_DGT_L (1 << 14)
+#define PER_DGT_D (1 << 13)
+#define PER_DGT_U (1 << 12)
+#define PER_DGT_S (1 << 11)
+#define PER_DGT_A (1 << 10)
+#define PER_DGT_C (1 << 9)
+#define PER_DGT_B (1 << 8)
+#define PER_DGT_TR (1 << 7)
+#define PER_DGT_X (1 << 6)
+#define PER_DGT_Y (1 << 5)
+#define PER_DGT_Z (1 << 4)
+#define PER_DGT_TL (1 << 3)
+
+#endif
@@ -0,0 +1,116 @@
+// host stand-in for the SBL scroll (VDP2) library. only the calls and
+// settings the game uses are here, see host/vdp.c
+#ifndef SEGA_SCL_H
+#define SEGA_SCL_H
+
+#include "sega_mth.h"
+
+// VDP2 memory, mapped at the same addresses as on the Saturn (see host/vdp.c)
+#define SCL_VDP2_VRAM (0x25E00000)
+#define SCL_VDP2_VRAM_A0 (SCL_VDP2_VRAM)
+#define SCL_VDP2_VRAM_A1 (SCL_VDP2_VRAM + 0x20000)
+#define SCL_VDP2_VRAM_B0 (SCL_VDP2_VRAM + 0x40000)
+#define SCL_VDP2_VRAM_B1 (SCL_VDP2_VRAM + 0x60000)
+#define SCL_VDP2_VRAM_SIZE (0x80000)
+
+// screens
+#define SCL_SPR (1 << 0)
+#define SCL_RBG0 (1 << 1)
+#define SCL_NBG0 (1 << 2)
+#define SCL_NBG1 (1 << 3)
+#define SCL_NBG2 (1 << 4)
+#define SCL_NBG3 (1 << 5)
+#define SCL_RBG_TB_A (1 << 6)
+
+#define SCL_OFFSET_A (0)
+#define SCL_OFFSET_B (1)
+
+#define SCL_CRM15_2048 (0)
+#define SCL_TYPE5 (5)
+#define SCL_MIX (1)
+#define SCL_SP_WINDOW (0)
+
+#define SCL_CHAR_SIZE_1X1 (0)
+#define SCL_CHAR_SIZE_2X2 (1)
+#define SCL_PN1WORD (1)
+#define SCL_PN2WORD (0)
+#define SCL_PN_10BIT (0)
+#define SCL_PN_12BIT (1)
+#define SCL_PL_SIZE_1X1 (0)
+#define SCL_PL_SIZE_2X1 (1)
+#define SCL_COL_TYPE_256 (1)
+#define SCL_CELL (0)
+
+#define SCL_RBG0_CHAR (1)
+#define SCL_RBG0_PN (2)
+#define SCL_RBG0_K (3)
+#define SCL_NON (0)
+#define SCL_X_AXIS (0)
+
+typedef struct {
+    Sint16 red;
+    Sint16 green;
+    Sint16 blue;
+} SclRgb;
+
+typedef struct {
+    Uint8 dispenbl;
+    Uint8 charsize;
+    Uint8 pnamesize;
+    Uint8 flip;
+    Uint8 platesize;
+    Uint8 coltype;
+    Uint8 datatype;
+    Uint16 patnamecontrl;
+    Uint32 plate_addr[16];
+} SclConfig;
+
+typedef struct {
+    Uint8 vramModeA;
+    Uint8 vramModeB;
+    Uint8 vramA0;
+    Uint8 vramA1;
+    Uint8 vramB0;
+    Uint8 vramB1;
+    Uint8 colram;
+} SclVramConfig;
+
+typedef struct {
+    Uint16 zoomenbl;
+} SclNorscl;
+
+extern SclNorscl Scl_n_reg;
+
+void SCL_Vdp2Init(void);
+void SCL_SetColRamMode(Uint32 mode);
+void SCL_SetSpriteMode(Uint8 type, Uint8 colMode, Uint8 winMode);
+void SCL_DisplayFrame(void);
+void SCL_VblankStart(void);
+void SCL_VblankEnd(void);
+
+Uint32 SCL_AllocColRam(Uint32 surface, Uint32 numOfColors, Uint8 transparent);
+void SCL_SetColRam(Uint32 surface, Uint32 index, Uint32 num, void *color);
+void SCL_SetColRamOffset(Uint32 surface, Uint32 offset);
+void SCL_SetBack(Uint32 addr, Uint32 dataSize, Uint16 *data);
+
+void SCL_InitVramConfigTb(SclVramConfig *tp);
+void SCL_SetVramConfig(SclVramConfig *tp);
+void SCL_InitConfigTb(SclConfig *scfg);
+void SCL_SetConfig(Uint16 sclnum, SclConfig *scfg);
+void SCL_InitRotateTable(Uint32 address, Uint16 mode, Uint16 rA, Uint16 rB);
+void SCL_SetCycleTable(Uint16 *tp);
+
+void SCL_Open(Uint32 sclnum);
+void SCL_Close(void);
+void SCL_MoveTo(Fixed32 x, Fixed32 y, Fixed32 z);
+void SCL_Move(Fixed32 x, Fixed32 y, Fixed32 z);
+void SCL_Scale(Fixed32 sx, Fixed32 sy);
+void SCL_RotateTo(Fixed32 xy, Fixed32 z, Fixed32 disp, Uint16 mode);
+void SCL_Rotate(Fixed32 x, Fixed32 y, Fixed32 z);
+
+void SCL_SetPriority(Uint32 surface, Uint8 priority);
+void SCL_SetColMixRate(Uint32 surface, Uint8 rate);
+void SCL_SetColOffset(Uint32 ofs, Uint32 surface, Sint16 red, Sint16 green, Sint16 blue);
+void SCL_SetAutoColOffset(Uint32 ofs, Uint32 interval, Uint32 times, SclRgb *start, SclRgb *end);
+
+#endif
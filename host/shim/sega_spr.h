@@ -0,0 +1,41 @@
+// host stand-in for the SBL sprite (VDP1) library, SPR_2 functions only. see
+// host/vdp.c
+#ifndef SEGA_SPR_H
+#define SEGA_SPR_H
+
+#include "sega_mth.h"
+
+typedef struct {
+    Sint16 x;
+    Sint16 y;
+} XyInt;
+
+#define SPR_TV_NORMAL (0)
+#define SPR_TV_320X224 (0)
+#define SPR_2DRAW_PRTY_OFF (0)
+
+#define COLOR_0 (0 << 3)
+#define COLOR_5 (5 << 3)
+#define NO_GOUR (-1)
+
+#define RGB16_COLOR(r, g, b) ((Uint16)(0x8000 | ((b) << 10) | ((g) << 5) | (r)))
+
+// the work area lives in host/vdp.c
+#define SPR_2DefineWork(name, cmdMax, gourMax, lookupMax, charMax, prtyMax) \
+    static int name;
+
+void SPR_2Initial(void *work);
+void SPR_2SetTvMode(Uint16 mode, Uint16 screenSize, Uint16 doubleInterlace);
+void SPR_2FrameChgIntr(Uint16 frameChgCount);
+void SPR_2FrameEraseData(Uint16 rgbColor);
+void SPR_2ClrAllChar(void);
+void SPR_2SetChar(Uint16 charNo, Uint16 colorMode, Uint16 color, Uint16 width, Uint16 height, void *data);
+
+void SPR_2OpenCommand(Uint16 drawPrtyFlag);
+void SPR_2CloseCommand(void);
+void SPR_2SysClip(Sint32 drawPrty, XyInt *xy);
+void SPR_2NormSpr(Sint32 drawPrty, Uint16 dir, Uint16 drawMode, Uint16 color, Uint16 charNo, XyInt *xy, Sint32 gourTblNo);
+void SPR_2ScaleSpr(Sint32 drawPrty, Uint16 dir, Uint16 drawMode, Uint16 color, Uint16 charNo, XyInt *xy, Sint32 gourTblNo);
+void SPR_2DistSpr(Sint32 drawPrty, Uint16 dir, Uint16 drawMode, Uint16 color, Uint16 charNo, XyInt *xy, Sint32 gourTblNo);
+
+#endif
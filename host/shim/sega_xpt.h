@@ -0,0 +1,21 @@
+// host stand-in for the SBL basic types, sized the same as on the SH-2
+#ifndef SEGA_XPT_H
+#define SEGA_XPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t Uint8;
+typedef int8_t Sint8;
+typedef uint16_t Uint16;
+typedef int16_t Sint16;
+typedef uint32_t Uint32;
+typedef int32_t Sint32;
+typedef int Bool;
+
+#define FALSE (0)
+#define TRUE (1)
+#define OFF (0)
+#define ON (1)
+
+#endif
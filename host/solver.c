@@ -0,0 +1,355 @@
+// searches for replay analysis, on the board bitmasks with the game's own
+// collision and kicks. both are built on a 0-1 breadth first search over x, y
+// and rotation where falling is free and every press costs one: positions
+// reached with no more presses are searched first, so each one's count is the
+// fewest it can be reached with
+//
+// the perfect clear search is a depth first search over the placements of
+// the pieces in order. it only keeps boards where every block is in the rows
+// being cleared, where each enclosed empty area can still be filled by whole
+// pieces (a multiple of 4 squares), and that it hasn't tried already at the
+// same depth
+
+#include <string.h>
+
+#include "../rotate.h"
+#include "movegen.h"
+#include "solver.h"
+
+#define SOLVER_UNSEEN (0xFF)
+#define COL_MASK ((1 << GAME_COLS) - 1)
+// rows a perfect clear can use
+#define PC_MAX_HEIGHT (4)
+// bit (row * GAME_COLS + x) of a packed window of rows, with the wrapping
+// squares masked off when moving left and right
+#define PACKED_LEFT (0x7FDFF7FDFFULL)
+#define PACKED_RIGHT (0xFFBFEFFBFEULL)
+
+typedef enum {
+    MOVE_FALL = 0, // the only free one
+    MOVE_LEFT,
+    MOVE_RIGHT,
+    MOVE_SLIDE_LEFT,
+    MOVE_SLIDE_RIGHT,
+    MOVE_CW,
+    MOVE_CCW,
+    MOVE_COUNT,
+} SOLVER_MOVES;
+
+void Solver_Init(SOLVER *solver) {
+    memset(solver, 0, sizeof(*solver));
+    solver->scratch.rotationSystem = ROTATION_ARS;
+}
+
+static inline int Solver_Index(PIECE *piece) {
+    return (((piece->rotation * SOLVER_YS) + (piece->y - SOLVER_MIN_Y)) * SOLVER_XS) + (piece->x - SOLVER_MIN_X);
+}
+
+static inline int Solver_InRange(PIECE *piece) {
+    return (piece->x >= SOLVER_MIN_X) && (piece->x < GAME_COLS) && (piece->y >= SOLVER_MIN_Y) && (piece->y < GAME_ROWS);
+}
+
+static void Solver_Position(int index, int num, PIECE *piece) {
+    piece->num = num;
+    piece->x = (index % SOLVER_XS) + SOLVER_MIN_X;
+    index /= SOLVER_XS;
+    piece->y = (index % SOLVER_YS) + SOLVER_MIN_Y;
+    piece->rotation = index / SOLVER_YS;
+}
+
+static int Solver_Grounded(GAME_CTX *ctx, PIECE *piece) {
+    PIECE below = *piece;
+    below.y++;
+    return !Game_CheckPiece(ctx, &below);
+}
+
+static void Solver_Drop(GAME_CTX *ctx, PIECE *piece) {
+    while (!Solver_Grounded(ctx, piece)) {
+        piece->y++;
+    }
+}
+
+// moves a piece one column, returns 0 if it's blocked
+static int Solver_Step(GAME_CTX *ctx, PIECE *piece, int dir, int sonic) {
+    PIECE next = *piece;
+    next.x += dir;
+    if (!Solver_InRange(&next) || !Game_CheckPiece(ctx, &next)) {
+        return 0;
+    }
+    if (sonic) {
+        Solver_Drop(ctx, &next);
+    }
+    *piece = next;
+    return 1;
+}
+
+// searches from the spawn position on the board in solver->scratch. stops and
+// returns the presses as soon as the piece can lock in the target squares
+// (if cells isn't 0), otherwise adds every distinct place it can lock to
+// placements (if it isn't NULL) and returns the number of them
+static int Solver_Search(SOLVER *solver, int num, int sonic, int top, uint64_t cells, SOLVER_PLACEMENT *placements) {
+    GAME_CTX *ctx = &solver->scratch;
+    int head = SOLVER_STATES;
+    int tail = SOLVER_STATES;
+    int count = 0;
+    PIECE start = {SPAWN_X, SPAWN_Y, num, 0};
+
+    if (!Game_CheckPiece(ctx, &start)) {
+        return cells ? -1 : 0;
+    }
+    memset(solver->presses, SOLVER_UNSEEN, sizeof(solver->presses));
+    int first = Solver_Index(&start);
+    solver->presses[first] = 0;
+    solver->queue[tail++] = first;
+
+    while (head < tail) {
+        int index = solver->queue[head++];
+        int presses = solver->presses[index];
+        PIECE piece;
+        Solver_Position(index, num, &piece);
+        int grounded = Solver_Grounded(ctx, &piece);
+
+        if (grounded) {
+            uint64_t pieceCells;
+            int pieceTop = Movegen_Cells(&piece, &pieceCells);
+            if (cells) {
+                if ((pieceTop == top) && (pieceCells == cells)) {
+                    return presses;
+                }
+            }
+            else if (placements) {
+                int i;
+                for (i = 0; i < count; i++) {
+                    if ((placements[i].top == pieceTop) && (placements[i].cells == pieceCells)) {
+                        break;
+                    }
+                }
+                if ((i == count) && (count < SOLVER_MAX_PLACEMENTS)) {
+                    placements[count].piece = piece;
+                    placements[count].top = pieceTop;
+                    placements[count].cells = pieceCells;
+                    count++;
+                }
+            }
+        }
+
+        for (int move = 0; move < MOVE_COUNT; move++) {
+            PIECE next = piece;
+            switch (move) {
+                case MOVE_FALL:
+                    if (grounded) {
+                        continue;
+                    }
+                    if (sonic) {
+                        Solver_Drop(ctx, &next);
+                    }
+                    else {
+                        next.y++;
+                    }
+                    break;
+
+                case MOVE_LEFT:
+                case MOVE_RIGHT:
+                    if (!Solver_Step(ctx, &next, (move == MOVE_LEFT) ? -1 : 1, sonic)) {
+                        continue;
+                    }
+                    break;
+
+                case MOVE_SLIDE_LEFT:
+                case MOVE_SLIDE_RIGHT:
+                    // one column is the same as a tap
+                    if (!Solver_Step(ctx, &next, (move == MOVE_SLIDE_LEFT) ? -1 : 1, sonic) ||
+                        !Solver_Step(ctx, &next, (move == MOVE_SLIDE_LEFT) ? -1 : 1, sonic)) {
+                        continue;
+                    }
+                    while (Solver_Step(ctx, &next, (move == MOVE_SLIDE_LEFT) ? -1 : 1, sonic)) {
+                    }
+                    break;
+
+                case MOVE_CW:
+                case MOVE_CCW:
+                    if (!Game_Rotate(ctx, &next, (move == MOVE_CW) ? ROTATE_CLOCKWISE : ROTATE_COUNTERCLOCKWISE) ||
+                        !Solver_InRange(&next)) {
+                        continue;
+                    }
+                    if (sonic) {
+                        Solver_Drop(ctx, &next);
+                    }
+                    break;
+            }
+
+            int nextIndex = Solver_Index(&next);
+            int cost = presses + (move != MOVE_FALL);
+            if (cost >= solver->presses[nextIndex]) {
+                continue;
+            }
+            solver->presses[nextIndex] = cost;
+            // free moves go to the front so they're searched with the
+            // positions they came from
+            if (move == MOVE_FALL) {
+                if (head > 0) {
+                    solver->queue[--head] = nextIndex;
+                }
+            }
+            else if (tail < SOLVER_STATES * 2) {
+                solver->queue[tail++] = nextIndex;
+            }
+        }
+    }
+    return cells ? -1 : count;
+}
+
+int Solver_Finesse(SOLVER *solver, const Uint16 *rows, int num, int sonic, int top, uint64_t cells) {
+    memcpy(solver->scratch.boardRows, rows, sizeof(solver->scratch.boardRows));
+    return Solver_Search(solver, num, sonic, top, cells, NULL);
+}
+
+// the bottom height rows of the playfield, GAME_COLS bits per row
+static inline uint64_t Solver_Pack(const Uint16 *rows, int height) {
+    uint64_t packed = 0;
+    for (int y = 0; y < height; y++) {
+        Uint16 row = rows[GAME_ROWS - height + y + BOARD_PAD];
+        packed |= (uint64_t)((row >> BOARD_WALL) & COL_MASK) << (y * GAME_COLS);
+    }
+    return packed;
+}
+
+// returns 0 if an enclosed empty area in the bottom height rows can't be
+// filled with whole pieces
+static int Solver_Fillable(const Uint16 *rows, int height) {
+    uint64_t all = (1ULL << (height * GAME_COLS)) - 1;
+    uint64_t empty = ~Solver_Pack(rows, height) & all;
+
+    while (empty) {
+        uint64_t area = empty & -empty;
+        uint64_t grown;
+        // flood fill one area a step at a time
+        for (;;) {
+            grown = area | ((area << 1) & PACKED_RIGHT) | ((area >> 1) & PACKED_LEFT) |
+                (area << GAME_COLS) | (area >> GAME_COLS);
+            grown &= empty;
+            if (grown == area) {
+                break;
+            }
+            area = grown;
+        }
+        if (__builtin_popcountll(area) % 4) {
+            return 0;
+        }
+        empty &= ~area;
+    }
+    return 1;
+}
+
+// returns 1 if the board's been tried before at this depth
+static int Solver_Seen(SOLVER *solver, const Uint16 *rows, int height, int depth) {
+    uint64_t key = Solver_Pack(rows, height) | ((uint64_t)height << 40) | ((uint64_t)depth << 44);
+    Uint32 slot = (Uint32)((key * 0x9E3779B97F4A7C15ULL) >> 48) & (SOLVER_MEMO - 1);
+
+    for (int i = 0; i < SOLVER_MEMO; i++) {
+        if (solver->memoStamps[slot] != solver->stamp) {
+            solver->memoStamps[slot] = solver->stamp;
+            solver->memo[slot] = key;
+            return 0;
+        }
+        if (solver->memo[slot] == key) {
+            return 1;
+        }
+        slot = (slot + 1) & (SOLVER_MEMO - 1);
+    }
+    // full, search it again rather than give up
+    return 0;
+}
+
+// adds a piece's squares to the rows and moves everything above the full
+// rows down, returns the number of lines
+static int Solver_Place(Uint16 *rows, int top, uint64_t cells) {
+    int lines = 0;
+
+    for (int y = 0; y < PIECE_SIZE; y++) {
+        rows[top + y + BOARD_PAD] |= (Uint16)(cells >> (y * 16));
+    }
+    for (int y = top; (y < top + PIECE_SIZE) && (y < GAME_ROWS); y++) {
+        if (rows[y + BOARD_PAD] == ROW_FULL) {
+            memmove(&rows[BOARD_PAD + 1], &rows[BOARD_PAD], y * sizeof(Uint16));
+            rows[BOARD_PAD] = ROW_EMPTY;
+            lines++;
+        }
+    }
+    return lines;
+}
+
+static int Solver_Clear(SOLVER *solver, const Uint16 *rows, const Uint8 *pieces, int depth, int count, int height,
+    int sonic) {
+    if (height == 0) {
+        return depth;
+    }
+    if (depth == count) {
+        return 0;
+    }
+
+    // every piece left has to fit in the rows being cleared
+    int filled = __builtin_popcountll(Solver_Pack(rows, height));
+    if ((height * GAME_COLS) - filled > (count - depth) * 4) {
+        return 0;
+    }
+
+    SOLVER_PLACEMENT *placements = solver->placements[depth];
+    memcpy(solver->scratch.boardRows, rows, sizeof(solver->scratch.boardRows));
+    int placementCount = Solver_Search(solver, pieces[depth], sonic, 0, 0, placements);
+
+    for (int i = 0; i < placementCount; i++) {
+        Uint16 next[GAME_ROWS + (BOARD_PAD * 2)];
+
+        if (placements[i].top < GAME_ROWS - height) {
+            continue;
+        }
+        memcpy(next, rows, sizeof(next));
+        int nextHeight = height - Solver_Place(next, placements[i].top, placements[i].cells);
+        if (!Solver_Fillable(next, nextHeight) || Solver_Seen(solver, next, nextHeight, depth + 1)) {
+            continue;
+        }
+        solver->boards++;
+
+        int found = Solver_Clear(solver, next, pieces, depth + 1, count, nextHeight, sonic);
+        if (found) {
+            return found;
+        }
+    }
+    return 0;
+}
+
+int Solver_PerfectClear(SOLVER *solver, const Uint16 *rows, const Uint8 *pieces, int count, int sonic) {
+    int stack = 0;
+    int filled = 0;
+
+    if (count > SOLVER_MAX_DEPTH) {
+        count = SOLVER_MAX_DEPTH;
+    }
+    for (int y = 0; y < GAME_ROWS; y++) {
+        Uint16 row = (rows[y + BOARD_PAD] >> BOARD_WALL) & COL_MASK;
+        if (row && !stack) {
+            stack = GAME_ROWS - y;
+        }
+        filled += __builtin_popcount(row);
+    }
+
+    // each piece adds 4 squares, so the rows cleared decide how many pieces
+    // it takes
+    for (int height = (stack ? stack : 1); height <= PC_MAX_HEIGHT; height++) {
+        int squares = (height * GAME_COLS) - filled;
+        if ((squares % 4) || (squares / 4 > count) || !Solver_Fillable(rows, height)) {
+            continue;
+        }
+        solver->stamp++;
+        if (solver->stamp == 0) {
+            memset(solver->memoStamps, 0, sizeof(solver->memoStamps));
+            solver->stamp = 1;
+        }
+        int found = Solver_Clear(solver, rows, pieces, 0, squares / 4, height, sonic);
+        if (found) {
+            return found;
+        }
+    }
+    return 0;
+}
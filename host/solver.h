@@ -0,0 +1,65 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdint.h>
+
+#include <sega_mth.h>
+
+#include "../game.h"
+#include "../piece.h"
+
+// positions a piece can be in, one for each x, y and rotation that keeps its
+// mask inside the board rows (same as the bot's)
+#define SOLVER_MIN_X (-BOARD_WALL)
+#define SOLVER_XS (GAME_COLS - SOLVER_MIN_X)
+#define SOLVER_MIN_Y (-BOARD_PAD)
+#define SOLVER_YS (GAME_ROWS - SOLVER_MIN_Y)
+#define SOLVER_STATES (PIECE_ROTATIONS * SOLVER_YS * SOLVER_XS)
+
+// most pieces a perfect clear search looks ahead, and most places one piece
+// can lock
+#define SOLVER_MAX_DEPTH (10)
+#define SOLVER_MAX_PLACEMENTS (128)
+// boards the perfect clear search remembers having tried
+#define SOLVER_MEMO (1 << 16)
+
+typedef struct {
+    PIECE piece;
+    int top; // same format as MOVEGEN_PLACEMENT
+    uint64_t cells;
+} SOLVER_PLACEMENT;
+
+// state for the searches, one per thread. each search takes the board as
+// GAME_CTX.boardRows and a flag for gravity of a row or more per tick
+// ("sonic"), which drops the piece to the ground after every move
+typedef struct {
+    // fewest presses to reach each position (0xFF if it hasn't been)
+    Uint8 presses[SOLVER_STATES];
+    // double ended queue for the 0-1 breadth first search
+    Sint16 queue[SOLVER_STATES * 2];
+
+    SOLVER_PLACEMENT placements[SOLVER_MAX_DEPTH][SOLVER_MAX_PLACEMENTS];
+    uint64_t memo[SOLVER_MEMO];
+    Uint32 memoStamps[SOLVER_MEMO];
+    Uint32 stamp;
+    uint64_t boards; // boards the perfect clear searches have tried
+
+    // the board for Game_CheckPiece and Game_Rotate
+    GAME_CTX scratch;
+} SOLVER;
+
+void Solver_Init(SOLVER *solver);
+
+// fewest presses of left, right and the turn buttons that get piece num from
+// its spawn position to lock in the given squares. dropping is free, since
+// gravity always gets the piece down eventually. one press of left or right
+// can also be held to slide the piece as far as it goes. returns -1 if the
+// squares can't be reached
+int Solver_Finesse(SOLVER *solver, const Uint16 *rows, int num, int sonic, int top, uint64_t cells);
+
+// looks for a perfect clear (every block on the board cleared) using the
+// pieces in order, at most count of them. returns the number of pieces it
+// takes, or 0 if there isn't one
+int Solver_PerfectClear(SOLVER *solver, const Uint16 *rows, const Uint8 *pieces, int count, int sonic);
+
+#endif
@@ -0,0 +1,884 @@
+// software VDP1/VDP2 for the host build. implements the SCL_* and SPR_2*
+// calls the game makes, and builds each frame from VRAM and color RAM the way
+// VDP2 does: the scroll screens are drawn a line at a time from the lowest
+// priority up, with the VDP1 framebuffer treated as one more screen.
+//
+// only what the game uses is handled: 256 color cell screens with 1 word
+// pattern names, 16 bit RGB and 4 bit sprites, color RAM mode 0, and RBG0
+// without a coefficient table (which makes its rotation affine: one start
+// point and step per line). color offsets are applied to each screen's
+// colors before mixing rather than after, which only differs when a mixed
+// result would clip
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <sega_dma.h>
+#include <sega_scl.h>
+#include <sega_spr.h>
+
+#include "vdp.h"
+
+typedef enum {
+    LAYER_NBG0 = 0,
+    LAYER_NBG1,
+    LAYER_NBG2,
+    LAYER_NBG3,
+    LAYER_RBG0,
+    LAYER_SPR,
+} LAYERS;
+#define LAYER_COUNT (6)
+
+#define CRAM_COLORS (2048)
+#define CRAM_MASK (CRAM_COLORS - 1)
+
+// 1 word pattern name fields
+#define PN_PALETTE(pn) (((pn) >> 12) & 0x7)
+#define PN_HFLIP (1 << 10)
+#define PN_VFLIP (1 << 11)
+
+// pattern name and character units in VRAM
+#define CHAR_UNIT (0x20)
+#define CELL_BYTES (64) // one 8x8 256 color cell
+
+// VDP1 command flip bits
+#define DIR_HFLIP (1 << 4)
+#define DIR_VFLIP (1 << 5)
+#define DRAW_COLOR_MODE(mode) (((mode) >> 3) & 0x7)
+
+#define VDP1_VRAM_SIZE (0x80000)
+#define VDP1_CHAR_MAX (1024)
+
+// the game writes VRAM through volatile pointers, but nothing changes it
+// while a frame's being drawn
+static const Uint8 *vdp2Vram = (const Uint8 *)SCL_VDP2_VRAM;
+
+// color RAM (RGB555) and where each screen's colors start in it
+static Uint16 cram[CRAM_COLORS];
+static int cramOffset[LAYER_COUNT];
+static int cramNext;
+
+static SclConfig config[LAYER_COUNT];
+static Uint8 priority[LAYER_COUNT];
+static int mixRate[LAYER_COUNT]; // -1 if color calculation is off
+static int offsetSelect[LAYER_COUNT]; // -1 if color offset is off
+static Uint16 backColor;
+
+static SclRgb offsets[2];
+typedef struct {
+    SclRgb start;
+    SclRgb end;
+    Uint32 interval;
+    Uint32 times;
+    Uint32 frames;
+    int active;
+} AUTO_OFFSET;
+static AUTO_OFFSET autoOffsets[2];
+
+typedef struct {
+    Fixed32 x;
+    Fixed32 y;
+    Fixed32 scaleX;
+    Fixed32 scaleY;
+} SCROLL_POS;
+static SCROLL_POS scroll[LAYER_RBG0];
+
+// rotation parameter table A: position and angles (degrees) around x, y, z
+static Fixed32 rotX;
+static Fixed32 rotY;
+static Fixed32 rotAngles[3];
+
+static Uint32 openScreens;
+SclNorscl Scl_n_reg;
+
+// RGB555 to 0x00RRGGBB, and each screen's colors with its offset applied
+static uint32_t rgb555[0x8000];
+static uint32_t layerColors[LAYER_COUNT][CRAM_COLORS];
+static int colorsDirty;
+
+typedef struct {
+    Uint16 width;
+    Uint16 height;
+    Uint32 addr;
+} SPR_CHAR;
+
+static Uint8 vdp1Vram[VDP1_VRAM_SIZE];
+static Uint32 vdp1Used;
+static SPR_CHAR chars[VDP1_CHAR_MAX];
+static Uint16 spriteFb[VDP_HEIGHT][VDP_WIDTH];
+static int clipRight;
+static int clipBottom;
+
+static uint32_t frame[VDP_HEIGHT * VDP_WIDTH];
+
+// everything the line renderer needs for one scroll screen, worked out once
+// per frame
+typedef struct {
+    int layer;
+    const Uint16 *map;
+    Uint32 charBase; // character number supplement
+    int charShift; // log2 of a character's width in dots
+    int pageShift; // log2 of a page's width in characters
+    int bigChars; // 2x2 cell characters
+    int flipBits; // 10 bit character numbers with flip bits
+    int cramBase;
+    const uint32_t *colors;
+    int mix;
+} SCREEN_SETUP;
+
+// RBG0 start point and step for each line (16.16 plane coordinates)
+typedef struct {
+    Sint32 x;
+    Sint32 y;
+    Sint32 dx;
+    Sint32 dy;
+} ROT_LINE;
+static ROT_LINE rotLines[VDP_HEIGHT];
+
+static inline Uint16 Vdp_Get16(const void *ptr) {
+    const Uint8 *bytes = ptr;
+    return (bytes[0] << 8) | bytes[1];
+}
+
+static inline uint32_t Vdp_Offset(uint32_t rgb, const SclRgb *offset) {
+    int r = ((rgb >> 16) & 0xFF) + offset->red;
+    int g = ((rgb >> 8) & 0xFF) + offset->green;
+    int b = (rgb & 0xFF) + offset->blue;
+    r = (r < 0) ? 0 : (r > 255) ? 255 : r;
+    g = (g < 0) ? 0 : (g > 255) ? 255 : g;
+    b = (b < 0) ? 0 : (b > 255) ? 255 : b;
+    return (r << 16) | (g << 8) | b;
+}
+
+// color calculation: rate 0 is almost all top, 31 is all bottom
+static inline uint32_t Vdp_Mix(uint32_t top, uint32_t bottom, int rate) {
+    uint32_t topRB = top & 0xFF00FF;
+    uint32_t topG = top & 0xFF00;
+    uint32_t botRB = bottom & 0xFF00FF;
+    uint32_t botG = bottom & 0xFF00;
+    uint32_t rb = ((topRB * (31 - rate)) + (botRB * (rate + 1))) >> 5;
+    uint32_t g = ((topG * (31 - rate)) + (botG * (rate + 1))) >> 5;
+    return (rb & 0xFF00FF) | (g & 0xFF00);
+}
+
+// loops over each screen in an SCL surface mask
+#define FOR_LAYERS(mask, layer) \
+    for (int layer = 0; layer < LAYER_COUNT; layer++) \
+        if ((mask) & layerBits[layer])
+
+static const Uint32 layerBits[LAYER_COUNT] = {
+    [LAYER_NBG0] = SCL_NBG0,
+    [LAYER_NBG1] = SCL_NBG1,
+    [LAYER_NBG2] = SCL_NBG2,
+    [LAYER_NBG3] = SCL_NBG3,
+    [LAYER_RBG0] = SCL_RBG0,
+    [LAYER_SPR] = SCL_SPR,
+};
+
+int Vdp_Init(void) {
+    void *addr = (void *)(uintptr_t)SCL_VDP2_VRAM;
+    void *mapped = mmap(addr, SCL_VDP2_VRAM_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mapped != addr) {
+        return 0;
+    }
+
+    for (int i = 0; i < 0x8000; i++) {
+        int r = i & 0x1F;
+        int g = (i >> 5) & 0x1F;
+        int b = (i >> 10) & 0x1F;
+        r = (r << 3) | (r >> 2);
+        g = (g << 3) | (g >> 2);
+        b = (b << 3) | (b >> 2);
+        rgb555[i] = (r << 16) | (g << 8) | b;
+    }
+
+    SCL_Vdp2Init();
+    SPR_2ClrAllChar();
+    return 1;
+}
+
+const uint32_t *Vdp_Frame(void) {
+    return frame;
+}
+
+// VDP2
+
+void SCL_Vdp2Init(void) {
+    memset(config, 0, sizeof(config));
+    memset(priority, 0, sizeof(priority));
+    memset(offsets, 0, sizeof(offsets));
+    memset(autoOffsets, 0, sizeof(autoOffsets));
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        cramOffset[i] = 0;
+        mixRate[i] = -1;
+        offsetSelect[i] = -1;
+    }
+    for (int i = 0; i < LAYER_RBG0; i++) {
+        scroll[i].x = 0;
+        scroll[i].y = 0;
+        scroll[i].scaleX = FIXED(1);
+        scroll[i].scaleY = FIXED(1);
+    }
+    rotX = 0;
+    rotY = 0;
+    memset(rotAngles, 0, sizeof(rotAngles));
+    cramNext = 0;
+    backColor = 0;
+    openScreens = 0;
+    Scl_n_reg.zoomenbl = 0;
+    colorsDirty = 1;
+}
+
+void SCL_SetColRamMode(Uint32 mode) {
+}
+
+void SCL_SetSpriteMode(Uint8 type, Uint8 colMode, Uint8 winMode) {
+}
+
+void SCL_VblankStart(void) {
+}
+
+void SCL_VblankEnd(void) {
+}
+
+// steps the automatic color offsets, once per frame like the vblank handler
+static void Vdp_StepOffsets(void) {
+    for (int i = 0; i < 2; i++) {
+        AUTO_OFFSET *fade = &autoOffsets[i];
+        if (!fade->active) {
+            continue;
+        }
+
+        fade->frames++;
+        if (fade->frames % fade->interval) {
+            continue;
+        }
+        Uint32 step = fade->frames / fade->interval;
+        if (step >= fade->times) {
+            offsets[i] = fade->end;
+            fade->active = 0;
+        }
+        else {
+            offsets[i].red = fade->start.red + ((fade->end.red - fade->start.red) * (int)step / (int)fade->times);
+            offsets[i].green = fade->start.green + ((fade->end.green - fade->start.green) * (int)step / (int)fade->times);
+            offsets[i].blue = fade->start.blue + ((fade->end.blue - fade->start.blue) * (int)step / (int)fade->times);
+        }
+        colorsDirty = 1;
+    }
+}
+
+void SCL_DisplayFrame(void) {
+    Vdp_Composite();
+    Vdp_StepOffsets();
+}
+
+Uint32 SCL_AllocColRam(Uint32 surface, Uint32 numOfColors, Uint8 transparent) {
+    Uint32 start = cramNext;
+
+    FOR_LAYERS(surface, layer) {
+        cramOffset[layer] = start;
+    }
+    cramNext += numOfColors;
+    return start;
+}
+
+// color data comes straight from the (big endian) asset files
+void SCL_SetColRam(Uint32 surface, Uint32 index, Uint32 num, void *color) {
+    FOR_LAYERS(surface, layer) {
+        for (Uint32 i = 0; i < num; i++) {
+            cram[(cramOffset[layer] + index + i) & CRAM_MASK] = Vdp_Get16((Uint8 *)color + (i * 2));
+        }
+    }
+    colorsDirty = 1;
+}
+
+void SCL_SetColRamOffset(Uint32 surface, Uint32 offset) {
+    FOR_LAYERS(surface, layer) {
+        cramOffset[layer] = offset;
+    }
+    colorsDirty = 1;
+}
+
+void SCL_SetBack(Uint32 addr, Uint32 dataSize, Uint16 *data) {
+    backColor = data[0];
+}
+
+void SCL_InitVramConfigTb(SclVramConfig *tp) {
+    memset(tp, 0, sizeof(*tp));
+}
+
+void SCL_SetVramConfig(SclVramConfig *tp) {
+}
+
+void SCL_InitConfigTb(SclConfig *scfg) {
+    memset(scfg, 0, sizeof(*scfg));
+}
+
+void SCL_SetConfig(Uint16 sclnum, SclConfig *scfg) {
+    FOR_LAYERS(sclnum, layer) {
+        config[layer] = *scfg;
+    }
+}
+
+void SCL_InitRotateTable(Uint32 address, Uint16 mode, Uint16 rA, Uint16 rB) {
+}
+
+void SCL_SetCycleTable(Uint16 *tp) {
+}
+
+void SCL_Open(Uint32 sclnum) {
+    openScreens = sclnum;
+}
+
+void SCL_Close(void) {
+    openScreens = 0;
+}
+
+void SCL_MoveTo(Fixed32 x, Fixed32 y, Fixed32 z) {
+    FOR_LAYERS(openScreens, layer) {
+        if (layer < LAYER_RBG0) {
+            scroll[layer].x = x;
+            scroll[layer].y = y;
+        }
+    }
+    if (openScreens & SCL_RBG_TB_A) {
+        rotX = x;
+        rotY = y;
+    }
+}
+
+void SCL_Move(Fixed32 x, Fixed32 y, Fixed32 z) {
+    FOR_LAYERS(openScreens, layer) {
+        if (layer < LAYER_RBG0) {
+            scroll[layer].x += x;
+            scroll[layer].y += y;
+        }
+    }
+    if (openScreens & SCL_RBG_TB_A) {
+        rotX += x;
+        rotY += y;
+    }
+}
+
+void SCL_Scale(Fixed32 sx, Fixed32 sy) {
+    FOR_LAYERS(openScreens, layer) {
+        if ((layer < LAYER_RBG0) && (sx > 0) && (sy > 0)) {
+            scroll[layer].scaleX = sx;
+            scroll[layer].scaleY = sy;
+        }
+    }
+}
+
+// xy is the angle around the axis mode picks, z is the angle around z
+void SCL_RotateTo(Fixed32 xy, Fixed32 z, Fixed32 disp, Uint16 mode) {
+    if (openScreens & SCL_RBG_TB_A) {
+        rotAngles[0] = (mode == SCL_X_AXIS) ? xy : 0;
+        rotAngles[1] = (mode == SCL_X_AXIS) ? 0 : xy;
+        rotAngles[2] = z;
+    }
+}
+
+void SCL_Rotate(Fixed32 x, Fixed32 y, Fixed32 z) {
+    if (openScreens & SCL_RBG_TB_A) {
+        rotAngles[0] += x;
+        rotAngles[1] += y;
+        rotAngles[2] += z;
+    }
+}
+
+void SCL_SetPriority(Uint32 surface, Uint8 prio) {
+    FOR_LAYERS(surface, layer) {
+        priority[layer] = prio;
+    }
+}
+
+void SCL_SetColMixRate(Uint32 surface, Uint8 rate) {
+    FOR_LAYERS(surface, layer) {
+        mixRate[layer] = rate & 0x1F;
+    }
+}
+
+void SCL_SetColOffset(Uint32 ofs, Uint32 surface, Sint16 red, Sint16 green, Sint16 blue) {
+    offsets[ofs].red = red;
+    offsets[ofs].green = green;
+    offsets[ofs].blue = blue;
+    autoOffsets[ofs].active = 0;
+    FOR_LAYERS(surface, layer) {
+        offsetSelect[layer] = ofs;
+    }
+    colorsDirty = 1;
+}
+
+void SCL_SetAutoColOffset(Uint32 ofs, Uint32 interval, Uint32 times, SclRgb *start, SclRgb *end) {
+    AUTO_OFFSET *fade = &autoOffsets[ofs];
+
+    fade->start = *start;
+    fade->end = *end;
+    fade->interval = interval ? interval : 1;
+    fade->times = times ? times : 1;
+    fade->frames = 0;
+    fade->active = 1;
+    offsets[ofs] = *start;
+    colorsDirty = 1;
+}
+
+// DMA
+
+void DMA_ScuInit(void) {
+}
+
+void DMA_ScuMemCopy(void *dst, void *src, Uint32 cnt) {
+    memcpy(dst, src, cnt);
+}
+
+// VDP1
+
+void SPR_2Initial(void *work) {
+    SPR_2ClrAllChar();
+    clipRight = VDP_WIDTH - 1;
+    clipBottom = VDP_HEIGHT - 1;
+}
+
+void SPR_2SetTvMode(Uint16 mode, Uint16 screenSize, Uint16 doubleInterlace) {
+}
+
+void SPR_2FrameChgIntr(Uint16 frameChgCount) {
+}
+
+void SPR_2FrameEraseData(Uint16 rgbColor) {
+}
+
+void SPR_2ClrAllChar(void) {
+    vdp1Used = 0;
+    memset(chars, 0, sizeof(chars));
+}
+
+void SPR_2SetChar(Uint16 charNo, Uint16 colorMode, Uint16 color, Uint16 width, Uint16 height, void *data) {
+    Uint32 bytes = (colorMode == COLOR_5) ? (width * height * 2) : ((width * height) / 2);
+
+    if ((charNo >= VDP1_CHAR_MAX) || (vdp1Used + bytes > VDP1_VRAM_SIZE)) {
+        fprintf(stderr, "vdp: no room for sprite character %d\n", charNo);
+        return;
+    }
+    memcpy(&vdp1Vram[vdp1Used], data, bytes);
+    chars[charNo].width = width;
+    chars[charNo].height = height;
+    chars[charNo].addr = vdp1Used;
+    // VDP1 addresses characters in 32 byte units
+    vdp1Used = (vdp1Used + bytes + 31) & ~31;
+}
+
+void SPR_2OpenCommand(Uint16 drawPrtyFlag) {
+    // the framebuffer is erased on every frame change
+    memset(spriteFb, 0, sizeof(spriteFb));
+}
+
+void SPR_2CloseCommand(void) {
+}
+
+void SPR_2SysClip(Sint32 drawPrty, XyInt *xy) {
+    clipRight = (xy->x < VDP_WIDTH) ? xy->x : VDP_WIDTH - 1;
+    clipBottom = (xy->y < VDP_HEIGHT) ? xy->y : VDP_HEIGHT - 1;
+}
+
+// returns a character's dot in framebuffer format (0 is transparent)
+static inline Uint16 Vdp_Texel(const SPR_CHAR *ch, Uint16 drawMode, Uint16 color, int u, int v) {
+    int dot = (v * ch->width) + u;
+
+    if (DRAW_COLOR_MODE(drawMode) == 5) {
+        return Vdp_Get16(&vdp1Vram[(ch->addr + (dot * 2)) % VDP1_VRAM_SIZE]);
+    }
+    // 4 bit color bank, high nibble first
+    Uint8 byte = vdp1Vram[(ch->addr + (dot / 2)) % VDP1_VRAM_SIZE];
+    int code = (dot & 1) ? (byte & 0xF) : (byte >> 4);
+    return code ? ((color & 0x7FF0) | code) : 0;
+}
+
+static inline void Vdp_Plot(int x, int y, Uint16 texel) {
+    if (texel && (x >= 0) && (y >= 0) && (x <= clipRight) && (y <= clipBottom)) {
+        spriteFb[y][x] = texel;
+    }
+}
+
+// draws the character stretched over (x0, y0)-(x1, y1) inclusive
+static void Vdp_DrawRect(const SPR_CHAR *ch, Uint16 dir, Uint16 drawMode, Uint16 color,
+        int x0, int y0, int x1, int y1) {
+    int w = ch->width;
+    int h = ch->height;
+    if (x1 < x0) {
+        int tmp = x0; x0 = x1; x1 = tmp;
+        dir ^= DIR_HFLIP;
+    }
+    if (y1 < y0) {
+        int tmp = y0; y0 = y1; y1 = tmp;
+        dir ^= DIR_VFLIP;
+    }
+    int dw = x1 - x0 + 1;
+    int dh = y1 - y0 + 1;
+
+    for (int dy = 0; dy < dh; dy++) {
+        int v = (dy * h) / dh;
+        if (dir & DIR_VFLIP) {
+            v = h - 1 - v;
+        }
+        for (int dx = 0; dx < dw; dx++) {
+            int u = (dx * w) / dw;
+            if (dir & DIR_HFLIP) {
+                u = w - 1 - u;
+            }
+            Vdp_Plot(x0 + dx, y0 + dy, Vdp_Texel(ch, drawMode, color, u, v));
+        }
+    }
+}
+
+void SPR_2NormSpr(Sint32 drawPrty, Uint16 dir, Uint16 drawMode, Uint16 color, Uint16 charNo, XyInt *xy, Sint32 gourTblNo) {
+    const SPR_CHAR *ch = &chars[charNo % VDP1_CHAR_MAX];
+    if (ch->width && ch->height) {
+        Vdp_DrawRect(ch, dir, drawMode, color, xy[0].x, xy[0].y,
+            xy[0].x + ch->width - 1, xy[0].y + ch->height - 1);
+    }
+}
+
+void SPR_2ScaleSpr(Sint32 drawPrty, Uint16 dir, Uint16 drawMode, Uint16 color, Uint16 charNo, XyInt *xy, Sint32 gourTblNo) {
+    const SPR_CHAR *ch = &chars[charNo % VDP1_CHAR_MAX];
+    if (ch->width && ch->height) {
+        Vdp_DrawRect(ch, dir, drawMode, color, xy[0].x, xy[0].y, xy[1].x, xy[1].y);
+    }
+}
+
+static inline int Vdp_Span(int ax, int ay, int bx, int by) {
+    int dx = abs(bx - ax);
+    int dy = abs(by - ay);
+    return (dx > dy) ? dx : dy;
+}
+
+// like VDP1: walks the left (0-3) and right (1-2) edges a texel row at a
+// time and draws a line of texels between them, with enough steps that the
+// quad has no gaps
+void SPR_2DistSpr(Sint32 drawPrty, Uint16 dir, Uint16 drawMode, Uint16 color, Uint16 charNo, XyInt *xy, Sint32 gourTblNo) {
+    const SPR_CHAR *ch = &chars[charNo % VDP1_CHAR_MAX];
+    int w = ch->width;
+    int h = ch->height;
+    if (!w || !h) {
+        return;
+    }
+
+    int rows = Vdp_Span(xy[0].x, xy[0].y, xy[3].x, xy[3].y);
+    int rightRows = Vdp_Span(xy[1].x, xy[1].y, xy[2].x, xy[2].y);
+    rows = ((rightRows > rows) ? rightRows : rows) + 1;
+    if (rows < h) {
+        rows = h;
+    }
+
+    for (int i = 0; i < rows; i++) {
+        // 16.16 edge points for this row
+        Sint32 lx = (xy[0].x << 16) + (((xy[3].x - xy[0].x) << 16) / (rows > 1 ? rows - 1 : 1)) * i;
+        Sint32 ly = (xy[0].y << 16) + (((xy[3].y - xy[0].y) << 16) / (rows > 1 ? rows - 1 : 1)) * i;
+        Sint32 rx = (xy[1].x << 16) + (((xy[2].x - xy[1].x) << 16) / (rows > 1 ? rows - 1 : 1)) * i;
+        Sint32 ry = (xy[1].y << 16) + (((xy[2].y - xy[1].y) << 16) / (rows > 1 ? rows - 1 : 1)) * i;
+        int v = (i * h) / rows;
+        if (dir & DIR_VFLIP) {
+            v = h - 1 - v;
+        }
+
+        int cols = Vdp_Span(lx >> 16, ly >> 16, rx >> 16, ry >> 16) + 1;
+        if (cols < w) {
+            cols = w;
+        }
+        Sint32 stepX = (rx - lx) / (cols > 1 ? cols - 1 : 1);
+        Sint32 stepY = (ry - ly) / (cols > 1 ? cols - 1 : 1);
+        for (int j = 0; j < cols; j++) {
+            int u = (j * w) / cols;
+            if (dir & DIR_HFLIP) {
+                u = w - 1 - u;
+            }
+            Vdp_Plot((lx + (stepX * j) + 0x8000) >> 16, (ly + (stepY * j) + 0x8000) >> 16,
+                Vdp_Texel(ch, drawMode, color, u, v));
+        }
+    }
+}
+
+// compositing
+
+static void Vdp_BuildColors(void) {
+    for (int layer = 0; layer < LAYER_COUNT; layer++) {
+        uint32_t *colors = layerColors[layer];
+        int select = offsetSelect[layer];
+        for (int i = 0; i < CRAM_COLORS; i++) {
+            colors[i] = rgb555[cram[i] & 0x7FFF];
+            if (select >= 0) {
+                colors[i] = Vdp_Offset(colors[i], &offsets[select]);
+            }
+        }
+    }
+    colorsDirty = 0;
+}
+
+static void Vdp_SetupScreen(SCREEN_SETUP *setup, int layer) {
+    SclConfig *cfg = &config[layer];
+    Uint16 supplement = cfg->patnamecontrl & 0x1F;
+
+    setup->layer = layer;
+    setup->map = (const Uint16 *)(uintptr_t)cfg->plate_addr[0];
+    // the top 3 bits of the supplement become character number bits 14-12
+    setup->charBase = (supplement & 0x1C) << 10;
+    setup->bigChars = (cfg->charsize == SCL_CHAR_SIZE_2X2);
+    // a page is 512x512 dots either way
+    setup->charShift = setup->bigChars ? 4 : 3;
+    setup->pageShift = setup->bigChars ? 5 : 6;
+    setup->flipBits = (cfg->flip == SCL_PN_10BIT);
+    setup->cramBase = cramOffset[layer];
+    setup->colors = &layerColors[layer][0];
+    setup->mix = mixRate[layer];
+}
+
+// finds the 8 dot character row under plane position (px, py). returns a
+// pointer to the row and sets *flip if it's drawn backwards, and *palette to
+// the row's first color RAM index
+static inline const Uint8 *Vdp_CharRow(const SCREEN_SETUP *setup, Uint32 px, Uint32 py,
+        int *flip, int *palette) {
+    Uint32 pageMask = (1 << setup->pageShift) - 1;
+    Uint32 charMask = (1 << setup->charShift) - 1;
+    Uint32 cellX = (px >> setup->charShift) & pageMask;
+    Uint32 cellY = (py >> setup->charShift) & pageMask;
+    Uint16 pn = setup->map[(cellY << setup->pageShift) + cellX];
+
+    Uint32 charNo;
+    Uint32 x = px & charMask;
+    Uint32 y = py & charMask;
+    *flip = 0;
+    if (setup->flipBits) {
+        charNo = pn & 0x3FF;
+        if (pn & PN_HFLIP) {
+            x = charMask - x;
+            *flip = 1;
+        }
+        if (pn & PN_VFLIP) {
+            y = charMask - y;
+        }
+    }
+    else {
+        charNo = pn & 0xFFF;
+    }
+    *palette = setup->cramBase + (PN_PALETTE(pn) << 8);
+
+    Uint32 addr;
+    if (setup->bigChars) {
+        // four cells: upper left, upper right, lower left, lower right
+        addr = ((setup->charBase + (charNo << 2)) * CHAR_UNIT)
+            + ((((y >> 3) * 2) + (x >> 3)) * CELL_BYTES) + ((y & 7) * 8);
+    }
+    else {
+        addr = ((setup->charBase + charNo) * CHAR_UNIT) + (y * 8);
+    }
+    return vdp2Vram + (addr & (SCL_VDP2_VRAM_SIZE - 1));
+}
+
+static inline void Vdp_Put(uint32_t *line, int x, uint32_t color, int mix) {
+    line[x] = (mix >= 0) ? Vdp_Mix(color, line[x], mix) : color;
+}
+
+// a line that's not rotated or scaled: decodes 8 dots at a time, skipping
+// rows that are all transparent
+static void Vdp_DrawFlatLine(const SCREEN_SETUP *setup, uint32_t *line, Uint32 px, Uint32 py) {
+    int x = 0;
+
+    while (x < VDP_WIDTH) {
+        int flip;
+        int palette;
+        const Uint8 *row = Vdp_CharRow(setup, px, py, &flip, &palette);
+        int start = px & 7;
+        int count = 8 - start;
+        if (count > VDP_WIDTH - x) {
+            count = VDP_WIDTH - x;
+        }
+
+        uint64_t dots;
+        memcpy(&dots, row, sizeof(dots));
+        if (dots) {
+            const uint32_t *colors = setup->colors;
+            for (int i = 0; i < count; i++) {
+                int dx = start + i;
+                Uint8 dot = row[flip ? (7 - dx) : dx];
+                if (dot) {
+                    Vdp_Put(line, x + i, colors[(palette + dot) & CRAM_MASK], setup->mix);
+                }
+            }
+        }
+        x += count;
+        px += count;
+    }
+}
+
+// a line that's rotated or scaled: (px, py) and its step are 16.16
+static void Vdp_DrawStepLine(const SCREEN_SETUP *setup, uint32_t *line, Sint32 px, Sint32 py,
+        Sint32 dx, Sint32 dy) {
+    for (int x = 0; x < VDP_WIDTH; x++, px += dx, py += dy) {
+        int flip;
+        int palette;
+        Uint32 dotX = (Uint32)(px >> 16);
+        const Uint8 *row = Vdp_CharRow(setup, dotX, (Uint32)(py >> 16), &flip, &palette);
+        Uint8 dot = row[flip ? (7 - (dotX & 7)) : (dotX & 7)];
+        if (dot) {
+            Vdp_Put(line, x, setup->colors[(palette + dot) & CRAM_MASK], setup->mix);
+        }
+    }
+}
+
+static void Vdp_DrawNbgLine(const SCREEN_SETUP *setup, uint32_t *line, int y) {
+    SCROLL_POS *pos = &scroll[setup->layer];
+
+    if ((pos->scaleX == FIXED(1)) && (pos->scaleY == FIXED(1))) {
+        Vdp_DrawFlatLine(setup, line, (Uint32)MTH_FixedToInt(pos->x), (Uint32)(MTH_FixedToInt(pos->y) + y));
+    }
+    else {
+        Sint32 stepX = (Sint32)(((int64_t)1 << 32) / pos->scaleX);
+        Sint32 stepY = (Sint32)(((int64_t)1 << 32) / pos->scaleY);
+        Vdp_DrawStepLine(setup, line, pos->x, pos->y + (stepY * y), stepX, 0);
+    }
+}
+
+// works out RBG0's start point and step for every line. the plane is turned
+// by the 2x2 part of the rotation matrix (no perspective without a
+// coefficient table) around the center of the screen
+static void Vdp_SetupRotation(void) {
+    double ax = (rotAngles[0] / 65536.0) * (M_PI / 180.0);
+    double ay = (rotAngles[1] / 65536.0) * (M_PI / 180.0);
+    double az = (rotAngles[2] / 65536.0) * (M_PI / 180.0);
+    // R = Rz * Ry * Rx, top left 2x2
+    double a = cos(az) * cos(ay);
+    double b = (cos(az) * sin(ay) * sin(ax)) - (sin(az) * cos(ax));
+    double d = sin(az) * cos(ay);
+    double e = (sin(az) * sin(ay) * sin(ax)) + (cos(az) * cos(ax));
+    double cx = VDP_WIDTH / 2;
+    double cy = VDP_HEIGHT / 2;
+
+    for (int y = 0; y < VDP_HEIGHT; y++) {
+        double sy = y - cy;
+        rotLines[y].x = (Sint32)((((a * -cx) + (b * sy) + cx) * 65536.0)) + rotX;
+        rotLines[y].y = (Sint32)((((d * -cx) + (e * sy) + cy) * 65536.0)) + rotY;
+        rotLines[y].dx = (Sint32)lround(a * 65536.0);
+        rotLines[y].dy = (Sint32)lround(d * 65536.0);
+    }
+}
+
+static void Vdp_DrawRbgLine(const SCREEN_SETUP *setup, uint32_t *line, int y) {
+    ROT_LINE *rot = &rotLines[y];
+
+    // the plane repeats every 512 dots
+    if ((rot->dx == FIXED(1)) && (rot->dy == 0)) {
+        Vdp_DrawFlatLine(setup, line, (Uint32)(rot->x >> 16) & 511, (Uint32)(rot->y >> 16) & 511);
+    }
+    else {
+        Vdp_DrawStepLine(setup, line, rot->x, rot->y, rot->dx, rot->dy);
+    }
+}
+
+static void Vdp_DrawSpriteLine(uint32_t *line, int y) {
+    const Uint16 *fb = spriteFb[y];
+    int select = offsetSelect[LAYER_SPR];
+    int mix = mixRate[LAYER_SPR];
+
+    for (int x = 0; x < VDP_WIDTH; x++) {
+        Uint16 dot = fb[x];
+        if (!dot) {
+            continue;
+        }
+        uint32_t color;
+        if (dot & 0x8000) {
+            color = rgb555[dot & 0x7FFF];
+            if (select >= 0) {
+                color = Vdp_Offset(color, &offsets[select]);
+            }
+        }
+        else {
+            color = layerColors[LAYER_SPR][(cramOffset[LAYER_SPR] + dot) & CRAM_MASK];
+        }
+        Vdp_Put(line, x, color, mix);
+    }
+}
+
+void Vdp_Composite(void) {
+    SCREEN_SETUP setups[LAYER_COUNT];
+    int order[LAYER_COUNT];
+    int count = 0;
+
+    if (colorsDirty) {
+        Vdp_BuildColors();
+    }
+
+    // screens from the bottom up. on a tie, sprites go over RBG0, which
+    // goes over NBG0, then NBG1...
+    static const int tieOrder[LAYER_COUNT] = {LAYER_NBG3, LAYER_NBG2, LAYER_NBG1, LAYER_NBG0, LAYER_RBG0, LAYER_SPR};
+    for (int prio = 1; prio <= 7; prio++) {
+        for (int i = 0; i < LAYER_COUNT; i++) {
+            int layer = tieOrder[i];
+            if (priority[layer] != prio) {
+                continue;
+            }
+            if ((layer != LAYER_SPR) && !config[layer].dispenbl) {
+                continue;
+            }
+            if (layer != LAYER_SPR) {
+                Vdp_SetupScreen(&setups[layer], layer);
+            }
+            order[count++] = layer;
+        }
+    }
+    if (priority[LAYER_RBG0] && config[LAYER_RBG0].dispenbl) {
+        Vdp_SetupRotation();
+    }
+
+    uint32_t back = rgb555[backColor & 0x7FFF];
+    for (int y = 0; y < VDP_HEIGHT; y++) {
+        uint32_t *line = &frame[y * VDP_WIDTH];
+        for (int x = 0; x < VDP_WIDTH; x++) {
+            line[x] = back;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int layer = order[i];
+            if (layer == LAYER_SPR) {
+                Vdp_DrawSpriteLine(line, y);
+            }
+            else if (layer == LAYER_RBG0) {
+                Vdp_DrawRbgLine(&setups[layer], line, y);
+            }
+            else {
+                Vdp_DrawNbgLine(&setups[layer], line, y);
+            }
+        }
+    }
+}
+
+uint64_t Vdp_Hash(void) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < VDP_WIDTH * VDP_HEIGHT; i++) {
+        hash = (hash ^ ((frame[i] >> 16) & 0xFF)) * 1099511628211ULL;
+        hash = (hash ^ ((frame[i] >> 8) & 0xFF)) * 1099511628211ULL;
+        hash = (hash ^ (frame[i] & 0xFF)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+int Vdp_WritePPM(const char *filename) {
+    static Uint8 rgb[VDP_WIDTH * VDP_HEIGHT * 3];
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        return 0;
+    }
+
+    for (int i = 0; i < VDP_WIDTH * VDP_HEIGHT; i++) {
+        rgb[(i * 3) + 0] = frame[i] >> 16;
+        rgb[(i * 3) + 1] = frame[i] >> 8;
+        rgb[(i * 3) + 2] = frame[i];
+    }
+    fprintf(file, "P6\n%d %d\n255\n", VDP_WIDTH, VDP_HEIGHT);
+    int ok = (fwrite(rgb, 1, sizeof(rgb), file) == sizeof(rgb));
+    return (fclose(file) == 0) && ok;
+}
@@ -0,0 +1,27 @@
+#ifndef VDP_H
+#define VDP_H
+
+#include <stdint.h>
+
+#define VDP_WIDTH (320)
+#define VDP_HEIGHT (224)
+
+// maps VDP2 VRAM at its Saturn address, must be called before anything else
+// touches it. returns 0 if the memory couldn't be mapped
+int Vdp_Init(void);
+
+// the last frame composited by SCL_DisplayFrame, one 0x00RRGGBB pixel per
+// dot
+const uint32_t *Vdp_Frame(void);
+
+// composites VDP2 and the VDP1 framebuffer into the frame (SCL_DisplayFrame
+// calls this, it's exposed for benchmarking)
+void Vdp_Composite(void);
+
+// FNV-1a hash of the frame's RGB bytes
+uint64_t Vdp_Hash(void);
+
+// writes the frame as a binary PPM, returns 0 on failure
+int Vdp_WritePPM(const char *filename);
+
+#endif
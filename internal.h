@@ -0,0 +1,27 @@
+#ifndef INTERNAL_H
+#define INTERNAL_H
+// functions that are only used inside their own file, but that host/bench.c
+// times on their own. they're static unless the file is built with
+// BENCH_EXPORT, which only the bench's copies of game.c and sprite.c are
+
+#include <sega_mth.h>
+
+#include "game.h"
+
+#ifdef BENCH_EXPORT
+#define INTERNAL
+
+// game.c
+void Game_UpdateSurface(GAME_CTX *ctx);
+int Game_CheckBelow(GAME_CTX *ctx, PIECE *piece);
+void Game_RemoveLines(GAME_CTX *ctx);
+int Game_CheckLines(GAME_CTX *ctx, PIECE *piece);
+
+// sprite.c
+int Sprite_LoadPal(Uint8 *buffer, int *count);
+int Sprite_LoadRGB(Uint8 *buffer, int *count);
+#else
+#define INTERNAL static
+#endif
+
+#endif
@@ -14,7 +14,7 @@
 #include "bg.h"
 #include "cd.h"
 #include "devcart.h"
-#include "game.h"
+#include "play.h"
 #include "rank.h"
 #include "release.h"
 #include "scroll.h"
@@ -33,6 +33,8 @@ typedef enum {
 } GAME_STATE;
 
 int state;
+// controllers that started the game
+int pads;
 
 int main() {
 	frame = 0;
@@ -57,7 +59,7 @@ int main() {
     
     /*
     state = STATE_GAME;
-    Game_Init();
+    Play_Init();
     */
     while (1) {
         frame++;
@@ -85,16 +87,28 @@ int main() {
         
         switch (state) {
             case STATE_TITLE:
-                if (Title_Run()) {
-                    Game_Init();
+                pads = Title_Run();
+                if (pads == TITLE_DEMO) {
+                    Play_InitDemo();
+                    state = STATE_GAME;
+                }
+                else if (pads) {
+                    Play_Init(pads);
                     state = STATE_GAME;
                 }
                 break;
 
             case STATE_GAME:
-                if (Game_Run()) {
-                    Rank_Init();
-                    state = STATE_RANK;
+                switch (Play_Run()) {
+                    case PLAY_DONE_RANK:
+                        Rank_Init();
+                        state = STATE_RANK;
+                        break;
+
+                    case PLAY_DONE_TITLE:
+                        Title_Init();
+                        state = STATE_TITLE;
+                        break;
                 }
                 break;
 
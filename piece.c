@@ -1,193 +1,159 @@
 #include "piece.h"
 
-int pieces[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE][PIECE_SIZE] = {
-    { // I piece
-        {
-            {0, 0, 0, 0},
-            {1, 1, 1, 1},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0},
-        },
-        {
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-        },
-        {
-            {0, 0, 0, 0},
-            {1, 1, 1, 1},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0},
-        },
-        {
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-        },
-    },
+// every rotation of every piece, listed once. the block, mask and bottom
+// tables below are all built from it at compile time (so there's nothing to
+// set up, and threads can share them): SHAPE gets a piece's four rotations,
+// ROTATION a rotation's four rows and ROW a row's four squares
+#define PIECE_SHAPES(SHAPE, ROTATION, ROW) \
+    /* I piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(1, 1, 1, 1), \
+                 ROW(0, 0, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 1, 0), \
+                 ROW(0, 0, 1, 0), \
+                 ROW(0, 0, 1, 0), \
+                 ROW(0, 0, 1, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(1, 1, 1, 1), \
+                 ROW(0, 0, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 1, 0), \
+                 ROW(0, 0, 1, 0), \
+                 ROW(0, 0, 1, 0), \
+                 ROW(0, 0, 1, 0))), \
+    /* Z piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(2, 2, 0, 0), \
+                 ROW(0, 2, 2, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 2, 0), \
+                 ROW(0, 2, 2, 0), \
+                 ROW(0, 2, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(2, 2, 0, 0), \
+                 ROW(0, 2, 2, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 2, 0), \
+                 ROW(0, 2, 2, 0), \
+                 ROW(0, 2, 0, 0), \
+                 ROW(0, 0, 0, 0))), \
+    /* S piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 3, 3, 0), \
+                 ROW(3, 3, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(3, 0, 0, 0), \
+                 ROW(3, 3, 0, 0), \
+                 ROW(0, 3, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 3, 3, 0), \
+                 ROW(3, 3, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(3, 0, 0, 0), \
+                 ROW(3, 3, 0, 0), \
+                 ROW(0, 3, 0, 0), \
+                 ROW(0, 0, 0, 0))), \
+    /* J piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(4, 4, 4, 0), \
+                 ROW(0, 0, 4, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 4, 4, 0), \
+                 ROW(0, 4, 0, 0), \
+                 ROW(0, 4, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(4, 0, 0, 0), \
+                 ROW(4, 4, 4, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 4, 0, 0), \
+                 ROW(0, 4, 0, 0), \
+                 ROW(4, 4, 0, 0), \
+                 ROW(0, 0, 0, 0))), \
+    /* L piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(5, 5, 5, 0), \
+                 ROW(5, 0, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 5, 0, 0), \
+                 ROW(0, 5, 0, 0), \
+                 ROW(0, 5, 5, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 0, 5, 0), \
+                 ROW(5, 5, 5, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(5, 5, 0, 0), \
+                 ROW(0, 5, 0, 0), \
+                 ROW(0, 5, 0, 0), \
+                 ROW(0, 0, 0, 0))), \
+    /* O piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 6, 6, 0), \
+                 ROW(0, 0, 0, 0))), \
+    /* T piece */ \
+    SHAPE( \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(7, 7, 7, 0), \
+                 ROW(0, 7, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 7, 0, 0), \
+                 ROW(0, 7, 7, 0), \
+                 ROW(0, 7, 0, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 0, 0, 0), \
+                 ROW(0, 7, 0, 0), \
+                 ROW(7, 7, 7, 0), \
+                 ROW(0, 0, 0, 0)), \
+        ROTATION(ROW(0, 7, 0, 0), \
+                 ROW(7, 7, 0, 0), \
+                 ROW(0, 7, 0, 0), \
+                 ROW(0, 0, 0, 0)))
 
-    { // Z piece
-        {
-            {0, 0, 0, 0},
-            {2, 2, 0, 0},
-            {0, 2, 2, 0},
-            {0, 0, 0, 0},
-        },
-        {
-            {0, 0, 2, 0},
-            {0, 2, 2, 0},
-            {0, 2, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {2, 2, 0, 0},
-            {0, 2, 2, 0},
-            {0, 0, 0, 0},
-        },
-        {
-            {0, 0, 2, 0},
-            {0, 2, 2, 0},
-            {0, 2, 0, 0},
-            {0, 0, 0, 0}
-        },
-    },
-    
-    { // S piece
-        {
-            {0, 0, 0, 0},
-            {0, 3, 3, 0},
-            {3, 3, 0, 0}, 
-            {0, 0, 0, 0}
-        },
-        {
-            {3, 0, 0, 0},
-            {3, 3, 0, 0},
-            {0, 3, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 3, 3, 0},
-            {3, 3, 0, 0}, 
-            {0, 0, 0, 0}
-        },
-        {
-            {3, 0, 0, 0},
-            {3, 3, 0, 0},
-            {0, 3, 0, 0},
-            {0, 0, 0, 0}
-        },
-    },
+#define BLOCK_SHAPE(r0, r1, r2, r3) {r0, r1, r2, r3}
+#define BLOCK_ROTATION(y0, y1, y2, y3) {y0, y1, y2, y3}
+#define BLOCK_ROW(x0, x1, x2, x3) {x0, x1, x2, x3}
 
-    { // J piece
-        {
-            {0, 0, 0, 0},
-            {4, 4, 4, 0},
-            {0, 0, 4, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 4, 4, 0},
-            {0, 4, 0, 0},
-            {0, 4, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {4, 0, 0, 0},
-            {4, 4, 4, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 4, 0, 0},
-            {0, 4, 0, 0},
-            {4, 4, 0, 0},
-            {0, 0, 0, 0}
-        }
-    },
-
-    { // L piece
-        {
-            {0, 0, 0, 0},
-            {5, 5, 5, 0},
-            {5, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 5, 0, 0},
-            {0, 5, 0, 0},
-            {0, 5, 5, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 0, 5, 0},
-            {5, 5, 5, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {5, 5, 0, 0},
-            {0, 5, 0, 0},
-            {0, 5, 0, 0},
-            {0, 0, 0, 0}
-        }
-    },
+const Uint8 pieces[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE][PIECE_SIZE] = {
+    PIECE_SHAPES(BLOCK_SHAPE, BLOCK_ROTATION, BLOCK_ROW)
+};
 
-    { // O piece
-        {
-            {0, 0, 0, 0},
-            {0, 6, 6, 0},
-            {0, 6, 6, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 6, 6, 0},
-            {0, 6, 6, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 6, 6, 0},
-            {0, 6, 6, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 6, 6, 0},
-            {0, 6, 6, 0},
-            {0, 0, 0, 0}
-        }
-    },
+// a row packed into a mask, bit x for column x
+#define MASK_ROW(x0, x1, x2, x3) \
+    (((x0) ? (1 << 0) : 0) | ((x1) ? (1 << 1) : 0) | ((x2) ? (1 << 2) : 0) | ((x3) ? (1 << 3) : 0))
 
-    { // T piece
-        {
-            {0, 0, 0, 0},
-            {7, 7, 7, 0},
-            {0, 7, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 7, 0, 0},
-            {0, 7, 7, 0},
-            {0, 7, 0, 0},
-            {0, 0, 0, 0},
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 7, 0, 0},
-            {7, 7, 7, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 7, 0, 0},
-            {7, 7, 0, 0},
-            {0, 7, 0, 0},
-            {0, 0, 0, 0}
-        }
-    }
+const Uint8 pieceMasks[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE] = {
+    PIECE_SHAPES(BLOCK_SHAPE, BLOCK_ROTATION, MASK_ROW)
 };
 
+// the lowest of the four row masks with column x set
+#define BOTTOM(y0, y1, y2, y3, x) \
+    (((y3) & (1 << (x))) ? 3 : ((y2) & (1 << (x))) ? 2 : ((y1) & (1 << (x))) ? 1 : ((y0) & (1 << (x))) ? 0 : -1)
+#define BOTTOM_ROTATION(y0, y1, y2, y3) \
+    {BOTTOM(y0, y1, y2, y3, 0), BOTTOM(y0, y1, y2, y3, 1), BOTTOM(y0, y1, y2, y3, 2), BOTTOM(y0, y1, y2, y3, 3)}
+
+const Sint8 pieceBottoms[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE] = {
+    PIECE_SHAPES(BLOCK_SHAPE, BOTTOM_ROTATION, MASK_ROW)
+};
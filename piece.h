@@ -1,6 +1,8 @@
 #ifndef PIECE_H
 #define PIECE_H
 
+#include <sega_mth.h>
+
 typedef enum {
     PIECE_I = 0,
     PIECE_Z,
@@ -15,7 +17,14 @@ typedef enum {
 #define PIECE_ROTATIONS (4)
 #define PIECE_SIZE (4)
 
-extern int pieces[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE][PIECE_SIZE];
+// block tile numbers for each piece (0 is empty)
+extern const Uint8 pieces[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE][PIECE_SIZE];
+
+// one bitmask per piece row, bit x set if column x of the row has a block
+extern const Uint8 pieceMasks[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE];
+
+// lowest row with a block in each piece column (-1 if the column is empty)
+extern const Sint8 pieceBottoms[PIECE_COUNT][PIECE_ROTATIONS][PIECE_SIZE];
 
 #endif
 
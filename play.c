@@ -0,0 +1,653 @@
+#include <sega_scl.h>
+#include <sega_tim.h>
+
+#include "bg.h"
+#include "bot.h"
+#include "cd.h"
+#include "devcart.h"
+#include "game.h"
+#include "piece.h"
+#include "play.h"
+#include "print.h"
+#include "rank.h"
+#include "release.h"
+#include "replay.h"
+#include "rewind.h"
+#include "scroll.h"
+#include "sprite.h"
+#include "sound.h"
+#include "statehash.h"
+#include "vblank.h"
+
+static int borderBase;
+#define BORDER_WIDTH (13)
+#define BORDER_HEIGHT (22)
+#define NEXT_TILE (borderBase + 286)
+#define SCORE_TILE (borderBase + 290)
+#define LEVEL_TILE (borderBase + 294)
+#define RANKING_TILE (borderBase + 299)
+#define DIGITS_TILE (borderBase + 312)
+#define BLACK_TILE (borderBase + 322)
+
+static int blockStart;
+static SPRITE_INFO blockSpr;
+
+// ranking icon
+#define RANKING_X (22)
+#define RANKING_Y (4)
+static int iconStart;
+static SPRITE_INFO iconSpr;
+
+#define ROW_OFFSET (64)
+#define TILE_SIZE (8)
+#define BOARD_Y (5)
+
+// left edge of each board (in tiles) for each number of boards. up to 3 boards
+// fit on the 40 tile wide screen with their borders, 4 fill it without them
+static const Uint8 boardXs[PLAY_MAX_BOARDS][PLAY_MAX_BOARDS] = {
+    {10},
+    {4, 26},
+    {2, 15, 28},
+    {0, 10, 20, 30},
+};
+#define BORDER_BOARDS (3)
+
+// where the "next" text goes (relative to the board)
+#define PREVIEW_X (3)
+#define PREVIEW_Y (-4)
+
+// the ghost piece (gray outline of where the piece will land) is only shown
+// at low levels
+#define GHOST_LEVEL (100)
+#define GHOST_TILE (8)
+
+#define SCORE_X (22)
+#define SCORE_Y (14)
+
+#define LEVEL_X (SCORE_X)
+#define LEVEL_Y (SCORE_Y + 4)
+
+#define GAME_TRACK (3)
+#define MUSIC_VOLUME (6)
+
+typedef struct {
+    int pad; // controller playing on this board
+    int x; // left edge in tiles
+    volatile Uint16 *vram; // top left of the board in the block tilemap
+    // FRT counts spent on this board during the last frame
+    Uint16 logicTime;
+    Uint16 drawTime;
+} BOARD;
+
+// games[n] is played on boards[n]. games[0] is the only one that gets
+// rewound & recorded
+static GAME_CTX games[PLAY_MAX_BOARDS];
+static BOARD boards[PLAY_MAX_BOARDS];
+static int boardCount;
+
+// frames the end of a versus match stays on screen
+#define VERSUS_END_FRAMES (180)
+static int versusEndTimer;
+
+// most logic ticks to run in one frame when rendering falls behind
+#define MAX_TICKS (4)
+// vblank count that the game logic has caught up to
+static int tickFrame;
+
+// turbo mode (debug only, controlled from the second controller) runs
+// several logic ticks for every vblank
+#define TURBO_MAX (0) // as many ticks as fit before the next vblank
+#define TURBO_MAX_TICKS (64)
+static const int turboSpeeds[] = {1, 2, 4, 8, TURBO_MAX};
+#define TURBO_COUNT ((int)(sizeof(turboSpeeds) / sizeof(turboSpeeds[0])))
+static int turboIndex = 0;
+
+// how often to save a snapshot for rewinding
+#define SNAPSHOT_TICKS (60)
+static int snapshotTicks;
+// frames between each rewind step while the button is held
+#define REWIND_FRAMES (4)
+static int rewindTimer;
+
+// the song that's playing on the CD
+static int playingSong;
+
+// scripted input that can be used in place of the first controller
+typedef struct {
+    Uint16 held;
+    Uint16 ticks;
+} INPUT_RUN;
+
+#define SCRIPT_TAP(buttons) {(buttons), 1}, {0, 1}
+#define SCRIPT_DROP {PAD_U, 1}, {PAD_D, 2}, {0, 45}
+
+static const INPUT_RUN script[] = {
+    {PAD_L, 30}, SCRIPT_DROP,
+    {PAD_R, 30}, SCRIPT_DROP,
+    SCRIPT_TAP(PAD_C), SCRIPT_TAP(PAD_L), SCRIPT_TAP(PAD_L), SCRIPT_DROP,
+    SCRIPT_TAP(PAD_B), SCRIPT_TAP(PAD_R), SCRIPT_TAP(PAD_R), SCRIPT_DROP,
+    SCRIPT_DROP,
+    SCRIPT_TAP(PAD_L), SCRIPT_DROP,
+    SCRIPT_TAP(PAD_R), SCRIPT_TAP(PAD_R), SCRIPT_TAP(PAD_R), SCRIPT_TAP(PAD_C), SCRIPT_DROP,
+};
+#define SCRIPT_LEN ((int)(sizeof(script) / sizeof(script[0])))
+static int useScript = 0;
+static int scriptPos;
+static int scriptTicks;
+
+// attract mode demo, played by the bot
+#define DEMO_FRAMES (60 * 60)
+// boards the bot scores per tick. it picks a placement in about 10 frames
+// this way while staying well inside the frame budget
+#define DEMO_BUDGET (100)
+static int demo;
+static int demoTimer;
+static BOT bot;
+
+// the game's input gets recorded here (LWRAM after the rewind buffer)
+#define REPLAY_BUFFER ((Uint8 *)(LWRAM + 0xD0000))
+// keep the replay small enough to fit in the internal backup RAM
+#define REPLAY_BYTES (0x7000)
+static REPLAY replay;
+
+// every tick's state hash gets logged here (LWRAM after the replay), for
+// checking the host build plays the replay back the same way. it fills up
+// after 32763 ticks, see statehash.h
+#define HASH_BUFFER ((Uint8 *)(LWRAM + 0xD8000))
+#define HASH_BYTES (0x20000)
+static STATEHASH_LOG hashLog;
+
+// gets a seed for the piece RNG from the SMPC clock
+static uint64_t Play_ClockSeed() {
+    Uint8 *time = PER_GET_TIM();
+    return (time[4] << 24) | (time[3] << 16) | (time[2] << 8) | time[1];
+}
+
+void Play_Init(int pads) {
+    // clear out previous scroll data
+    for (int i = 0; i < 0x40000; i++) {
+        ((volatile Uint8 *)SCL_VDP2_VRAM)[i] = 0;
+    }
+
+    // load assets
+    Uint8 *gameBuf = (Uint8 *)LWRAM;
+    CD_ChangeDir("GAME");
+
+    blockStart = Sprite_Load("BLOCKS.SPR", NULL); // sprites for active blocks
+    iconStart = Sprite_Load("ICONS.SPR", NULL);
+
+    // one board for each controller that's playing
+    boardCount = 0;
+    for (int i = 0; (i < PAD_MAX) && (boardCount < PLAY_MAX_BOARDS); i++) {
+        if (pads & (1 << i)) {
+            boards[boardCount].pad = i;
+            boardCount++;
+        }
+    }
+    for (int i = 0; i < boardCount; i++) {
+        boards[i].x = boardXs[boardCount - 1][i];
+        boards[i].vram = (volatile Uint16 *)MAP_PTR(0) + (BOARD_Y * ROW_OFFSET) + boards[i].x;
+    }
+
+    // load piece tiles
+    CD_Load("PLACED.TLE", gameBuf);
+    int blockBytes = Scroll_LoadTile(gameBuf, (volatile void *)SCL_VDP2_VRAM_A1, SCL_NBG0, 0);
+    borderBase = blockBytes / 64;
+
+    // load border tiles
+    CD_Load("BORDER.TLE", gameBuf);
+    Scroll_LoadTile(gameBuf, (volatile void *)(SCL_VDP2_VRAM_A1 + blockBytes), SCL_NBG1, 0);
+    for (int i = 0; (i < boardCount) && (boardCount <= BORDER_BOARDS); i++) {
+        int boardX = boards[i].x;
+        int counter = borderBase;
+        for (int y = 0; y < BORDER_HEIGHT; y++) {
+            for (int x = 0; x < BORDER_WIDTH; x++) {
+                ((volatile Uint16 *)MAP_PTR(1))[(y + BOARD_Y - 1) * ROW_OFFSET + (x + boardX - 2)] = (counter * 2);
+                counter++;
+            }
+        }
+
+        // load next text
+        for (int j = 0; j < 4; j++) {
+            ((volatile Uint16 *)MAP_PTR(1))[(BOARD_Y + PREVIEW_Y + 2) * ROW_OFFSET
+                + boardX + PREVIEW_X - 4 + j] = (NEXT_TILE + j) * 2;
+        }
+    }
+
+    // load playfield background
+    for (int i = 0; i < boardCount; i++) {
+        for (int y = 0; y < GAME_ROWS; y++) {
+            for (int x = 0; x < GAME_COLS; x++) {
+                ((volatile Uint16 *)MAP_PTR(2))[(y + BOARD_Y) * ROW_OFFSET + (x + boards[i].x)] = BLACK_TILE * 2;
+            }
+        }
+    }
+    // set transparent
+    SCL_SetColMixRate(SCL_NBG2, 20);
+
+    // the ranking, score and level only fit next to a single board
+    if (boardCount == 1) {
+        // setup ranking
+        for (int i = 0; i < 5; i++) {
+            ((volatile Uint16 *)MAP_PTR(1))[RANKING_Y * ROW_OFFSET + RANKING_X + i] = (RANKING_TILE + i) * 2;
+        }
+
+        // setup score
+        for (int i = 0; i < 4; i++) {
+            ((volatile Uint16 *)MAP_PTR(1))[SCORE_Y * ROW_OFFSET + SCORE_X + i] = (SCORE_TILE + i) * 2;
+        }
+
+        // setup level
+        for (int i = 0; i < 4; i++) {
+            ((volatile Uint16 *)MAP_PTR(1))[LEVEL_Y * ROW_OFFSET + LEVEL_X + i] = (LEVEL_TILE + i) * 2;
+        }
+    }
+
+    CD_ChangeDir("..");
+
+    // setup background (after the other assets, since they get loaded to the
+    // start of LWRAM and the backgrounds have to stay there for rewinding)
+    BG_Init();
+
+    // set up game state. every board in versus gets the same pieces
+    uint64_t seed = Play_ClockSeed();
+    Replay_Reset(&games[0], seed);
+    Replay_Start(&replay, REPLAY_BUFFER, REPLAY_BYTES, seed, &games[0]);
+    StateHash_Start(&hashLog, HASH_BUFFER, HASH_BYTES, seed);
+    for (int i = 1; i < boardCount; i++) {
+        games[i] = games[0];
+    }
+    versusEndTimer = VERSUS_END_FRAMES;
+    // free running timer for the per board cost readout
+    TIM_FRT_INIT(TIM_CKS_32);
+    // don't count loading time as ticks to catch up on
+    tickFrame = vblank_frames;
+    scriptPos = 0;
+    scriptTicks = 0;
+    Rewind_Init();
+    snapshotTicks = 0;
+    rewindTimer = 0;
+    playingSong = 0;
+    demo = 0;
+
+    Sound_CDVolume(MUSIC_VOLUME, MUSIC_VOLUME);
+    Sound_CDDA(GAME_TRACK, 1);
+}
+
+void Play_InitDemo() {
+    Play_Init(1);
+    Bot_Init(&bot, &botDefaultWeights, DEMO_BUDGET);
+    demo = 1;
+    demoTimer = DEMO_FRAMES;
+}
+
+// draws a piece (if tile isn't 0, all the piece's blocks are drawn with it)
+static void Play_DrawPiece(BOARD *board, PIECE *piece, int tile) {
+    int tileNo;
+
+    for (int y = 0; y < PIECE_SIZE; y++) {
+        for (int x = 0; x < PIECE_SIZE; x++) {
+            tileNo = pieces[piece->num][piece->rotation][y][x];
+            if (tileNo != 0) {
+                if (tile != 0) {
+                    tileNo = tile;
+                }
+                // subtract 1 from the sprite number because the piece arrays have the first
+                // block sprite as 1 and 0 as "nothing"
+                Sprite_Make(blockStart + tileNo - 1, MTH_IntToFixed((board->x + piece->x + x) * TILE_SIZE),
+                        MTH_IntToFixed((BOARD_Y + piece->y + y) * TILE_SIZE), &blockSpr);
+                Sprite_Draw(&blockSpr);
+            }
+        }
+    }
+}
+
+static void Play_DrawRanking(int num) {
+    Sprite_Make(iconStart + num, MTH_FIXED((RANKING_X - 1) * 8), MTH_FIXED((RANKING_Y + 1) * 8), &iconSpr);
+    Sprite_Draw(&iconSpr);
+}
+
+// draws the score and level
+static void Play_DrawNums(GAME_CTX *ctx) {
+    int tmp = ctx->score;
+    volatile Uint16 *scorePtr = (volatile Uint16 *)MAP_PTR(1) + ((SCORE_Y + 1) * ROW_OFFSET) + SCORE_X;
+    for (int i = 0; i < 6; i++) {
+        scorePtr[5 - i] = (DIGITS_TILE + (tmp % 10)) * 2;
+        scorePtr[ROW_OFFSET + (5 - i)] = (DIGITS_TILE + (tmp % 10) + BORDER_WIDTH) * 2;
+        tmp /= 10;
+    }
+
+    tmp = ctx->level;
+    volatile Uint16 *levelPtr = (volatile Uint16 *)MAP_PTR(1) + ((LEVEL_Y + 1) * ROW_OFFSET) + LEVEL_X;
+    for (int i = 0; i < 3; i++) {
+        levelPtr[2 - i] = (DIGITS_TILE + (tmp % 10)) * 2;
+        levelPtr[ROW_OFFSET + (2 - i)] = (DIGITS_TILE + (tmp % 10) + BORDER_WIDTH) * 2;
+        tmp /= 10;
+    }
+}
+
+// plays the sounds and handles the events a game tick asked for
+static void Play_Events(BOARD *board, GAME_CTX *ctx) {
+    for (int i = 0; ctx->sounds; i++) {
+        if (ctx->sounds & (1 << i)) {
+            Sound_Play(i);
+            ctx->sounds &= ~(1 << i);
+        }
+    }
+
+    if (ctx->events & GAME_EVENT_PAUSE) {
+        // clear board on screen so player can't cheat
+        for (int y = 0; y < GAME_ROWS; y++) {
+            for (int x = 0; x < GAME_COLS; x++) {
+                board->vram[(y * ROW_OFFSET) + x] = 0;
+            }
+        }
+    }
+
+    // versus keeps the first bg and song going the whole match
+    if (boardCount > 1) {
+        ctx->events = 0;
+        return;
+    }
+
+    // skips straight to the latest bg if we passed more than one this frame
+    BG_Goto(ctx->bg);
+
+    if (ctx->events & GAME_EVENT_MUSIC_CUT) {
+        Sound_CDVolume(0, 0);
+    }
+
+    if (ctx->events & GAME_EVENT_MUSIC_NEXT) {
+        Sound_CDDA(GAME_TRACK + ctx->song, 1);
+        Sound_CDVolume(MUSIC_VOLUME, MUSIC_VOLUME);
+        playingSong = ctx->song;
+    }
+
+    ctx->events = 0;
+}
+
+// returns the buttons the script holds down this tick
+static Uint16 Play_ScriptInput() {
+    Uint16 held = script[scriptPos].held;
+
+    scriptTicks++;
+    if (scriptTicks >= script[scriptPos].ticks) {
+        scriptTicks = 0;
+        scriptPos++;
+        if (scriptPos == SCRIPT_LEN) {
+            scriptPos = 0;
+        }
+    }
+    return held;
+}
+
+// returns the buttons held on the single player board this tick
+static Uint16 Play_Input() {
+    if (demo) {
+        // the bot's thinking counts as the board's logic time
+        Uint16 start = TIM_FRT_GET_16();
+        Uint16 held = Bot_Input(&bot, &games[0]);
+        boards[0].logicTime += TIM_FRT_GET_16() - start;
+        return held;
+    }
+    return useScript ? Play_ScriptInput() : PadData1;
+}
+
+// X on the second controller changes the turbo speed, Y toggles scripted input
+static void Play_TurboControls() {
+    if (PadData2E & PAD_X) {
+        turboIndex++;
+        if (turboIndex == TURBO_COUNT) {
+            turboIndex = 0;
+        }
+    }
+
+    if (PadData2E & PAD_Y) {
+        useScript = !useScript;
+    }
+}
+
+// goes back one snapshot every REWIND_FRAMES frames
+static void Play_Rewind() {
+    GAME_CTX snapshot;
+
+    if (rewindTimer > 0) {
+        rewindTimer--;
+        return;
+    }
+    rewindTimer = REWIND_FRAMES;
+
+    if (Rewind_Pop(&snapshot)) {
+        Game_Restore(&games[0], &snapshot);
+        // the recorded input doesn't lead to this state anymore
+        replay.full = 1;
+        StateHash_Stop(&hashLog, STATEHASH_STOP_REWOUND);
+        BG_Set(games[0].bg);
+        if (games[0].song != playingSong) {
+            Sound_CDDA(GAME_TRACK + games[0].song, 1);
+            playingSong = games[0].song;
+        }
+        Sound_CDVolume(MUSIC_VOLUME, MUSIC_VOLUME);
+        snapshotTicks = 0;
+    }
+}
+
+// draws a board's current state
+static void Play_Draw(BOARD *board, GAME_CTX *ctx) {
+    Uint16 start = TIM_FRT_GET_16();
+
+    Play_Events(board, ctx);
+
+    // don't draw the piece if we're replacing it with another one
+    if (ctx->state == GAME_STATE_NORMAL) {
+        if (ctx->level < GHOST_LEVEL) {
+            PIECE ghost = ctx->currPiece;
+            ghost.y += Game_DropDistance(ctx, &ghost);
+            Play_DrawPiece(board, &ghost, GHOST_TILE);
+        }
+        Play_DrawPiece(board, &ctx->currPiece, 0);
+    }
+
+    Play_DrawPiece(board, &ctx->nextPiece, 0);
+    if (boardCount == 1) {
+        Play_DrawRanking(ctx->ranking);
+        Play_DrawNums(ctx);
+    }
+
+    // copy the changed rows of the board to VRAM
+    if (ctx->state != GAME_STATE_PAUSED) {
+        for (int y = ctx->dirtyTop; y <= ctx->dirtyBottom; y++) {
+            for (int x = 0; x < GAME_COLS; x++) {
+                board->vram[(y * ROW_OFFSET) + x] = (ctx->boardColors[y][x] * 2);
+            }
+        }
+        ctx->dirtyTop = GAME_ROWS;
+        ctx->dirtyBottom = -1;
+    }
+
+    board->drawTime = TIM_FRT_GET_16() - start;
+}
+
+// shows how long each board's logic and drawing took last frame (in
+// microseconds), the frame budget is 16683
+static void Play_DrawCosts() {
+    int total = 0;
+
+    for (int i = 0; i < boardCount; i++) {
+        int logic = MTH_FixedToInt(TIM_FRT_CNT_TO_MCR(boards[i].logicTime));
+        int draw = MTH_FixedToInt(TIM_FRT_CNT_TO_MCR(boards[i].drawTime));
+        Print_Num(logic, 2 + i, 0);
+        Print_Num(draw, 2 + i, 10);
+        total += logic + draw;
+    }
+    Print_Num(total, 2 + boardCount, 10);
+}
+
+// runs a single player game tick, returns 1 once the game is over
+static int Play_SoloTick(Uint16 held) {
+    Uint16 start = TIM_FRT_GET_16();
+    Replay_Record(&replay, &games[0], held);
+    int done = Game_Step(&games[0], held);
+
+    // the devcart keeps getting hashes after the log fills up
+    if (hashLog.stop != STATEHASH_STOP_REWOUND) {
+        Uint32 hash = StateHash_Get(&games[0]);
+        if (HASH_PRINT) {
+            char line[STATEHASH_LINE_LEN];
+            StateHash_Format(line, hashLog.ticks, hash);
+            Devcart_PrintStr(line);
+        }
+        StateHash_Record(&hashLog, hash);
+    }
+
+    if (REWIND && (games[0].state != GAME_STATE_PAUSED)) {
+        snapshotTicks++;
+        if (snapshotTicks >= SNAPSHOT_TICKS) {
+            Rewind_Push(&games[0]);
+            snapshotTicks = 0;
+        }
+    }
+
+    boards[0].logicTime += TIM_FRT_GET_16() - start;
+    return done;
+}
+
+// runs a versus tick for every board that's still in, and hands the garbage
+// each one sent to the next board that's still in. returns 1 once at most one
+// board is left
+static int Play_VersusTick() {
+    int left = 0;
+
+    for (int i = 0; i < boardCount; i++) {
+        GAME_CTX *ctx = &games[i];
+        if (ctx->state == GAME_STATE_GAMEOVER_DONE) {
+            continue;
+        }
+
+        Uint16 start = TIM_FRT_GET_16();
+        // one player pausing would leave everyone else playing, so there's
+        // no pausing in versus
+        Game_Step(ctx, PadData[boards[i].pad] & ~PAD_S);
+        boards[i].logicTime += TIM_FRT_GET_16() - start;
+
+        if (ctx->garbageOut) {
+            for (int j = 1; j < boardCount; j++) {
+                GAME_CTX *target = &games[(i + j) % boardCount];
+                if (target->state < GAME_STATE_GAMEOVER) {
+                    Game_AddGarbage(target, ctx->garbageOut);
+                    break;
+                }
+            }
+            ctx->garbageOut = 0;
+        }
+    }
+
+    // wait for the losers' game over animations to finish
+    for (int i = 0; i < boardCount; i++) {
+        if (games[i].state < GAME_STATE_GAMEOVER) {
+            left++;
+        }
+        else if (games[i].state != GAME_STATE_GAMEOVER_DONE) {
+            return 0;
+        }
+    }
+    return (left <= 1);
+}
+
+int Play_Run() {
+    int done = 0;
+
+    // run one logic tick for every vblank since the last frame, so the game
+    // stays on time when a frame takes too long to draw
+    int now = vblank_frames;
+    int ticks = now - tickFrame;
+    if (ticks > MAX_TICKS) {
+        ticks = MAX_TICKS;
+    }
+    tickFrame = now;
+
+    for (int i = 0; i < boardCount; i++) {
+        boards[i].logicTime = 0;
+    }
+
+    // the second controller is a player in versus
+    int speed = 1;
+    if (DEBUG && (boardCount == 1)) {
+        Play_TurboControls();
+        speed = turboSpeeds[turboIndex];
+    }
+    if (speed == TURBO_MAX) {
+        ticks = TURBO_MAX_TICKS;
+    }
+    else {
+        ticks *= speed;
+    }
+
+    // the game doesn't run while it's being rewound, whatever the turbo speed
+    if (REWIND && !demo && (boardCount == 1) && (PadData1 & PAD_LB) && (games[0].state != GAME_STATE_PAUSED)) {
+        Play_Rewind();
+        ticks = 0;
+    }
+    else {
+        rewindTimer = 0;
+    }
+    // the boards stop once a versus match is decided
+    if ((boardCount > 1) && (versusEndTimer < VERSUS_END_FRAMES)) {
+        ticks = 0;
+    }
+
+    while ((ticks > 0) && !done) {
+        if (boardCount == 1) {
+            done = Play_SoloTick(Play_Input());
+        }
+        else {
+            done = Play_VersusTick();
+        }
+        ticks--;
+
+        // stop once the frame's time is up
+        if ((speed == TURBO_MAX) && (vblank_frames != now)) {
+            break;
+        }
+    }
+    // sounds, events and dirty rows from all the ticks get handled at once,
+    // so only the last state gets drawn
+    for (int i = 0; i < boardCount; i++) {
+        Play_Draw(&boards[i], &games[i]);
+    }
+    BG_Run();
+
+    if (DEBUG) {
+        Print_Num(games[0].gravityTimer, 0, 0);
+        Print_Num(turboSpeeds[turboIndex], 1, 0);
+        Play_DrawCosts();
+    }
+
+    if (boardCount > 1) {
+        // leave the result up for a bit before going back to the title
+        if (done || (versusEndTimer < VERSUS_END_FRAMES)) {
+            versusEndTimer--;
+        }
+        return (versusEndTimer == 0) ? PLAY_DONE_TITLE : PLAY_RUNNING;
+    }
+
+    if (demo) {
+        demoTimer--;
+        for (int i = 0; i < PAD_MAX; i++) {
+            if (PadDataE[i]) {
+                done = 1;
+            }
+        }
+        return (done || (demoTimer == 0)) ? PLAY_DONE_TITLE : PLAY_RUNNING;
+    }
+
+    if (done) {
+        if (Replay_Finish(&replay, &games[0])) {
+            Replay_Save(&replay);
+        }
+        Rank_Setup(games[0].finalRank);
+        return PLAY_DONE_RANK;
+    }
+
+    return PLAY_RUNNING;
+}
@@ -0,0 +1,26 @@
+#ifndef PLAY_H
+#define PLAY_H
+
+// most boards that fit on screen at once (one per controller)
+#define PLAY_MAX_BOARDS (4)
+
+typedef enum {
+    PLAY_RUNNING = 0,
+    PLAY_DONE_RANK, // single player game over, show the rank screen
+    PLAY_DONE_TITLE, // versus match over, go back to the title
+} PLAY_RESULTS;
+
+// reloads all assets & starts a new game with a board for each controller in
+// the pads mask (one board is single player, more is versus)
+void Play_Init(int pads);
+
+// starts a single player game played by the bot for the title screen's
+// attract mode. it goes back to the title (PLAY_DONE_TITLE) after a minute,
+// on game over, or when any button is pressed
+void Play_InitDemo();
+
+// runs the gameplay ticks for the vblanks since the last call and draws the
+// result, returns a PLAY_RESULTS value
+int Play_Run();
+
+#endif
@@ -8,4 +8,11 @@
 // Debug features
 #define DEBUG (1)
 
+// If holding the left shoulder button should rewind the game
+#define REWIND (DEBUG)
+
+// If each tick's state hash should also be sent over the devcart print channel
+// (they always get logged to memory, see statehash.h)
+#define HASH_PRINT (0)
+
 #endif
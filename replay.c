@@ -0,0 +1,268 @@
+#include <string.h>
+#include <sega_bup.h>
+
+#include "delta.h"
+#include "replay.h"
+#include "rng.h"
+
+// most bytes a record other than a keyframe can take
+#define RECORD_MAX (10)
+#define KEYFRAME_DELTA_MAX (DELTA_MAX(sizeof(GAME_CTX)))
+#define KEYFRAME_MAX (RECORD_MAX + KEYFRAME_DELTA_MAX)
+// a result record's header and its three varints
+#define RESULT_MAX (5 * 4)
+
+#define REPLAY_FILENAME "GMREPLAY"
+#define REPLAY_COMMENT "REPLAY"
+// internal backup RAM
+#define BUP_DEVICE (0)
+
+static Uint32 bupWork[2048];
+static BupConfig bupConfig[3];
+static int bupReady = 0;
+
+void Replay_Reset(GAME_CTX *ctx, uint64_t seed) {
+    RNG_STATE rng;
+
+    RNG_Seed(&rng, seed, 0);
+    // clear the padding too so keyframe deltas don't pick it up
+    memset(ctx, 0, sizeof(GAME_CTX));
+    Game_Reset(ctx, &rng);
+}
+
+void Replay_Start(REPLAY *rp, Uint8 *buf, int size, uint64_t seed, GAME_CTX *ctx) {
+    rp->buf = buf;
+    rp->size = size;
+    rp->pos = REPLAY_HEADER_SIZE;
+    rp->seed = seed;
+    rp->ticks = 0;
+    rp->totalTicks = 0;
+    rp->full = 0;
+    rp->held = 0;
+    rp->run = 0;
+    rp->change = 0;
+    Game_Snapshot(ctx, &rp->keyframe);
+}
+
+// writes a record header for the ticks since the last record
+static void Replay_PutRecord(REPLAY *rp, int kind) {
+    rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, (rp->run << REPLAY_KIND_BITS) | kind);
+    rp->run = 0;
+}
+
+void Replay_Record(REPLAY *rp, GAME_CTX *ctx, Uint16 held) {
+    if (rp->full) {
+        return;
+    }
+
+    if ((rp->ticks > 0) && ((rp->ticks % REPLAY_KEYFRAME_TICKS) == 0)) {
+        Uint8 delta[KEYFRAME_DELTA_MAX];
+
+        if ((rp->pos + KEYFRAME_MAX) > rp->size) {
+            rp->full = 1;
+            return;
+        }
+        int len = Delta_Encode((Uint8 *)&rp->keyframe, (Uint8 *)ctx, sizeof(GAME_CTX), delta);
+        Replay_PutRecord(rp, REPLAY_KIND_KEYFRAME);
+        rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, len);
+        memcpy(rp->buf + rp->pos, delta, len);
+        rp->pos += len;
+        Game_Snapshot(ctx, &rp->keyframe);
+    }
+
+    if (held != rp->held) {
+        Uint16 changed = held ^ rp->held;
+
+        if ((rp->pos + RECORD_MAX) > rp->size) {
+            rp->full = 1;
+            return;
+        }
+        // single button changes (almost all of them) fit in the record header
+        if ((changed & (changed - 1)) == 0) {
+            int bit = 0;
+            while (!(changed & (1 << bit))) {
+                bit++;
+            }
+            Replay_PutRecord(rp, bit);
+        }
+        else {
+            Replay_PutRecord(rp, REPLAY_KIND_MASKED);
+            rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, changed);
+        }
+        rp->held = held;
+    }
+
+    rp->run++;
+    rp->ticks++;
+}
+
+int Replay_Finish(REPLAY *rp, GAME_CTX *ctx) {
+    if (rp->full || ((rp->pos + RECORD_MAX + RESULT_MAX) > rp->size)) {
+        rp->full = 1;
+        return 0;
+    }
+
+    // cover the ticks since the last change
+    if (rp->run > 0) {
+        Replay_PutRecord(rp, REPLAY_KIND_MASKED);
+        rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, 0);
+    }
+    Replay_PutRecord(rp, REPLAY_KIND_RESULT);
+    rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, ctx->score);
+    rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, ctx->level);
+    rp->pos += ReplayFmt_PutVarint(rp->buf + rp->pos, ctx->finalRank);
+
+    memcpy(rp->buf, REPLAY_MAGIC, 4);
+    ReplayFmt_Put32(rp->buf + 4, (Uint32)(rp->seed >> 32));
+    ReplayFmt_Put32(rp->buf + 8, (Uint32)rp->seed);
+    ReplayFmt_Put32(rp->buf + 12, rp->ticks);
+    ReplayFmt_Put32(rp->buf + 16, rp->pos - REPLAY_HEADER_SIZE);
+    rp->totalTicks = rp->ticks;
+    return rp->pos;
+}
+
+// goes back to the start of the replay
+static void Replay_Rewind(REPLAY *rp, GAME_CTX *ctx) {
+    rp->pos = REPLAY_HEADER_SIZE;
+    rp->ticks = 0;
+    rp->held = 0;
+    rp->run = 0;
+    rp->change = 0;
+    Replay_Reset(ctx, rp->seed);
+    Game_Snapshot(ctx, &rp->keyframe);
+}
+
+int Replay_Open(REPLAY *rp, Uint8 *buf, int size, GAME_CTX *ctx) {
+    if ((size < REPLAY_HEADER_SIZE) || memcmp(buf, REPLAY_MAGIC, 4)) {
+        return 0;
+    }
+
+    int len = ReplayFmt_Get32(buf + 16);
+    if (len > (size - REPLAY_HEADER_SIZE)) {
+        return 0;
+    }
+
+    rp->buf = buf;
+    rp->size = REPLAY_HEADER_SIZE + len;
+    rp->seed = ((uint64_t)ReplayFmt_Get32(buf + 4) << 32) | ReplayFmt_Get32(buf + 8);
+    rp->totalTicks = ReplayFmt_Get32(buf + 12);
+    rp->full = 0;
+    Replay_Rewind(rp, ctx);
+    return 1;
+}
+
+// reads the next record into run & change, applying keyframe deltas to
+// rp->keyframe if apply is set. returns the record kind, or -1 at the end
+static int Replay_ReadRecord(REPLAY *rp, int apply) {
+    uint32_t header;
+    uint32_t val;
+
+    if (!ReplayFmt_GetVarint(rp->buf, rp->size, &rp->pos, &header)) {
+        return -1;
+    }
+    int kind = header & REPLAY_KIND_MASK;
+    rp->run = header >> REPLAY_KIND_BITS;
+    rp->change = 0;
+
+    if (kind < REPLAY_KIND_MASKED) {
+        rp->change = 1 << kind;
+    }
+    else if (kind == REPLAY_KIND_MASKED) {
+        if (!ReplayFmt_GetVarint(rp->buf, rp->size, &rp->pos, &val)) {
+            return -1;
+        }
+        rp->change = val;
+    }
+    else if (kind == REPLAY_KIND_KEYFRAME) {
+        if (!ReplayFmt_GetVarint(rp->buf, rp->size, &rp->pos, &val) ||
+            ((rp->pos + (int)val) > rp->size)) {
+            return -1;
+        }
+        if (apply) {
+            Delta_Apply(rp->buf + rp->pos, val, (Uint8 *)&rp->keyframe);
+        }
+        rp->pos += val;
+    }
+    else if (kind == REPLAY_KIND_RESULT) {
+        // only the host tools read the result
+        for (int i = 0; i < 3; i++) {
+            if (!ReplayFmt_GetVarint(rp->buf, rp->size, &rp->pos, &val)) {
+                return -1;
+            }
+        }
+    }
+    else {
+        return -1;
+    }
+
+    return kind;
+}
+
+int Replay_Next(REPLAY *rp, Uint16 *held) {
+    while (rp->run == 0) {
+        rp->held ^= rp->change;
+        rp->change = 0;
+        if (Replay_ReadRecord(rp, 0) < 0) {
+            return 0;
+        }
+    }
+
+    rp->run--;
+    rp->ticks++;
+    *held = rp->held;
+    return 1;
+}
+
+Uint32 Replay_Seek(REPLAY *rp, Uint32 tick, GAME_CTX *ctx) {
+    Replay_Rewind(rp, ctx);
+
+    // keyframes don't store the inputs, so step through the records (without
+    // simulating) & stop at the last keyframe that isn't past tick
+    int markPos = rp->pos;
+    Uint32 markTicks = 0;
+    Uint16 markHeld = 0;
+    Uint32 ticks = 0;
+    int kind;
+
+    while ((kind = Replay_ReadRecord(rp, 1)) >= 0) {
+        if ((ticks + rp->run) > tick) {
+            break;
+        }
+        ticks += rp->run;
+        if (kind == REPLAY_KIND_KEYFRAME) {
+            markPos = rp->pos;
+            markTicks = ticks;
+            markHeld = rp->held;
+            Game_Restore(ctx, &rp->keyframe);
+        }
+        rp->held ^= rp->change;
+    }
+
+    rp->pos = markPos;
+    rp->ticks = markTicks;
+    rp->held = markHeld;
+    rp->run = 0;
+    rp->change = 0;
+    Game_Snapshot(ctx, &rp->keyframe);
+    return markTicks;
+}
+
+int Replay_Save(REPLAY *rp) {
+    BupDir dir;
+
+    if (rp->full) {
+        return -1;
+    }
+
+    if (!bupReady) {
+        BUP_Init((Uint32 *)BUP_LIB_ADDRESS, bupWork, bupConfig);
+        bupReady = 1;
+    }
+
+    memset(&dir, 0, sizeof(dir));
+    strcpy((char *)dir.filename, REPLAY_FILENAME);
+    strcpy((char *)dir.comment, REPLAY_COMMENT);
+    dir.language = BUP_ENGLISH;
+    dir.datasize = rp->pos;
+    return BUP_Write(BUP_DEVICE, &dir, rp->buf, OFF);
+}
@@ -0,0 +1,56 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <sega_mth.h>
+
+#include "game.h"
+#include "replayfmt.h"
+
+typedef struct {
+    Uint8 *buf;
+    int size; // size of buf
+    int pos; // bytes of the record stream written/read so far
+    uint64_t seed;
+    Uint32 ticks; // ticks recorded/played so far
+    Uint32 totalTicks; // ticks in the replay (when playing)
+    int full; // set if the recording ran out of space or can't be trusted
+
+    Uint16 held;
+    Uint32 run; // ticks held has stayed the same (recording) or will stay the same (playback)
+    Uint16 change; // buttons that change once run is up (playback)
+
+    // state at the last keyframe (the next keyframe is stored relative to this)
+    GAME_CTX keyframe;
+} REPLAY;
+
+// starts recording a game that was started with Replay_Reset's seed to buf.
+// ctx should be the game's state right after it was reset
+void Replay_Start(REPLAY *rp, Uint8 *buf, int size, uint64_t seed, GAME_CTX *ctx);
+
+// records the buttons held for the next tick, call before Game_Step
+void Replay_Record(REPLAY *rp, GAME_CTX *ctx, Uint16 held);
+
+// writes the game's result (from ctx, once it's over) and the header,
+// returns the total size of the replay in bytes
+int Replay_Finish(REPLAY *rp, GAME_CTX *ctx);
+
+// starts a game with the given seed the same way replays do
+void Replay_Reset(GAME_CTX *ctx, uint64_t seed);
+
+// opens a finished replay for playback and sets ctx up for its first tick.
+// returns 0 if buf doesn't hold a replay
+int Replay_Open(REPLAY *rp, Uint8 *buf, int size, GAME_CTX *ctx);
+
+// gets the buttons held for the next tick, returns 0 when the replay is over
+int Replay_Next(REPLAY *rp, Uint16 *held);
+
+// restores ctx to the last keyframe at or before tick and moves playback
+// there. returns the tick it ended up on (keep calling Replay_Next &
+// Game_Step to get the rest of the way)
+Uint32 Replay_Seek(REPLAY *rp, Uint32 tick, GAME_CTX *ctx);
+
+// saves a finished replay to backup RAM, returns 0 on success
+int Replay_Save(REPLAY *rp);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef REPLAYFMT_H
+#define REPLAYFMT_H
+
+// replay file layout, shared with the host tools (so no SBL types here)
+//
+// header (big endian):
+//   0  magic "GMR1"
+//   4  RNG seed (64 bit)
+//   12 number of ticks
+//   16 length of the record stream
+// then a stream of records. each starts with a varint v: the held buttons stay
+// the same for (v >> REPLAY_KIND_BITS) ticks, then (v & REPLAY_KIND_MASK) says
+// what happens:
+//   0-15: the button at that bit gets pressed/released
+//   REPLAY_KIND_MASKED: varint follows with all the buttons that changed
+//   REPLAY_KIND_KEYFRAME: varint length & a delta (see delta.h) from the last
+//   keyframe (or the game's starting state) to the GAME_CTX before the next
+//   tick. GAME_CTX is stored as it is in memory, so it's only readable on
+//   the same platform (and build) that recorded it
+//   REPLAY_KIND_RESULT: varints with the score, level and rank the game ended
+//   with, for checking the replay against. it's the last record, and replays
+//   of games that didn't finish don't have it
+
+#include <stdint.h>
+
+#define REPLAY_MAGIC "GMR1"
+#define REPLAY_HEADER_SIZE (20)
+
+#define REPLAY_KIND_BITS (5)
+#define REPLAY_KIND_MASK ((1 << REPLAY_KIND_BITS) - 1)
+#define REPLAY_KIND_MASKED (16)
+#define REPLAY_KIND_KEYFRAME (17)
+#define REPLAY_KIND_RESULT (18)
+
+// ticks between keyframes
+#define REPLAY_KEYFRAME_TICKS (3600)
+
+// writes a varint, returns the number of bytes written (at most 5)
+static inline int ReplayFmt_PutVarint(uint8_t *buf, uint32_t val) {
+    int len = 0;
+
+    while (val >= 0x80) {
+        buf[len++] = (val & 0x7F) | 0x80;
+        val >>= 7;
+    }
+    buf[len++] = val;
+    return len;
+}
+
+// reads a varint from buf at *pos, returns 0 if it runs past len
+static inline int ReplayFmt_GetVarint(const uint8_t *buf, int len, int *pos, uint32_t *val) {
+    uint32_t result = 0;
+    int shift = 0;
+
+    while (*pos < len) {
+        uint8_t byte = buf[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *val = result;
+            return 1;
+        }
+        shift += 7;
+        if (shift > 28) {
+            break;
+        }
+    }
+    return 0;
+}
+
+static inline uint32_t ReplayFmt_Get32(const uint8_t *buf) {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+static inline void ReplayFmt_Put32(uint8_t *buf, uint32_t val) {
+    buf[0] = val >> 24;
+    buf[1] = val >> 16;
+    buf[2] = val >> 8;
+    buf[3] = val;
+}
+
+#endif
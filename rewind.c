@@ -0,0 +1,88 @@
+#include <sega_xpt.h>
+
+#include "cd.h"
+#include "delta.h"
+#include "rewind.h"
+
+// the newest snapshot is kept as is. each older one is stored as a delta
+// (see delta.h) between it and the snapshot after it. XORing a delta into
+// the newest snapshot gives the one before it, so going back one step never
+// has to decode more than one delta
+
+// LWRAM after the backgrounds
+#define REWIND_BUFFER ((Uint8 *)(LWRAM + 0xC0000))
+#define REWIND_BYTES (0x10000)
+// number of deltas kept
+#define REWIND_SLOTS (60)
+
+#define REWIND_DELTA_MAX (DELTA_MAX(sizeof(GAME_CTX)))
+
+static GAME_CTX head;
+static int haveHead;
+
+static int deltaStart[REWIND_SLOTS];
+static int deltaLen[REWIND_SLOTS];
+static int oldest;
+static int count;
+
+void Rewind_Init() {
+    haveHead = 0;
+    oldest = 0;
+    count = 0;
+}
+
+void Rewind_Push(GAME_CTX *ctx) {
+    if (haveHead) {
+        int slot = (oldest + count) % REWIND_SLOTS;
+        int start = 0;
+
+        if (count == REWIND_SLOTS) {
+            oldest = (oldest + 1) % REWIND_SLOTS;
+            count--;
+        }
+
+        // put the delta after the newest one, wrapping around if there's no room
+        if (count > 0) {
+            int newest = (oldest + count - 1) % REWIND_SLOTS;
+            start = deltaStart[newest] + deltaLen[newest];
+            if ((start + REWIND_DELTA_MAX) > REWIND_BYTES) {
+                start = 0;
+            }
+        }
+
+        // drop the old deltas that would get written over
+        while (count > 0) {
+            int oldStart = deltaStart[oldest];
+            int oldEnd = oldStart + deltaLen[oldest];
+            if ((oldEnd <= start) || (oldStart >= (int)(start + REWIND_DELTA_MAX))) {
+                break;
+            }
+            oldest = (oldest + 1) % REWIND_SLOTS;
+            count--;
+        }
+
+        deltaStart[slot] = start;
+        deltaLen[slot] = Delta_Encode((Uint8 *)&head, (Uint8 *)ctx, sizeof(GAME_CTX), REWIND_BUFFER + start);
+        count++;
+    }
+
+    Game_Snapshot(ctx, &head);
+    haveHead = 1;
+}
+
+int Rewind_Pop(GAME_CTX *snapshot) {
+    if (!haveHead) {
+        return 0;
+    }
+
+    *snapshot = head;
+    if (count > 0) {
+        int newest = (oldest + count - 1) % REWIND_SLOTS;
+        Delta_Apply(REWIND_BUFFER + deltaStart[newest], deltaLen[newest], (Uint8 *)&head);
+        count--;
+    }
+    else {
+        haveHead = 0;
+    }
+    return 1;
+}
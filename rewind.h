@@ -0,0 +1,16 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "game.h"
+
+// empties the rewind buffer
+void Rewind_Init();
+
+// adds a snapshot of the game to the rewind buffer (the oldest ones get
+// dropped when it fills up)
+void Rewind_Push(GAME_CTX *ctx);
+
+// takes the newest snapshot out of the buffer, returns 0 if it's empty
+int Rewind_Pop(GAME_CTX *snapshot);
+
+#endif
@@ -1,57 +1,92 @@
 #include <sega_mth.h>
-#include <sega_per.h>
 
 #include "piece.h"
-#define HISTORY_LEN (4)
-static Uint8 history[HISTORY_LEN];
-static int first;
-
-static void HistoryPush(int num) {
-    history[3] = history[2];
-    history[2] = history[1];
-    history[1] = history[0];
-    history[0] = num;
+#include "rng.h"
+
+// PCG32 (pcg-random.org): 64 bit LCG state with a permuted 32 bit output
+#define RNG_MULT (6364136223846793005ULL)
+
+// pieces that can't be given first
+#define FIRST_BANNED ((1 << PIECE_S) | (1 << PIECE_Z) | (1 << PIECE_O))
+// number of times to reroll a piece that's in the history
+#define REROLLS (6)
+
+// scales the top 16 bits of a random number to a piece number (avoids a divide)
+#define RNG_PIECE(r) ((((r) >> 16) * PIECE_COUNT) >> 16)
+
+Uint32 RNG_Next(RNG_STATE *rng) {
+    uint64_t old = rng->state;
+    rng->state = (old * RNG_MULT) + rng->inc;
+    Uint32 xorshifted = (Uint32)(((old >> 18) ^ old) >> 27);
+    Uint32 rot = (Uint32)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
 }
 
-static int HistoryContains(int num) {
-    for (int i = 0; i < HISTORY_LEN; i++) {
-        if (history[i] == num) {
-            return 1;
+void RNG_Advance(RNG_STATE *rng, uint64_t delta) {
+    uint64_t curMult = RNG_MULT;
+    uint64_t curPlus = rng->inc;
+    uint64_t accMult = 1;
+    uint64_t accPlus = 0;
+
+    // combine the LCG steps by squaring, so this takes log2(delta) iterations
+    while (delta > 0) {
+        if (delta & 1) {
+            accMult *= curMult;
+            accPlus = (accPlus * curMult) + curPlus;
         }
+        curPlus = (curMult + 1) * curPlus;
+        curMult *= curMult;
+        delta >>= 1;
     }
+    rng->state = (accMult * rng->state) + accPlus;
+}
 
-    return 0;
+static inline void RNG_HistoryPush(RNG_STATE *rng, int num) {
+    rng->history[3] = rng->history[2];
+    rng->history[2] = rng->history[1];
+    rng->history[1] = rng->history[0];
+    rng->history[0] = num;
+    rng->historyMask = (1 << rng->history[0]) | (1 << rng->history[1]) |
+        (1 << rng->history[2]) | (1 << rng->history[3]);
 }
 
-void RNG_Init() {
-    Uint8 *time = PER_GET_TIM();
-    Uint32 timestamp = (time[4] << 24) | (time[3] << 16) | (time[2] << 8) | time[1];
-    MTH_InitialRand(timestamp);
-    
+void RNG_Seed(RNG_STATE *rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1;
+    RNG_Next(rng);
+    rng->state += seed;
+    RNG_Next(rng);
+
     // initialize the history
-    HistoryPush(PIECE_Z);
-    HistoryPush(PIECE_Z);
-    HistoryPush(PIECE_S);
-    HistoryPush(PIECE_S);
+    RNG_HistoryPush(rng, PIECE_Z);
+    RNG_HistoryPush(rng, PIECE_Z);
+    RNG_HistoryPush(rng, PIECE_S);
+    RNG_HistoryPush(rng, PIECE_S);
 
     // we're going to give the first piece
-    first = 1;
+    rng->first = 1;
+}
+
+void RNG_Split(RNG_STATE *parent, RNG_STATE *child) {
+    uint64_t seed = ((uint64_t)RNG_Next(parent) << 32) | RNG_Next(parent);
+    uint64_t stream = ((uint64_t)RNG_Next(parent) << 32) | RNG_Next(parent);
+    RNG_Seed(child, seed, stream);
 }
 
-int RNG_Get() {
-    int tries = 6;
+static inline int RNG_Pick(RNG_STATE *rng) {
+    int tries = REROLLS;
     int candidate;
 
     while (tries > 0) {
-        candidate = (MTH_GetRand() >> 8) % PIECE_COUNT;
-        
+        candidate = RNG_PIECE(RNG_Next(rng));
+
         // don't allow S, Z, or O to be the first piece (retry until we get a different piece)
-        if (first && ((candidate == PIECE_S) || (candidate == PIECE_Z) || (candidate == PIECE_O))) {
+        if (rng->first && ((1 << candidate) & FIRST_BANNED)) {
             continue;
         }
-        
+
         // if the block was in the history, retry a finite number of times
-        else if (HistoryContains(candidate)) {
+        else if (rng->historyMask & (1 << candidate)) {
             tries--;
             continue;
         }
@@ -61,8 +96,22 @@ int RNG_Get() {
             break;
         }
     }
-    
-    first = 0;
-    HistoryPush(candidate);
+
+    rng->first = 0;
+    RNG_HistoryPush(rng, candidate);
     return candidate;
 }
+
+int RNG_Get(RNG_STATE *rng) {
+    return RNG_Pick(rng);
+}
+
+void RNG_Fill(RNG_STATE *rng, Uint8 *buf, int n) {
+    // work on a local copy so the state can stay in registers
+    RNG_STATE local = *rng;
+
+    for (int i = 0; i < n; i++) {
+        buf[i] = RNG_Pick(&local);
+    }
+    *rng = local;
+}
@@ -1,11 +1,38 @@
 #ifndef RNG_H
 #define RNG_H
 
-// should be run before each new game
-void RNG_Init();
+#include <stdint.h>
+#include <sega_mth.h>
+
+#define RNG_HISTORY_LEN (4)
+
+// state for one piece sequence. it doesn't hold any pointers, so it can be
+// copied with memcpy
+typedef struct {
+    uint64_t state;
+    uint64_t inc; // selects the stream, always odd
+    Uint8 history[RNG_HISTORY_LEN];
+    Uint8 historyMask; // bit n is set if piece n is in the history
+    Uint8 first; // set until the first piece has been given out
+} RNG_STATE;
+
+// seeds the generator & resets the piece history. generators with the same
+// seed but different streams give unrelated sequences
+void RNG_Seed(RNG_STATE *rng, uint64_t seed, uint64_t stream);
+
+// returns a raw 32 bit random number
+Uint32 RNG_Next(RNG_STATE *rng);
+
+// skips ahead delta raw numbers without generating them
+void RNG_Advance(RNG_STATE *rng, uint64_t delta);
+
+// seeds child with a new stream taken from parent
+void RNG_Split(RNG_STATE *parent, RNG_STATE *child);
 
 // gets a piece
-int RNG_Get();
+int RNG_Get(RNG_STATE *rng);
 
-#endif
+// writes the next n pieces to buf, same as calling RNG_Get n times
+void RNG_Fill(RNG_STATE *rng, Uint8 *buf, int n);
 
+#endif
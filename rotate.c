@@ -0,0 +1,40 @@
+#include "rotate.h"
+
+#define NEXT_CW(rot) (((rot) + PIECE_ROTATIONS - 1) % PIECE_ROTATIONS)
+#define NEXT_CCW(rot) (((rot) + 1) % PIECE_ROTATIONS)
+
+// arika rotation system: rotate in place, then a ceiling kick, then one
+// square right, then one square left
+#define ARS_KICKS(to, center) {(to), 4, { \
+    {0, 0, 0}, \
+    {0, 1, KICK_CEILING}, \
+    {1, 0, (center)}, \
+    {-1, 0, (center)}, \
+}}
+
+#define ARS_ROTATION(rot, center) { \
+    [ROTATE_CLOCKWISE] = ARS_KICKS(NEXT_CW(rot), center), \
+    [ROTATE_COUNTERCLOCKWISE] = ARS_KICKS(NEXT_CCW(rot), center), \
+}
+
+#define ARS_PIECE(center) { \
+    ARS_ROTATION(0, center), \
+    ARS_ROTATION(1, center), \
+    ARS_ROTATION(2, center), \
+    ARS_ROTATION(3, center), \
+}
+
+const ROTATION_SYSTEM rotationSystems[ROTATION_SYSTEM_COUNT] = {
+    [ROTATION_ARS] = {
+        .centerMask = (1 << 1),
+        .lists = {
+            [PIECE_I] = ARS_PIECE(0),
+            [PIECE_Z] = ARS_PIECE(0),
+            [PIECE_S] = ARS_PIECE(0),
+            [PIECE_J] = ARS_PIECE(KICK_CENTER),
+            [PIECE_L] = ARS_PIECE(KICK_CENTER),
+            [PIECE_O] = ARS_PIECE(0),
+            [PIECE_T] = ARS_PIECE(KICK_CENTER),
+        },
+    },
+};
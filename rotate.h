@@ -0,0 +1,48 @@
+#ifndef ROTATE_H
+#define ROTATE_H
+
+#include <sega_mth.h>
+
+#include "piece.h"
+
+// rotation directions (index into the kick tables)
+#define ROTATE_CLOCKWISE (0)
+#define ROTATE_COUNTERCLOCKWISE (1)
+#define ROTATE_DIRS (2)
+
+#define ROTATE_MAX_KICKS (4)
+
+// only tried while the piece is on the spawn row and in the air. if the piece
+// gets this far, the offset stays applied for the rest of the kicks
+#define KICK_CEILING (1 << 0)
+// not tried if the first block blocking the rotation is in the center column
+#define KICK_CENTER (1 << 1)
+
+typedef enum {
+    ROTATION_ARS = 0,
+} ROTATION_SYSTEMS;
+
+#define ROTATION_SYSTEM_COUNT (1)
+
+typedef struct {
+    Sint8 x;
+    Sint8 y;
+    Uint8 flags; // KICK flags
+} KICK;
+
+// offsets to try (in order) when rotating a piece one way
+typedef struct {
+    Uint8 to; // rotation the piece ends up in
+    Uint8 count;
+    KICK kicks[ROTATE_MAX_KICKS];
+} KICK_LIST;
+
+typedef struct {
+    // bit x set if piece column x counts as the center for KICK_CENTER
+    Uint8 centerMask;
+    KICK_LIST lists[PIECE_COUNT][PIECE_ROTATIONS][ROTATE_DIRS];
+} ROTATION_SYSTEM;
+
+extern const ROTATION_SYSTEM rotationSystems[ROTATION_SYSTEM_COUNT];
+
+#endif
@@ -168,13 +168,8 @@ int Scroll_LoadTile(void *src, volatile void *dest, Uint32 object, Uint16 palno)
     int imageSize;
     char *tileData = Scroll_TilePtr(src, &imageSize);
 
-	Uint32 palLen;
-	memcpy(&palLen, src, sizeof(palLen));
-	src += 4;
-
-    Uint32 palSize;
-    memcpy(&palSize, src, sizeof(palSize));
-    src += 4;
+	Uint32 palLen = CD_Get32(src);
+	src += 8; // skip palette length & entry size
 
 	SCL_SetColRam(object, palno, palLen, src);
 	if (dest) {
@@ -187,16 +182,14 @@ int Scroll_LoadTile(void *src, volatile void *dest, Uint32 object, Uint16 palno)
 }
 
 char *Scroll_TilePtr(void *buff, int *size) {
-	Uint32 palLen;
-	memcpy(&palLen, buff, sizeof(palLen));
+	Uint32 palLen = CD_Get32(buff);
 	buff += 4;
 
-    Uint32 palSize;
-    memcpy(&palSize, buff, sizeof(palSize));
+    Uint32 palSize = CD_Get32(buff);
     buff += (palLen * palSize * 2) + 4;
 
 	if (size) {
-		memcpy(size, buff, 4);
+		*size = CD_Get32(buff);
 	}
 	buff += 4;
 	return (char *)buff;
@@ -204,11 +197,11 @@ char *Scroll_TilePtr(void *buff, int *size) {
 
 char *Scroll_MapPtr(void *buff, int *xsize, int *ysize) {
 	if (xsize) {
-		memcpy(xsize, buff, sizeof(int));
+		*xsize = CD_Get32(buff);
 	}
 	buff += sizeof(int);
 	if (ysize) {
-		memcpy(ysize, buff, sizeof(int));
+		*ysize = CD_Get32(buff);
 	}
 	buff += sizeof(int);
 	return (char *)buff;
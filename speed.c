@@ -0,0 +1,49 @@
+#include "speed.h"
+
+#define LOCK_FRAMES (30)
+#define ARE_FRAMES (30)
+#define LINE_FRAMES (41)
+
+// from 800 on, lock delay is shorter and everything else runs at double speed
+#define FAST_LOCK_FRAMES (22)
+#define FAST_ARE_FRAMES ((ARE_FRAMES + 1) / 2)
+#define FAST_LINE_FRAMES ((LINE_FRAMES + 1) / 2)
+
+#define NORMAL(gravity) {(gravity), LOCK_FRAMES, ARE_FRAMES, LINE_FRAMES, 1}
+#define FAST(gravity) {(gravity), FAST_LOCK_FRAMES, FAST_ARE_FRAMES, FAST_LINE_FRAMES, 2}
+
+const SPEED speedCurves[SPEED_CURVE_COUNT][SPEED_LEVELS] = {
+    [SPEED_NORMAL] = {
+        [0 ... 29] = NORMAL(4),
+        [30 ... 34] = NORMAL(6),
+        [35 ... 39] = NORMAL(8),
+        [40 ... 49] = NORMAL(10),
+        [50 ... 59] = NORMAL(12),
+        [60 ... 69] = NORMAL(16),
+        [70 ... 79] = NORMAL(32),
+        [80 ... 89] = NORMAL(48),
+        [90 ... 99] = NORMAL(64),
+        [100 ... 119] = NORMAL(80),
+        [120 ... 139] = NORMAL(96),
+        [140 ... 159] = NORMAL(112),
+        [160 ... 169] = NORMAL(128),
+        [170 ... 199] = NORMAL(144),
+        [200 ... 219] = NORMAL(4),
+        [220 ... 229] = NORMAL(32),
+        [230 ... 232] = NORMAL(64),
+        [233 ... 235] = NORMAL(96),
+        [236 ... 238] = NORMAL(128),
+        [239 ... 242] = NORMAL(160),
+        [243 ... 246] = NORMAL(192),
+        [247 ... 250] = NORMAL(224),
+        [251 ... 299] = NORMAL(256),
+        [300 ... 329] = NORMAL(512),
+        [330 ... 359] = NORMAL(768),
+        [360 ... 399] = NORMAL(1024),
+        [400 ... 419] = NORMAL(1280),
+        [420 ... 449] = NORMAL(1024),
+        [450 ... 499] = NORMAL(768),
+        [500 ... 799] = NORMAL(5120),
+        [800 ... 999] = FAST(5120),
+    },
+};
@@ -0,0 +1,26 @@
+#ifndef SPEED_H
+#define SPEED_H
+
+#include <sega_mth.h>
+
+// number of levels in a speed curve
+#define SPEED_LEVELS (1000)
+
+// timings for one level
+typedef struct {
+    Uint16 gravity; // in 1/256 rows per frame
+    Uint8 lockFrames;
+    Uint8 areFrames;
+    Uint8 lineFrames;
+    Uint8 dasStep; // how much the DAS timers go down each frame
+} SPEED;
+
+typedef enum {
+    SPEED_NORMAL = 0,
+} SPEED_CURVES;
+
+#define SPEED_CURVE_COUNT (1)
+
+extern const SPEED speedCurves[SPEED_CURVE_COUNT][SPEED_LEVELS];
+
+#endif
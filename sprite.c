@@ -8,19 +8,39 @@
 
 #include "cd.h"
 #include "hwram.h"
+#include "internal.h"
 #include "scroll.h"
 #include "sprite.h"
 #include "vblank.h"
 
-int numSprites = 0;
-
 int tileCount = 0;
 int palCnt = 0;
-SPRITE_INFO sprites[SPRITE_LIST_SIZE];
+
+Fixed32 spriteX[SPRITE_POOL_SIZE];
+Fixed32 spriteY[SPRITE_POOL_SIZE];
+Uint16 spriteChar[SPRITE_POOL_SIZE];
+Uint16 spriteFlags[SPRITE_POOL_SIZE];
+SPRITE_EXTRA spriteExtras[SPRITE_POOL_SIZE];
+
+// sprites that aren't in use, taken from the end
+static Uint16 freeSprites[SPRITE_POOL_SIZE];
+static int freeCount;
+// sprites that are in use, packed at the start, and where each one is in it
+static Uint16 activeSprites[SPRITE_POOL_SIZE];
+static Uint16 activePos[SPRITE_POOL_SIZE];
+static int activeCount;
+
+// sprites deleted while Sprite_DrawAll is running iterate functions wait
+// here, so the active list doesn't change under it
+#define SPRITE_DELETED (1 << 15)
+static int iterating = 0;
+static Uint16 deletedSprites[SPRITE_POOL_SIZE];
+static int deletedCount;
+
 //normalize diagonal speed
 #define DIAGONAL_MULTIPLIER (MTH_FIXED(0.8))
 
-#define CommandMax    300
+#define CommandMax    (SPRITE_POOL_SIZE + 300) // room for a full pool on top of the other sprites
 #define GourTblMax    300
 #define LookupTblMax  100
 #define CharMax       256 //CHANGE WHEN YOU INCREASE TILES BEYOND THIS POINT
@@ -51,9 +71,8 @@ void Sprite_Clear() {
 	SPR_2ClrAllChar();
 }
 
-static int Sprite_LoadPal(Uint8 *buffer, int *count) {
-	Sint32 numPals;
-	memcpy(&numPals, buffer, sizeof(numPals));
+INTERNAL int Sprite_LoadPal(Uint8 *buffer, int *count) {
+	Sint32 numPals = CD_Get32(buffer);
 	buffer += sizeof(numPals);
 
 	// load all the palettes
@@ -63,8 +82,7 @@ static int Sprite_LoadPal(Uint8 *buffer, int *count) {
 	}
 
 	// first 4 bytes after palettes is the number of sprites
-	Sint32 numSprites;
-	memcpy(&numSprites, buffer, sizeof(numSprites));
+	Sint32 numSprites = CD_Get32(buffer);
 	buffer += sizeof(numSprites);
 
 	// load all the sprites
@@ -72,12 +90,11 @@ static int Sprite_LoadPal(Uint8 *buffer, int *count) {
 	Sint32 spriteY;
 	Sint32 spritePal;
 	for (int i = 0; i < numSprites; i++) {
-		memcpy(&spriteX, buffer, sizeof(spriteX));
+		spriteX = CD_Get32(buffer);
 		buffer += sizeof(spriteX);
-		memcpy(&spriteY, buffer, sizeof(spriteY));
+		spriteY = CD_Get32(buffer);
         buffer += sizeof(spriteY);
-		memcpy(&spritePal, buffer, sizeof(spritePal));
-		spritePal = (spritePal * 16) + palCnt;
+		spritePal = (CD_Get32(buffer) * 16) + palCnt;
 		buffer += sizeof(spritePal);
 		SPR_2SetChar((Uint16)(i + tileCount), COLOR_0, (Uint16)(spritePal),
 		  (Uint16)spriteX, (Uint16)spriteY, buffer);
@@ -92,19 +109,18 @@ static int Sprite_LoadPal(Uint8 *buffer, int *count) {
 	return sprite_tilebak;
 }
 
-static int Sprite_LoadRGB(Uint8 *buffer, int *count) {
+INTERNAL int Sprite_LoadRGB(Uint8 *buffer, int *count) {
 	// first 4 bytes is the number of sprites
-	Sint32 numSprites;
-	memcpy(&numSprites, buffer, sizeof(numSprites));
+	Sint32 numSprites = CD_Get32(buffer);
 	buffer += sizeof(numSprites);
 
 	// load all the sprites
 	Sint32 spriteX;
 	Sint32 spriteY;
 	for (int i = 0; i < numSprites; i++) {
-		memcpy(&spriteX, buffer, sizeof(spriteX));
+		spriteX = CD_Get32(buffer);
 		buffer += sizeof(spriteX);
-		memcpy(&spriteY, buffer, sizeof(spriteY));
+		spriteY = CD_Get32(buffer);
 		buffer += sizeof(spriteY);
 		SPR_2SetChar((Uint16)(i + tileCount), COLOR_5, 0,
 		  (Uint16)spriteX, (Uint16)spriteY, buffer);
@@ -120,9 +136,8 @@ static int Sprite_LoadRGB(Uint8 *buffer, int *count) {
 
 int Sprite_Load(char *filename, int *count) {
 	CD_Load(filename, HWRAM_Buffer);
-    Sint32 type;
+    Sint32 type = CD_Get32(HWRAM_Buffer);
 
-    memcpy(&type, HWRAM_Buffer, sizeof(type));
     if (type == 0) {
         return Sprite_LoadPal(HWRAM_Buffer + sizeof(type), count);
     }
@@ -186,7 +201,6 @@ void Sprite_Draw(SPRITE_INFO *info) {
 }
 
 void Sprite_Make(int tileNum, Fixed32 x, Fixed32 y, SPRITE_INFO *ptr) {
-	ptr->display = 1;
 	ptr->charNum = tileNum;
 	ptr->x = x;
 	ptr->y = y;
@@ -195,71 +209,171 @@ void Sprite_Make(int tileNum, Fixed32 x, Fixed32 y, SPRITE_INFO *ptr) {
 	ptr->mirror = 0;
 	ptr->scale = MTH_FIXED(1);
 	ptr->angle = 0;
-	ptr->prev = NULL;
-	ptr->next = NULL;
-	ptr->iterate = NULL;
+}
+
+// returns 1 if the sprite is in use
+static inline int Sprite_Live(int sprite) {
+	int pos = activePos[sprite];
+	return (pos < activeCount) && (activeSprites[pos] == sprite);
+}
+
+// takes the sprite out of the active list (the last one moves into its place)
+// and puts it back in the pool
+static void Sprite_Free(int sprite) {
+	int pos = activePos[sprite];
+	int last = activeSprites[--activeCount];
+
+	activeSprites[pos] = last;
+	activePos[last] = pos;
+	spriteFlags[sprite] = 0;
+	freeSprites[freeCount++] = sprite;
 }
 
 void Sprite_DrawAll() {
-	for (int i = 0; i < SPRITE_LIST_SIZE; i++) {
-		if (sprites[i].display) {
-			if (sprites[i].iterate != NULL) {
-				sprites[i].iterate(&sprites[i]);
-			}
-			//check again because iterate function may have deleted sprite
-			if (sprites[i].display) {
-				Sprite_Draw(&sprites[i]);
-			}
+	XyInt xy;
+
+	// sprites made by iterate functions start next frame
+	int count = activeCount;
+	iterating = 1;
+	for (int i = 0; i < count; i++) {
+		int sprite = activeSprites[i];
+		if ((spriteFlags[sprite] & (SPRITE_ITERATES | SPRITE_DELETED)) == SPRITE_ITERATES) {
+			spriteExtras[sprite].iterate(sprite);
 		}
 	}
-}
+	iterating = 0;
+	for (int i = 0; i < deletedCount; i++) {
+		Sprite_Free(deletedSprites[i]);
+	}
+	deletedCount = 0;
+
+	for (int i = 0; i < activeCount; i++) {
+		int sprite = activeSprites[i];
+		Uint16 flags = spriteFlags[sprite];
 
-SPRITE_INFO *Sprite_Next() {
-	int i;
-	for (i = 0; i < SPRITE_LIST_SIZE; i++) {
-		if (!sprites[i].display) {
-			numSprites++;
-			sprites[i].index = i;
-			sprites[i].iterate = NULL;
-			return &sprites[i];
+		if (!(flags & SPRITE_TRANSFORMED)) {
+			xy.x = (Sint16)MTH_FixedToInt(spriteX[sprite]);
+			xy.y = (Sint16)MTH_FixedToInt(spriteY[sprite]);
+			SPR_2NormSpr(0, flags & (MIRROR_HORIZ | MIRROR_VERT), COLOR_5 | ENDCODE_DISABLE, 0,
+				spriteChar[sprite], &xy, NO_GOUR);
+		}
+		else {
+			SPRITE_EXTRA *extra = &spriteExtras[sprite];
+			SPRITE_INFO info;
+			info.charNum = spriteChar[sprite];
+			info.x = spriteX[sprite];
+			info.y = spriteY[sprite];
+			info.xSize = extra->xSize;
+			info.ySize = extra->ySize;
+			info.scale = extra->scale;
+			info.angle = extra->angle;
+			info.mirror = flags & (MIRROR_HORIZ | MIRROR_VERT);
+			Sprite_Draw(&info);
 		}
 	}
-	return NULL;
 }
 
-void Sprite_ListAdd(SPRITE_INFO **head, SPRITE_INFO *sprite) {
-	sprite->next = *head;
-	sprite->prev = NULL;
-	if (*head != NULL) {
-		(*head)->prev = sprite;
+int Sprite_Next() {
+	if (freeCount == 0) {
+		return SPRITE_NONE;
+	}
+
+	int sprite = freeSprites[--freeCount];
+	activePos[sprite] = activeCount;
+	activeSprites[activeCount++] = sprite;
+
+	spriteX[sprite] = 0;
+	spriteY[sprite] = 0;
+	spriteChar[sprite] = 0;
+	spriteFlags[sprite] = 0;
+	SPRITE_EXTRA *extra = &spriteExtras[sprite];
+	extra->xSize = 0;
+	extra->ySize = 0;
+	extra->scale = MTH_FIXED(1);
+	extra->angle = 0;
+	extra->prev = SPRITE_NONE;
+	extra->next = SPRITE_NONE;
+	extra->iterate = NULL;
+	return sprite;
+}
+
+void Sprite_Transform(int sprite, Fixed32 xSize, Fixed32 ySize, Fixed32 scale, Fixed32 angle) {
+	SPRITE_EXTRA *extra = &spriteExtras[sprite];
+
+	extra->xSize = xSize;
+	extra->ySize = ySize;
+	extra->scale = scale;
+	extra->angle = angle;
+	if ((scale != MTH_FIXED(1)) || (angle != 0)) {
+		spriteFlags[sprite] |= SPRITE_TRANSFORMED;
+	}
+	else {
+		spriteFlags[sprite] &= ~SPRITE_TRANSFORMED;
+	}
+}
+
+void Sprite_SetIterate(int sprite, IterateFunc iterate) {
+	spriteExtras[sprite].iterate = iterate;
+	if (iterate != NULL) {
+		spriteFlags[sprite] |= SPRITE_ITERATES;
+	}
+	else {
+		spriteFlags[sprite] &= ~SPRITE_ITERATES;
+	}
+}
+
+void Sprite_ListAdd(int *head, int sprite) {
+	spriteExtras[sprite].next = *head;
+	spriteExtras[sprite].prev = SPRITE_NONE;
+	if (*head != SPRITE_NONE) {
+		spriteExtras[*head].prev = sprite;
 	}
 	*head = sprite;
 }
 
-void Sprite_ListRemove(SPRITE_INFO **head, SPRITE_INFO *sprite) {
+void Sprite_ListRemove(int *head, int sprite) {
+	SPRITE_EXTRA *extra = &spriteExtras[sprite];
+
 	if (*head == sprite) {
-		*head = sprite->next;
+		*head = extra->next;
 	}
 
-	if (sprite->next != NULL) {
-		sprite->next->prev = sprite->prev;
+	if (extra->next != SPRITE_NONE) {
+		spriteExtras[extra->next].prev = extra->prev;
 	}
 
-	if (sprite->prev != NULL) {
-		sprite->prev->next = sprite->next;
+	if (extra->prev != SPRITE_NONE) {
+		spriteExtras[extra->prev].next = extra->next;
 	}
 }
 
-void Sprite_Delete(SPRITE_INFO *sprite) {
-	sprite->display = 0;
-	sprite->iterate = NULL;
-	numSprites--;
+void Sprite_Delete(int sprite) {
+	// already back in the pool, or waiting to go back
+	if (!Sprite_Live(sprite) || (spriteFlags[sprite] & SPRITE_DELETED)) {
+		return;
+	}
+	if (iterating) {
+		spriteFlags[sprite] |= SPRITE_DELETED;
+		deletedSprites[deletedCount++] = sprite;
+		return;
+	}
+	Sprite_Free(sprite);
 }
 
 void Sprite_DeleteAll() {
-	for (int i = 0; i < SPRITE_LIST_SIZE; i++) {
-		sprites[i].display = 0;
+	if (iterating) {
+		for (int i = 0; i < activeCount; i++) {
+			Sprite_Delete(activeSprites[i]);
+		}
+		return;
 	}
-	numSprites = 0;
-}
 
+	// hand them out lowest first
+	for (int i = 0; i < SPRITE_POOL_SIZE; i++) {
+		freeSprites[i] = SPRITE_POOL_SIZE - 1 - i;
+		spriteFlags[i] = 0;
+	}
+	freeCount = SPRITE_POOL_SIZE;
+	activeCount = 0;
+	deletedCount = 0;
+}
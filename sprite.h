@@ -7,17 +7,8 @@
 #define MIRROR_HORIZ (1 << 4)
 #define MIRROR_VERT (1 << 5)
 
-struct SpriteInfo;
-typedef struct SpriteInfo SPRITE_INFO;
-
-typedef void (*IterateFunc)(SPRITE_INFO *);
-
-#define SPRITE_DATA_SIZE (12)
-
-typedef struct SpriteInfo {
-	Uint16 display;
+typedef struct {
 	Uint16 charNum; //tile number
-	Uint16 index; //where the sprite is in the sprites array
 	Fixed32 x;
 	Fixed32 y;
 	Fixed32 xSize;
@@ -25,14 +16,40 @@ typedef struct SpriteInfo {
 	Fixed32 scale;
 	Fixed32 angle;
 	Uint16 mirror;
-	SPRITE_INFO *prev; // for iterating through a certain type of sprite
-	SPRITE_INFO *next;
-	Uint8 data[SPRITE_DATA_SIZE] __attribute__((aligned(4)));
-	IterateFunc iterate;
 } SPRITE_INFO;
 
-#define SPRITE_LIST_SIZE (80)
-extern SPRITE_INFO sprites[];
+// pooled sprites, which Sprite_DrawAll draws every frame. each one is
+// referred to by its index into the arrays below. the fields drawing reads
+// for every sprite have arrays of their own, and everything else is in
+// spriteExtras, which only gets read for sprites that need it
+#define SPRITE_POOL_SIZE (512)
+#define SPRITE_NONE (-1)
+#define SPRITE_DATA_SIZE (12)
+
+// spriteFlags bits, along with MIRROR_HORIZ and MIRROR_VERT
+// scaled or rotated (see Sprite_Transform)
+#define SPRITE_TRANSFORMED (1 << 0)
+// has an iterate function
+#define SPRITE_ITERATES (1 << 1)
+
+typedef void (*IterateFunc)(int sprite);
+
+typedef struct {
+	Fixed32 xSize;
+	Fixed32 ySize;
+	Fixed32 scale;
+	Fixed32 angle;
+	int prev; // for iterating through a certain type of sprite
+	int next;
+	IterateFunc iterate; // called every frame before the sprite is drawn
+	Uint8 data[SPRITE_DATA_SIZE] __attribute__((aligned(4)));
+} SPRITE_EXTRA;
+
+extern Fixed32 spriteX[];
+extern Fixed32 spriteY[];
+extern Uint16 spriteChar[];
+extern Uint16 spriteFlags[];
+extern SPRITE_EXTRA spriteExtras[];
 
 //sets up initial sprite display
 void Sprite_Init(void);
@@ -51,17 +68,26 @@ void Sprite_StartDraw(void);
 void Sprite_Draw(SPRITE_INFO *info);
 //inits the SPRITE_INFO pointer given
 void Sprite_Make(int tile_num, Fixed32 x, Fixed32 y, SPRITE_INFO *ptr);
-//draws all sprites in the sprite list
+// runs the iterate functions of the pooled sprites, then draws them. they're
+// drawn in the order they're kept in, which changes when one gets deleted
+// (the last one takes its place), so sprites that have to stay on top of
+// others should be drawn with Sprite_Draw instead
 void Sprite_DrawAll(void);
-//gets a pointer to the next sprite in the list
-SPRITE_INFO *Sprite_Next(void);
+// takes a sprite out of the pool (with tile 0 at 0, 0 and nothing else set),
+// returns SPRITE_NONE if they're all in use
+int Sprite_Next(void);
+// sets how big the sprite is and how it's scaled & rotated
+void Sprite_Transform(int sprite, Fixed32 xSize, Fixed32 ySize, Fixed32 scale, Fixed32 angle);
+// sets the function run on the sprite every frame (NULL for none)
+void Sprite_SetIterate(int sprite, IterateFunc iterate);
 // adds the sprite to a doubly linked list
-void Sprite_ListAdd(SPRITE_INFO **head, SPRITE_INFO *sprite);
+void Sprite_ListAdd(int *head, int sprite);
 // removes the sprite from a doubly linked list
-void Sprite_ListRemove(SPRITE_INFO **head, SPRITE_INFO *sprite);
-//deletes the given sprite from the sprite list
-void Sprite_Delete(SPRITE_INFO *sprite);
-//deletes all sprites from the list
+void Sprite_ListRemove(int *head, int sprite);
+// puts the sprite back in the pool. iterate functions can delete sprites,
+// including their own
+void Sprite_Delete(int sprite);
+// puts all the sprites back in the pool
 void Sprite_DeleteAll(void);
 
 #endif
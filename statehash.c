@@ -0,0 +1,122 @@
+#include <string.h>
+
+#include "replayfmt.h"
+#include "statehash.h"
+
+// FNV-1a over 32 bit words instead of bytes, with a shift after each multiply
+// so the high bits feed back into the low ones. it only has to spot the
+// Saturn and the host going different ways, and this keeps it to a multiply,
+// a shift and two XORs per word. that's under a thousand cycles for the whole
+// state on the SH-2 (the shift by 15 takes a few instructions there), against
+// about 470000 in a frame
+#define HASH_START (2166136261u)
+#define HASH_MULT (16777619u)
+
+static inline Uint32 StateHash_Mix(Uint32 hash, Uint32 val) {
+    hash = (hash ^ val) * HASH_MULT;
+    return hash ^ (hash >> 15);
+}
+
+static inline Uint32 StateHash_Piece(Uint32 hash, PIECE *piece) {
+    hash = StateHash_Mix(hash, (Uint32)piece->x);
+    hash = StateHash_Mix(hash, (Uint32)piece->y);
+    return StateHash_Mix(hash, (piece->num << 8) | piece->rotation);
+}
+
+Uint32 StateHash_Get(GAME_CTX *ctx) {
+    Uint32 hash = HASH_START;
+    RNG_STATE *rng = &ctx->rng;
+
+    // the padding rows never change, so only the playfield's rows go in (two
+    // to a word)
+    for (int y = 0; y < GAME_ROWS; y += 2) {
+        hash = StateHash_Mix(hash, ((Uint32)BOARD_ROW(ctx, y) << 16) | BOARD_ROW(ctx, y + 1));
+    }
+    hash = StateHash_Piece(hash, &ctx->currPiece);
+    hash = StateHash_Piece(hash, &ctx->nextPiece);
+
+    hash = StateHash_Mix(hash, (Uint32)(rng->state >> 32));
+    hash = StateHash_Mix(hash, (Uint32)rng->state);
+    hash = StateHash_Mix(hash, (Uint32)rng->inc);
+    hash = StateHash_Mix(hash, ((Uint32)rng->history[0] << 24) | (rng->history[1] << 16) |
+        (rng->history[2] << 8) | rng->history[3]);
+    hash = StateHash_Mix(hash, (rng->historyMask << 8) | rng->first);
+    hash = StateHash_Mix(hash, (Uint32)(ctx->garbageRng.state >> 32));
+    hash = StateHash_Mix(hash, (Uint32)ctx->garbageRng.state);
+
+    hash = StateHash_Mix(hash, (ctx->rotationSystem << 16) | ctx->speedCurve);
+    hash = StateHash_Mix(hash, (ctx->state << 16) | ctx->prevState);
+    hash = StateHash_Mix(hash, (Uint32)ctx->timer);
+    hash = StateHash_Mix(hash, (Uint32)ctx->score);
+    hash = StateHash_Mix(hash, (Uint32)ctx->drop);
+    hash = StateHash_Mix(hash, (Uint32)ctx->combo);
+    hash = StateHash_Mix(hash, (Uint32)ctx->level);
+    hash = StateHash_Mix(hash, (ctx->ranking << 16) | ctx->finalRank);
+    hash = StateHash_Mix(hash, (ctx->song << 16) | ctx->bg);
+    hash = StateHash_Mix(hash, (Uint32)ctx->leftTimer);
+    hash = StateHash_Mix(hash, (Uint32)ctx->rightTimer);
+    hash = StateHash_Mix(hash, (Uint32)ctx->downTimer);
+    hash = StateHash_Mix(hash, (Uint32)ctx->lockTimer);
+    hash = StateHash_Mix(hash, (Uint32)ctx->gravityTimer);
+    hash = StateHash_Mix(hash, (Uint32)ctx->gameOverRow);
+    hash = StateHash_Mix(hash, ctx->clearedRows);
+    hash = StateHash_Mix(hash, ((Uint32)ctx->prevHeld << 16) | (ctx->garbageIn << 8) | ctx->garbageOut);
+    return hash;
+}
+
+void StateHash_Start(STATEHASH_LOG *log, Uint8 *buf, int size, uint64_t seed) {
+    log->buf = buf;
+    log->size = size;
+    log->count = 0;
+    log->ticks = 0;
+    log->stop = STATEHASH_LOGGING;
+
+    memcpy(buf, STATEHASH_MAGIC, 4);
+    ReplayFmt_Put32(buf + 4, (Uint32)(seed >> 32));
+    ReplayFmt_Put32(buf + 8, (Uint32)seed);
+    ReplayFmt_Put32(buf + 12, 0);
+    ReplayFmt_Put32(buf + 16, STATEHASH_LOGGING);
+}
+
+void StateHash_Record(STATEHASH_LOG *log, Uint32 hash) {
+    int pos = STATEHASH_HEADER_SIZE + (log->count * 4);
+
+    log->ticks++;
+    if (log->stop) {
+        return;
+    }
+    if ((pos + 4) > log->size) {
+        StateHash_Stop(log, STATEHASH_STOP_FULL);
+        return;
+    }
+    ReplayFmt_Put32(log->buf + pos, hash);
+    log->count++;
+    ReplayFmt_Put32(log->buf + 12, log->count);
+}
+
+void StateHash_Stop(STATEHASH_LOG *log, int reason) {
+    if (!log->stop) {
+        log->stop = reason;
+        ReplayFmt_Put32(log->buf + 16, reason);
+    }
+}
+
+static char *StateHash_Hex(char *cursor, Uint32 val) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        *cursor++ = digits[(val >> shift) & 0xF];
+    }
+    return cursor;
+}
+
+void StateHash_Format(char *line, Uint32 tick, Uint32 hash) {
+    char *cursor = line;
+
+    *cursor++ = 'H';
+    *cursor++ = ' ';
+    cursor = StateHash_Hex(cursor, tick);
+    *cursor++ = ' ';
+    cursor = StateHash_Hex(cursor, hash);
+    *cursor = '\0';
+}
@@ -0,0 +1,60 @@
+#ifndef STATEHASH_H
+#define STATEHASH_H
+
+#include <stdint.h>
+#include <sega_mth.h>
+
+#include "game.h"
+
+// hash log layout (big endian), written to memory as the game runs so it can
+// be dumped from an emulator at any point:
+//   0  magic "GMH1"
+//   4  RNG seed (64 bit), same as the replay's
+//   12 number of hashes
+//   16 why the log stopped before the game did (STATEHASH_LOGGING if it
+//      hasn't)
+//   20 one 32 bit hash per tick, taken after the tick
+// at 4 bytes a tick the log only covers the start of a long game (the 0x20000
+// bytes play.c gives it last about 9 minutes). once it's full, the hashes only
+// go out over the devcart, with HASH_PRINT on
+#define STATEHASH_MAGIC "GMH1"
+#define STATEHASH_HEADER_SIZE (20)
+
+#define STATEHASH_LOGGING (0)
+// no room for more hashes
+#define STATEHASH_STOP_FULL (1)
+// the game was rewound, so later hashes wouldn't match the replay
+#define STATEHASH_STOP_REWOUND (2)
+
+// longest line StateHash_Format writes (including the terminator)
+#define STATEHASH_LINE_LEN (20)
+
+typedef struct {
+    Uint8 *buf;
+    int size; // size of buf
+    Uint32 count; // hashes written so far
+    Uint32 ticks; // hashes recorded so far, including those that didn't fit
+    int stop; // STATEHASH_STOP_* once the log stopped
+} STATEHASH_LOG;
+
+// hashes everything a tick depends on or changes. the fields are hashed by
+// value rather than as memory, so the Saturn and the host get the same hash
+// for the same state whatever their byte order and struct padding. the parts
+// that are only there for the frontend (block colors, dirty rows, sounds and
+// events) are left out
+Uint32 StateHash_Get(GAME_CTX *ctx);
+
+// starts a log for a game started with Replay_Reset's seed
+void StateHash_Start(STATEHASH_LOG *log, Uint8 *buf, int size, uint64_t seed);
+
+// adds a tick's hash to the log. the header is kept up to date so the log can
+// be read at any time
+void StateHash_Record(STATEHASH_LOG *log, Uint32 hash);
+
+// stops the log for good, and notes why in the header
+void StateHash_Stop(STATEHASH_LOG *log, int reason);
+
+// writes "H tick hash" (both in hex) for the devcart print channel
+void StateHash_Format(char *line, Uint32 tick, Uint32 hash);
+
+#endif
@@ -6,6 +6,7 @@
 #include "scroll.h"
 #include "sound.h"
 #include "sprite.h"
+#include "title.h"
 #include "vblank.h"
 
 static Uint8 *logoGfx;
@@ -50,6 +51,13 @@ static int startNum;
 #define START_YPOS (150)
 static XyInt startXy;
 
+// bit n is set once controller n has pressed a button to join versus
+static int joined;
+// frames the title text stays up with nobody pressing anything before the
+// demo starts
+#define DEMO_FRAMES (60 * 20)
+static int demo;
+
 void Title_Init() {
     black.red = -255; black.green = -255; black.blue = -255;
     normal.red = 0; normal.green = 0; normal.blue = 0;
@@ -93,6 +101,8 @@ void Title_Init() {
     SCL_SetAutoColOffset(SCL_OFFSET_A, 1, FADE_FRAMES, &black, &normal);
     titleState = STATE_LOGO_FADEIN;
     frames = 0;
+    joined = 0;
+    demo = 0;
 }
 
 int Title_Run() {
@@ -177,12 +187,26 @@ int Title_Run() {
                 SPR_2NormSpr(0, 0, COLOR_5 | ENDCODE_DISABLE, 0, startNum, &startXy, NO_GOUR);
             }
 
+            // the other controllers join by pressing a button before the first
+            // one starts the game
+            for (int i = 1; i < PAD_MAX; i++) {
+                if (PadDataE[i]) {
+                    joined |= (1 << i);
+                }
+            }
+
             // starting the game
             if (PadData1) {
                 frames = 0;
                 SCL_SetAutoColOffset(SCL_OFFSET_A, 1, FADE_FRAMES, &normal, &black);
                 titleState = STATE_TITLE_FADEOUT;
             }
+            else if ((frames >= DEMO_FRAMES) && !joined) {
+                frames = 0;
+                demo = 1;
+                SCL_SetAutoColOffset(SCL_OFFSET_A, 1, FADE_FRAMES, &normal, &black);
+                titleState = STATE_TITLE_FADEOUT;
+            }
             break;
 
         case STATE_TITLE_FADEOUT:
@@ -190,7 +214,7 @@ int Title_Run() {
             if (frames >= SHOW_FRAMES) {
                 Sprite_Clear();
                 Print_Load();
-                return 1;
+                return demo ? TITLE_DEMO : (joined | 1);
             }
             break;
     }
@@ -4,7 +4,13 @@
 // set up title graphics
 void Title_Init();
 
-// should be run every frame the title is displayed
+// returned by Title_Run when nobody's pressed anything for a while, and the
+// attract mode demo should play
+#define TITLE_DEMO (-1)
+
+// should be run every frame the title is displayed. returns 0 until the game
+// starts, then a mask of the controllers playing (bit 0 is always set) or
+// TITLE_DEMO
 int Title_Run();
 
 #endif
@@ -31,13 +31,11 @@ typedef	struct {
 	Uint8	al;
 } AnalogPadData;
 
-volatile Uint16	PadData1  = 0x0000;
-volatile Uint16	PadData1L = 0x0000;
-volatile Uint16	PadData1E = 0x0000;
-volatile Uint16	PadData2  = 0x0000;
-volatile Uint16	PadData2L = 0x0000;
-volatile Uint16	PadData2E = 0x0000;
-Uint32	PadWorkArea[7];
+volatile Uint16	PadData[PAD_MAX];
+volatile Uint16	PadDataL[PAD_MAX];
+volatile Uint16	PadDataE[PAD_MAX];
+// room for every pad on a multitap
+Uint32	PadWorkArea[PAD_MAX * 4];
 
 volatile Sint32 perFlag;
 volatile Sint32 VblankFlg;
@@ -60,7 +58,7 @@ void SetVblank(void) {
 	perFlag = 1;
 	while (perFlag);
     
-	PER_Init(PER_KD_PERTIM, 2, PER_ID_DGT, PER_SIZE_DGT, PadWorkArea, 0);
+	PER_Init(PER_KD_PERTIM, PAD_MAX, PER_ID_DGT, PER_SIZE_DGT, PadWorkArea, 0);
 
 	// Register vblank routine
 	INT_ChgMsk(INT_MSK_NULL, INT_MSK_VBLK_IN | INT_MSK_VBLK_OUT);
@@ -85,13 +83,12 @@ void UsrVblankOut(void) {
 	PerDgtInfo *pad;
 	PER_GetPer((PerGetPer **)&pad);
 	if (pad != NULL) {
-		PadData1L = PadData1;
-		PadData2L = PadData2;
-
-		PadData1  = pad[0].data ^ 0xffff;
-		PadData1E = (PadData1L ^ ALL_BUTTONS) & PadData1;
-		PadData2  = pad[1].data ^ 0xffff;
-		PadData2E = (PadData2L ^ ALL_BUTTONS) & PadData2;
+		// pads that aren't plugged in read as nothing held
+		for (int i = 0; i < PAD_MAX; i++) {
+			PadDataL[i] = PadData[i];
+			PadData[i]  = pad[i].data ^ 0xffff;
+			PadDataE[i] = (PadDataL[i] ^ ALL_BUTTONS) & PadData[i];
+		}
 	}
 	VblankFlg = 0;
 	vblank_frames++;
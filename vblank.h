@@ -5,10 +5,14 @@
 
 extern void  SetVblank(void);
 
-extern volatile Uint16  PadData1;
-extern volatile Uint16  PadData1E;
-extern volatile Uint16  PadData2;
-extern volatile Uint16  PadData2E;
+// controllers read each vblank (up to 6 through a multitap)
+#define PAD_MAX (6)
+extern volatile Uint16  PadData[PAD_MAX];
+extern volatile Uint16  PadDataE[PAD_MAX];
+#define PadData1 (PadData[0])
+#define PadData1E (PadDataE[0])
+#define PadData2 (PadData[1])
+#define PadData2E (PadDataE[1])
 extern volatile Sint32  VblankFlg;
 extern volatile int vblank_frames;
 